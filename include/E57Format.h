@@ -33,6 +33,7 @@
 
 #include <cfloat>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -190,6 +191,29 @@ namespace e57
    [[deprecated( "Will be removed in 4.0. Use e57::VERSION_1_0_URI." )]] // TODO Remove in 4.0
    constexpr auto E57_V1_0_URI = VERSION_1_0_URI;
 
+   /// @brief The URI of the delta codec extension's XML namespace
+   /// @details The delta codec stores each value of an Integer or ScaledInteger field as the
+   /// difference from the one before it, which takes far fewer bits for slowly changing fields
+   /// such as row and column indices. To use it, declare the namespace with
+   /// ImageFile::extensionsAdd() and give the CompressedVectorNode a codecs entry such as:
+   /// @code
+   /// imf.extensionsAdd( "dlt", e57::DELTA_CODEC_URI );
+   ///
+   /// VectorNode inputs( imf, false );
+   /// inputs.append( StringNode( imf, "rowIndex" ) );
+   ///
+   /// StructureNode codec( imf );
+   /// codec.set( "inputs", inputs );
+   /// codec.set( "dlt:deltaCodec", StructureNode( imf ) );
+   ///
+   /// VectorNode codecs( imf, true );
+   /// codecs.append( codec );
+   /// @endcode
+   /// Readers which don't know the extension should reject these fields, as they would any
+   /// codec they don't implement, rather than read them as bitPackCodec.
+   /// @note Like VERSION_1_0_URI, this is only a name and doesn't point to a document.
+   constexpr char DELTA_CODEC_URI[] = "https://github.com/asmaloney/libE57Format#delta-codec";
+
    /// @cond documentNonPublic   The following aren't documented
    // Minimum and maximum values for integers
    constexpr uint8_t UINT8_MIN = 0U;
@@ -363,6 +387,34 @@ public:
       /// @endcond
    };
 
+   /// @brief Contiguous storage for the values of a StringNode field
+   /// @details An alternative to std::vector<ustring> for a SourceDestBuffer. The strings of a
+   /// block are stored back to back in #data, so reading them doesn't need a heap allocation per
+   /// record. String i is the #lengths[i] bytes starting at #offsets[i].
+   struct E57_DLL StringArena
+   {
+      /// Bytes of all the strings, back to back and not null terminated
+      std::vector<char> data;
+
+      /// Offset of each string in #data
+      std::vector<size_t> offsets;
+
+      /// Length of each string in bytes
+      std::vector<size_t> lengths;
+
+      /// Pointer to the first byte of string i
+      const char *stringData( size_t i ) const
+      {
+         return data.data() + offsets[i];
+      }
+
+      /// Copy of string i
+      ustring stringAt( size_t i ) const
+      {
+         return ustring( stringData( i ), lengths[i] );
+      }
+   };
+
    class E57_DLL SourceDestBuffer
    {
    public:
@@ -399,6 +451,8 @@ public:
                         size_t stride = sizeof( double ) );
       SourceDestBuffer( const ImageFile &destImageFile, const ustring &pathName,
                         std::vector<ustring> *b );
+      SourceDestBuffer( const ImageFile &destImageFile, const ustring &pathName, StringArena *b,
+                        size_t capacity );
 
       ustring pathName() const;
       enum MemoryRepresentation memoryRepresentation() const;
@@ -412,6 +466,11 @@ public:
       void checkInvariant( bool doRecurse = true ) const;
 
       /// @cond documentNonPublic The following isn't part of the API, and isn't documented.
+   private:
+      friend class CompressedVectorWriterImpl;
+
+      explicit SourceDestBuffer( std::shared_ptr<SourceDestBufferImpl> ni );
+
       E57_INTERNAL_ACCESS( SourceDestBuffer )
 
    protected:
@@ -419,6 +478,127 @@ public:
       /// @endcond
    };
 
+   /// @brief Comparisons a RecordFilter can apply to a field value
+   enum FilterComparison
+   {
+      FilterEqual = 1,        ///< field == value
+      FilterNotEqual = 2,     ///< field != value
+      FilterLess = 3,         ///< field < value
+      FilterLessEqual = 4,    ///< field <= value
+      FilterGreater = 5,      ///< field > value
+      FilterGreaterEqual = 6  ///< field >= value
+   };
+
+   /// @brief A simple predicate on one field, applied while reading a CompressedVectorNode
+   /// @details The field value is compared as it appears in the destination buffer (i.e. after any
+   /// conversion or scaling requested for that buffer). Values in integer buffers are compared
+   /// exactly, even beyond the 53 bits a double holds.
+   struct E57_DLL RecordFilter
+   {
+      /// Path name of the field to test. Must be the path name of one of the numeric destination
+      /// buffers given to the reader.
+      ustring pathName;
+
+      /// How to compare the field to #value
+      FilterComparison comparison = FilterEqual;
+
+      /// The value to compare the field against
+      double value = 0.0;
+   };
+
+   /// @brief Options to CompressedVectorNode::reader()
+   struct E57_DLL CompressedVectorReaderOptions
+   {
+      /// Only transfer every Nth record to the destination buffers. The default (1) transfers
+      /// every record. Skipped records are never decoded.
+      uint64_t decimation = 1;
+
+      /// Only decode every Nth data packet and skip reading the others (only their headers are
+      /// read). The default (1) reads every packet. This gives a quick, coarse preview of the data
+      /// at a fraction of the I/O cost. Each decoded packet contributes the run of records it
+      /// fully contains for all fields. Not supported if any of the fields read are strings or
+      /// are stored with the delta codec (see e57::DELTA_CODEC_URI).
+      uint64_t packetStride = 1;
+
+      /// Only transfer records which pass all of these filters. Records which fail are dropped
+      /// as they are decoded, so each read() fills the destination buffers with passing records
+      /// only.
+      std::vector<RecordFilter> filters;
+
+      /// If not empty, convert each point read from the "sphericalRange", "sphericalAzimuth" and
+      /// "sphericalElevation" fields to cartesian coordinates and store it in these buffers. They
+      /// must be three floating point buffers named "cartesianX", "cartesianY" and "cartesianZ"
+      /// with the same capacity as the buffers given to the reader. These fields must not be in
+      /// the prototype. The spherical fields must be read into floating point buffers.
+      std::vector<SourceDestBuffer> cartesianFromSpherical;
+
+      /// If true, transform each point read from the "cartesianX", "cartesianY" and "cartesianZ"
+      /// fields by rotating it by #cartesianRotation and then adding #cartesianTranslation (e.g. to
+      /// apply a scan's pose while reading). All three fields must be read into floating point
+      /// buffers. Filters see the transformed values.
+      bool transformCartesian = false;
+
+      /// Unit quaternion (w, x, y, z) used when #transformCartesian is true
+      double cartesianRotation[4] = { 1.0, 0.0, 0.0, 0.0 };
+
+      /// Translation (x, y, z) used when #transformCartesian is true
+      double cartesianTranslation[3] = { 0.0, 0.0, 0.0 };
+   };
+
+   /// @brief Options to CompressedVectorNode::writer()
+   struct E57_DLL CompressedVectorWriterOptions
+   {
+      /// Number of threads used to encode the fields. With more than one, the fields going into
+      /// each data packet are encoded concurrently. The file written is identical to the one
+      /// written with a single thread. 0 uses one thread per hardware core.
+      unsigned encodeThreads = 1;
+
+      /// If not 0, CompressedVectorWriter::write() splits the records into runs of this many
+      /// (rounded up to a multiple of 64). Each run is encoded into its own data packets by its
+      /// own thread, and the runs are appended to the file in order, each with an index entry.
+      /// This scales with #encodeThreads, but packets end at run boundaries so the file differs
+      /// from one written without runs.
+      size_t chunkRecords = 0;
+
+      /// If true, data packets are written to disk by a separate thread while the next ones are
+      /// encoded. Any error writing them is thrown from a later write() or from close().
+      bool asyncWrite = false;
+
+      /// Size in bytes of the buffer each field is encoded into before it goes into data packets.
+      /// The buffer is used as a ring, so reading a packet's worth out of it doesn't move the
+      /// rest. Buffers smaller than a data packet (64 KiB) give smaller packets, since a packet is
+      /// written as soon as a field's buffer fills up. Must be at least 1024.
+      size_t encoderBufferSize = 64 * 1024;
+
+      /// If true, the smallest and largest value written to each numeric field are tracked while
+      /// the records are encoded, so they don't need a separate pass over the data. They are
+      /// available from CompressedVectorWriter::fieldRange().
+      bool collectStatistics = false;
+
+      /// If set and #collectStatistics is true, close() calls this with the range of each numeric
+      /// field written to (as given by CompressedVectorWriter::fieldRange()), so the ranges can be
+      /// kept without keeping the writer. This includes a close() done by the writer going out of
+      /// scope.
+      std::function<void( const ustring &pathName, double minimum, double maximum )>
+         fieldRangeSink;
+
+      /// Size in bytes a data packet is filled to before it is written, at most 64 KiB. No data
+      /// packet is longer than this (once rounded for #alignPacketsToPages). Smaller packets let
+      /// a reader start decoding closer to a given record and split the data into more pieces
+      /// for parallel decoding, at the cost of more packet headers. Larger ones suit reading all
+      /// of the records in one go. Packets are a multiple of 4 bytes long, and this rounded down
+      /// to one must be more than 6 bytes plus 3 per field, which is enough for the packet header
+      /// and a byte of each field.
+      size_t targetPacketSize = 48 * 1024;
+
+      /// If true, each data packet starts at the beginning of one of the file's pages (1024
+      /// bytes, of which 1020 hold data), so reading it touches as few pages as possible.
+      /// #targetPacketSize is rounded up to whole pages (at most 64 of them) and packets are
+      /// filled to exactly that, so little space is left over. The gap before a packet is filled
+      /// by an empty packet, which readers skip.
+      bool alignPacketsToPages = false;
+   };
+
    class E57_DLL CompressedVectorReader
    {
    public:
@@ -457,6 +637,7 @@ public:
       void close();
       bool isOpen();
       CompressedVectorNode compressedVectorNode() const;
+      bool fieldRange( const ustring &pathName, double &minimum, double &maximum ) const;
 
       void dump( int indent = 0, std::ostream &os = std::cout ) const;
       void checkInvariant( bool doRecurse = true );
@@ -487,7 +668,11 @@ public:
 
       // Iterators
       CompressedVectorWriter writer( std::vector<SourceDestBuffer> &sbufs );
+      CompressedVectorWriter writer( std::vector<SourceDestBuffer> &sbufs,
+                                     const CompressedVectorWriterOptions &options );
       CompressedVectorReader reader( const std::vector<SourceDestBuffer> &dbufs );
+      CompressedVectorReader reader( const std::vector<SourceDestBuffer> &dbufs,
+                                     const CompressedVectorReaderOptions &options );
 
       // Up/Down cast conversion
       operator Node() const;
@@ -632,12 +632,18 @@ namespace e57
       This constructor will also adjust the min/max fields in the data3D pointFields if
       we are using floats, and run some validation on the Data3D.
 
+      If @a sphericalToCartesian is true, the cartesianX, cartesianY, and cartesianZ
+      buffers are allocated even if the header only has spherical coordinates, and
+      Data3DPointsData_t::convertSphericalToCartesian is set so the reader fills them.
+
       @param [in] data3D Completed header which indicates the fields we are using
+      @param [in] sphericalToCartesian Allocate cartesian buffers to convert spherical
+      coordinates into when reading
 
       @throw ::ErrorValueOutOfBounds
       @throw ::ErrorInvalidNodeType
       */
-      explicit Data3DPointsData_t( e57::Data3D &data3D );
+      explicit Data3DPointsData_t( e57::Data3D &data3D, bool sphericalToCartesian = false );
 
       /// @brief Destructor will delete any memory allocated using the Data3DPointsData_t( const
       /// e57::Data3D & ) constructor
@@ -728,6 +734,14 @@ namespace e57
 
       ///@}
 
+      /// @brief Fill cartesianX, cartesianY, and cartesianZ from the spherical coordinates when
+      /// reading data which only has spherical coordinates.
+      /// @details Reader::SetUpData3DPointsData() converts the points as it reads them. The
+      /// sphericalRange, sphericalAzimuth, sphericalElevation, cartesianX, cartesianY, and
+      /// cartesianZ buffers must all be set, and the data must not have cartesian coordinates.
+      /// Use the Data3D constructor with sphericalToCartesian set to allocate them.
+      bool convertSphericalToCartesian = false;
+
    private:
       /// @brief Keeps track of whether we used the Data3D constructor or not so we can free our
       /// memory.
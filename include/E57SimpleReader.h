@@ -44,6 +44,11 @@ namespace e57
    {
       /// Set how frequently to verify the checksums (see ReadChecksumPolicy).
       ReadChecksumPolicy checksumPolicy = ChecksumAll;
+
+      /// If true, SetUpData3DPointsData() transforms cartesian points by their scan's pose
+      /// (Data3D::pose) while reading them, so they are returned in the file-level coordinate
+      /// system. This does not change the header values returned by ReadData3D().
+      bool applyPose = false;
    };
 
    /// @brief Used for reading an E57 file using E57 Simple API.
@@ -181,6 +186,23 @@ namespace e57
       CompressedVectorReader SetUpData3DPointsData( int64_t dataIndex, size_t pointCount,
                                                     const Data3DPointsDouble &buffers ) const;
 
+      /// @brief Use this to read the actual 3D data with extra read options
+      /// @details Same as SetUpData3DPointsData() except for the options. For example, setting
+      /// readOptions.decimation to N will only transfer every Nth point to the buffers.
+      /// @param [in] dataIndex data block index
+      /// @param [in] pointCount size of each element buffer.
+      /// @param [in] buffers pointers to user-provided buffers
+      /// @param [in] readOptions options controlling which points are transferred
+      /// @return vector reader setup to read the selected data into the provided buffers
+      CompressedVectorReader SetUpData3DPointsData(
+         int64_t dataIndex, size_t pointCount, const Data3DPointsFloat &buffers,
+         const CompressedVectorReaderOptions &readOptions ) const;
+
+      /// @overload
+      CompressedVectorReader SetUpData3DPointsData(
+         int64_t dataIndex, size_t pointCount, const Data3DPointsDouble &buffers,
+         const CompressedVectorReaderOptions &readOptions ) const;
+
       ///@}
 
       /// @name File information
@@ -47,6 +47,52 @@ namespace e57
 
       /// Information describing the Coordinate Reference System to be used for the file
       ustring coordinateMetadata;
+
+      /// @brief Precision (in metres) to quantise cartesian coordinates and spherical ranges to
+      /// @details If > 0, Writer::WriteData3DData() stores these fields as scaled integers with
+      /// this scale and with bounds taken from the data, so they use as few bits as possible. This
+      /// only applies to fields set up as Float or Double whose values are all finite. 0 leaves
+      /// them as they are.
+      double pointRangePrecision = 0.0;
+
+      /// Precision (in radians) to quantise spherical azimuth and elevation to (see
+      /// #pointRangePrecision)
+      double anglePrecision = 0.0;
+
+      /// Precision to quantise intensity to (see #pointRangePrecision). Intensity limits set in
+      /// the Data3D header are kept, otherwise they are taken from the data. If the data is
+      /// outside the limits set, intensity isn't quantised.
+      double intensityPrecision = 0.0;
+
+      /// Precision (in seconds) to quantise time stamps to (see #pointRangePrecision)
+      double timePrecision = 0.0;
+
+      /// @brief Gather bounds from the points as they are written
+      /// @details If true, the cartesianBounds, sphericalBounds, indexBounds, intensityLimits and
+      /// colorLimits of each scan are worked out while its points are encoded, and any left unset
+      /// in the Data3D header are filled in when the file is closed. Points can then be streamed
+      /// through a writer from SetUpData3DPointsData() without knowing these up front. Each
+      /// writer's bounds are kept when it is closed, whether by close() or by going out of scope.
+      /// Colour fields without colorLimits accept the full range of uint16_t values. Integer and
+      /// scaled integer intensity still need intensityLimits, since they bound the field.
+      bool collectStatistics = false;
+
+      /// @brief Store integer fields which hold one value for the whole scan as constants
+      /// @details If true, Writer::WriteData3DData() checks the buffers of the integer fields
+      /// (colours, return and row/column indices, and the invalid states). Any which hold the same
+      /// value for every point are declared with that value as their minimum and maximum, so they
+      /// take no space in the data packets. The bounds and limits in the header are left as they
+      /// are.
+      bool detectConstantFields = false;
+
+      /// @brief Store slowly changing fields with the delta codec
+      /// @details If true, the row and column indices, and the time stamps and spherical angles
+      /// when they are stored as scaled integers (see #timePrecision and #anglePrecision), are
+      /// stored as differences between neighbouring points. This takes far fewer bits for
+      /// organised scans. The codec is an extension (see e57::DELTA_CODEC_URI), so other software
+      /// has to know it to read these fields. Fields stored this way can't be read with
+      /// CompressedVectorReaderOptions::packetStride.
+      bool deltaCodec = false;
    };
 
    /// @brief Used for writing an E57 file using the E57 Simple API.
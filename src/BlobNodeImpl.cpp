@@ -135,6 +135,7 @@ namespace e57
       }
 
       ImageFileImplSharedPtr imf( destImageFile_ );
+      std::lock_guard<std::mutex> lock( imf->fileMutex_ );
       imf->file_->seek( binarySectionLogicalStart_ + sizeof( BlobSectionHeader ) + start );
       imf->file_->read( reinterpret_cast<char *>( buf ),
                         static_cast<size_t>( count ) ); //??? arg1 void* ?
@@ -165,6 +166,7 @@ namespace e57
       }
 
       ImageFileImplSharedPtr imf( destImageFile_ );
+      std::lock_guard<std::mutex> lock( imf->fileMutex_ );
       imf->file_->seek( binarySectionLogicalStart_ + sizeof( BlobSectionHeader ) + start );
       imf->file_->write( reinterpret_cast<char *>( buf ),
                          static_cast<size_t>( count ) ); //??? arg1 void* ?
@@ -409,6 +409,46 @@ void CheckedFile::write( const char *buf, size_t nWrite )
    seek( end, Logical );
 }
 
+void CheckedFile::writePhysicalPages( char *pages, uint64_t page, size_t pageCount )
+{
+   if ( readOnly_ )
+   {
+      throw E57_EXCEPTION2( ErrorFileReadOnly, "fileName=" + fileName_ );
+   }
+
+   for ( size_t i = 0; i < pageCount; ++i )
+   {
+      char *page_buffer = pages + i * physicalPageSize;
+
+      const uint32_t check_sum = checksum( page_buffer, logicalPageSize );
+      memcpy( &page_buffer[logicalPageSize], &check_sum, sizeof( check_sum ) );
+   }
+
+   seek( page * physicalPageSize, Physical );
+
+   const size_t byteCount = pageCount * physicalPageSize;
+
+#if defined( _MSC_VER )
+   int result = ::_write( fd_, pages, static_cast<unsigned>( byteCount ) );
+#elif defined( __GNUC__ )
+   ssize_t result = ::write( fd_, pages, byteCount );
+#else
+#error "no supported compiler defined"
+#endif
+
+   if ( result < 0 || static_cast<size_t>( result ) != byteCount )
+   {
+      throw E57_EXCEPTION2( ErrorWriteFailed,
+                            "fileName=" + fileName_ + " result=" + toString( result ) );
+   }
+
+   const uint64_t end = ( page + pageCount ) * logicalPageSize;
+   if ( end > logicalLength_ )
+   {
+      logicalLength_ = end;
+   }
+}
+
 CheckedFile &CheckedFile::operator<<( const ustring &s )
 {
    write( s.c_str(), s.length() ); //??? should be times size of uchar?
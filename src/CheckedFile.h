@@ -77,6 +77,10 @@ namespace e57
       uint64_t length( OffsetMode omode = Logical );
       void extend( uint64_t newLength, OffsetMode omode = Logical );
 
+      /// Write pageCount whole physical pages, starting at page, in one go. Each page holds
+      /// logicalPageSize bytes of data followed by room for its checksum, which is filled in here.
+      void writePhysicalPages( char *pages, uint64_t page, size_t pageCount );
+
       e57::ustring fileName() const
       {
          return fileName_;
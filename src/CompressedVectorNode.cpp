@@ -141,6 +141,11 @@ parameters to tune. In the ASTM standard, if no codec is specified, the bitPackC
 specifying the @c codecs as an empty VectorNode is equivalent to requesting at all fields in the
 record be encoded with the bitPackCodec.
 
+This library also implements the delta codec extension (see e57::DELTA_CODEC_URI) for IntegerNode
+and ScaledIntegerNode fields, which stores the difference between each value and the one before it.
+Fields which change slowly from record to record, such as row and column indices, take far less
+space this way. Reading or writing a field whose codec isn't one of these throws ::ErrorBadCodecs.
+
 Other than the @c prototype and @c codecs attributes, the only other state directly accessible is
 the number of children (records) in the CompressedVectorNode. The read/write access to the contents
 of the CompressedVectorNode is coordinated by two other Foundation API objects:
@@ -184,8 +189,9 @@ and BlobNode are not allowed). See CompressedVectorNode for discussion about the
 argument.
 
 The @a codecs must be a heterogeneous VectorNode with children as specified in the ASTM E57 data
-format standard. Since currently only one codec is supported (bitPackCodec), and it is the default,
-passing an empty VectorNode will specify that all record fields will be encoded with bitPackCodec.
+format standard. Since bitPackCodec is the default, passing an empty VectorNode will specify that
+all record fields will be encoded with bitPackCodec. See e57::DELTA_CODEC_URI for how to ask for the
+delta codec instead.
 
 @pre The @a destImageFile must be open (i.e. destImageFile.isOpen() must be true).
 @pre The @a destImageFile must have been opened in write mode (i.e. destImageFile.isWritable() must
@@ -440,7 +446,49 @@ CompressedVectorNode::prototype
 */
 CompressedVectorWriter CompressedVectorNode::writer( std::vector<SourceDestBuffer> &sbufs )
 {
-   return CompressedVectorWriter( impl_->writer( sbufs ) );
+   return CompressedVectorWriter( impl_->writer( sbufs, {} ) );
+}
+
+/*!
+@brief Create an iterator object for writing a series of blocks of data to a CompressedVectorNode
+using the given options.
+
+@param [in] sbufs Vector of memory buffers that will hold data to be written to a
+CompressedVectorNode.
+@param [in] options Options controlling how the records are encoded.
+
+@details
+Behaves like CompressedVectorNode::writer(std::vector<SourceDestBuffer>&).
+
+If @a options.encodeThreads is greater than 1, the fields going into each binary data packet are
+encoded concurrently on that many threads (including the calling thread). The fields are still
+assembled into packets in the same order, so the file is identical to the one written with a single
+thread. This helps most with prototypes that have many fields. If @a options.encodeThreads is 0, one
+thread per hardware core is used.
+
+@pre Same as CompressedVectorNode::writer(std::vector<SourceDestBuffer>&).
+
+@return A smart CompressedVectorWriter handle referencing the underlying iterator object.
+
+@throw ::ErrorBadAPIArgument
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorFileReadOnly
+@throw ::ErrorSetTwice
+@throw ::ErrorTooManyWriters
+@throw ::ErrorTooManyReaders
+@throw ::ErrorNodeUnattached
+@throw ::ErrorPathUndefined
+@throw ::ErrorBufferSizeMismatch
+@throw ::ErrorBufferDuplicatePathName
+@throw ::ErrorNoBufferForElement
+@throw ::ErrorInternal All objects in undocumented state
+
+@see CompressedVectorNode::writer(std::vector<SourceDestBuffer>&), CompressedVectorWriterOptions
+*/
+CompressedVectorWriter CompressedVectorNode::writer( std::vector<SourceDestBuffer> &sbufs,
+                                                     const CompressedVectorWriterOptions &options )
+{
+   return CompressedVectorWriter( impl_->writer( sbufs, options ) );
 }
 
 /*!
@@ -476,5 +524,69 @@ CompressedVectorNode::prototype
 */
 CompressedVectorReader CompressedVectorNode::reader( const std::vector<SourceDestBuffer> &dbufs )
 {
-   return CompressedVectorReader( impl_->reader( dbufs ) );
+   return CompressedVectorReader( impl_->reader( dbufs, {} ) );
+}
+
+/*!
+@brief Create an iterator object for reading a series of blocks of data from a CompressedVectorNode
+using the given options.
+
+@param [in] dbufs Vector of memory buffers that will receive data read from a CompressedVectorNode.
+@param [in] options Options controlling which records are transferred.
+
+@details
+Behaves like CompressedVectorNode::reader(const std::vector<SourceDestBuffer>&).
+
+If @a options.decimation is N (N > 1), only every Nth record (records 0, N, 2N, ...) is transferred
+to the @a dbufs. CompressedVectorReader::read() then returns the number of records transferred, not
+the number of records stepped over in the CompressedVectorNode.
+
+If @a options.packetStride is N (N > 1), only every Nth binary data packet is decoded and the others
+are skipped without being read. Each decoded packet contributes the consecutive records it holds
+completely for every field in @a dbufs. This is intended for quick previews of large data sets. It
+can be combined with @a options.decimation. It is not supported when @a dbufs contains a StringNode
+field or a field stored with the delta codec (see e57::DELTA_CODEC_URI), because where their records
+start in a packet isn't known without decoding the packets before it.
+
+If @a options.filters is not empty, only records which pass every RecordFilter are transferred to
+the @a dbufs. Each filter compares the value in one of the @a dbufs (after any conversion or
+scaling) to a constant. Failing records are dropped as they are decoded, so each
+CompressedVectorReader::read() still fills the @a dbufs with passing records where possible.
+
+If @a options.cartesianFromSpherical is not empty, each point read from the "sphericalRange",
+"sphericalAzimuth", and "sphericalElevation" @a dbufs is also converted to cartesian coordinates
+and stored in the "cartesianX", "cartesianY", and "cartesianZ" buffers it holds. This happens in
+the same pass that decodes the point. Filters and @a options.transformCartesian may use these
+cartesian buffers.
+
+If @a options.transformCartesian is true, each point in the "cartesianX", "cartesianY", and
+"cartesianZ" @a dbufs is rotated and translated (e.g. by a scan's pose) in the same pass that
+decodes it. These three @a dbufs must be floating point. Filters are applied to the transformed
+values.
+
+@pre @a options.decimation must be greater than 0.
+@pre @a options.packetStride must be greater than 0.
+@pre Each filter in @a options.filters must name a numeric field in @a dbufs.
+@pre If @a options.transformCartesian is true, @a options.cartesianRotation must be non-zero.
+
+@return A smart CompressedVectorReader handle referencing the underlying iterator object.
+
+@throw ::ErrorBadAPIArgument
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorTooManyWriters
+@throw ::ErrorNodeUnattached
+@throw ::ErrorPathUndefined
+@throw ::ErrorBufferSizeMismatch
+@throw ::ErrorBufferDuplicatePathName
+@throw ::ErrorBadCVHeader
+@throw ::ErrorNotImplemented
+@throw ::ErrorInternal All objects in undocumented state
+
+@see CompressedVectorNode::reader(const std::vector<SourceDestBuffer>&),
+CompressedVectorReaderOptions
+*/
+CompressedVectorReader CompressedVectorNode::reader( const std::vector<SourceDestBuffer> &dbufs,
+                                                     const CompressedVectorReaderOptions &options )
+{
+   return CompressedVectorReader( impl_->reader( dbufs, options ) );
 }
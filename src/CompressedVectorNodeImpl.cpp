@@ -31,6 +31,7 @@
 #include "CompressedVectorWriterImpl.h"
 #include "ImageFileImpl.h"
 #include "StringFunctions.h"
+#include "StringNodeImpl.h"
 #include "VectorNodeImpl.h"
 
 namespace e57
@@ -129,6 +130,91 @@ namespace e57
       return ( codecs_ ); //??? check defined
    }
 
+   FieldCodec CompressedVectorNodeImpl::fieldCodec( const ustring &pathName ) const
+   {
+      // don't checkImageFileOpen, the encoder and decoder factories did
+
+      // No codecs means bitPackCodec for everything
+      if ( !codecs_ )
+      {
+         return FieldCodec::BitPack;
+      }
+
+      ImageFileImplSharedPtr imf( destImageFile_ );
+      const NodeImplSharedPtr field = prototype_->get( pathName );
+
+      // Each entry is a Structure with a Vector of "inputs" paths and one codec child
+      for ( int64_t i = 0; i < codecs_->childCount(); ++i )
+      {
+         const NodeImplSharedPtr entry = codecs_->get( i );
+
+         if ( ( entry->type() != TypeStructure ) || !entry->isDefined( "inputs" ) ||
+              ( entry->get( "inputs" )->type() != TypeVector ) )
+         {
+            throw E57_EXCEPTION2( ErrorBadCodecs, "this->pathName=" + this->pathName() +
+                                                     " entry=" + toString( i ) );
+         }
+
+         auto codec = std::static_pointer_cast<StructureNodeImpl>( entry );
+         auto inputs = std::static_pointer_cast<VectorNodeImpl>( codec->get( "inputs" ) );
+
+         bool isInput = false;
+         for ( int64_t j = 0; ( j < inputs->childCount() ) && !isInput; ++j )
+         {
+            const NodeImplSharedPtr input = inputs->get( j );
+            if ( input->type() != TypeString )
+            {
+               throw E57_EXCEPTION2( ErrorBadCodecs, "this->pathName=" + this->pathName() +
+                                                        " entry=" + toString( i ) );
+            }
+
+            const ustring inputPath = std::static_pointer_cast<StringNodeImpl>( input )->value();
+            isInput =
+               prototype_->isDefined( inputPath ) && ( prototype_->get( inputPath ) == field );
+         }
+
+         if ( !isInput )
+         {
+            continue;
+         }
+
+         for ( int64_t j = 0; j < codec->childCount(); ++j )
+         {
+            const ustring codecName = codec->get( j )->elementName();
+            if ( codecName == "inputs" )
+            {
+               continue;
+            }
+
+            if ( codecName == "bitPackCodec" )
+            {
+               return FieldCodec::BitPack;
+            }
+
+            // Extension codecs are recognised by their namespace, whatever its prefix is
+            ustring prefix;
+            ustring localPart;
+            ustring uri;
+            ImageFileImpl::elementNameParse( codecName, prefix, localPart );
+
+            if ( imf->extensionsLookupPrefix( prefix, uri ) && ( uri == DELTA_CODEC_URI ) &&
+                 ( localPart == "deltaCodec" ) )
+            {
+               return FieldCodec::Delta;
+            }
+
+            throw E57_EXCEPTION2( ErrorBadCodecs, "this->pathName=" + this->pathName() +
+                                                     " fieldPathName=" + pathName +
+                                                     " codec=" + codecName );
+         }
+
+         throw E57_EXCEPTION2( ErrorBadCodecs, "this->pathName=" + this->pathName() +
+                                                  " entry=" + toString( i ) );
+      }
+
+      return FieldCodec::BitPack;
+   }
+
    bool CompressedVectorNodeImpl::isTypeEquivalent( NodeImplSharedPtr ni )
    {
       // don't checkImageFileOpen
@@ -266,7 +352,7 @@ namespace e57
 #endif
 
    std::shared_ptr<CompressedVectorWriterImpl> CompressedVectorNodeImpl::writer(
-      std::vector<SourceDestBuffer> sbufs )
+      std::vector<SourceDestBuffer> sbufs, const CompressedVectorWriterOptions &options )
    {
       checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
 
@@ -313,12 +399,12 @@ namespace e57
 
       // Return a shared_ptr to new object
       std::shared_ptr<CompressedVectorWriterImpl> cvwi(
-         new CompressedVectorWriterImpl( cai, sbufs ) );
+         new CompressedVectorWriterImpl( cai, sbufs, options ) );
       return ( cvwi );
    }
 
    std::shared_ptr<CompressedVectorReaderImpl> CompressedVectorNodeImpl::reader(
-      std::vector<SourceDestBuffer> dbufs )
+      std::vector<SourceDestBuffer> dbufs, const CompressedVectorReaderOptions &options )
    {
       checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
 
@@ -368,7 +454,7 @@ namespace e57
 #endif
       // Return a shared_ptr to new object
       std::shared_ptr<CompressedVectorReaderImpl> cvri(
-         new CompressedVectorReaderImpl( cai, dbufs ) );
+         new CompressedVectorReaderImpl( cai, dbufs, options ) );
       return ( cvri );
    }
 }
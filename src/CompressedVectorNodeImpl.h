@@ -30,6 +30,13 @@
 
 namespace e57
 {
+   /// Codecs a field of the records may be stored with
+   enum class FieldCodec
+   {
+      BitPack, ///< the standard's bitPackCodec
+      Delta    ///< the delta codec extension (see DELTA_CODEC_URI)
+   };
+
    class CompressedVectorNodeImpl : public NodeImpl
    {
    public:
@@ -50,6 +57,10 @@ namespace e57
       void setCodecs( const std::shared_ptr<VectorNodeImpl> &codecs );
       std::shared_ptr<VectorNodeImpl> getCodecs() const;
 
+      /// Codec the codecs tree gives for the prototype field at pathName. Fields it doesn't
+      /// mention use bitPackCodec. Throws ErrorBadCodecs if it names a codec we don't have.
+      FieldCodec fieldCodec( const ustring &pathName ) const;
+
       int64_t childCount() const;
 
       void checkLeavesInSet( const StringSet &pathNames, NodeImplSharedPtr origin ) override;
@@ -58,8 +69,10 @@ namespace e57
                      const char *forcedFieldName = nullptr ) override;
 
       /// Iterator constructors
-      std::shared_ptr<CompressedVectorWriterImpl> writer( std::vector<SourceDestBuffer> sbufs );
-      std::shared_ptr<CompressedVectorReaderImpl> reader( std::vector<SourceDestBuffer> dbufs );
+      std::shared_ptr<CompressedVectorWriterImpl> writer(
+         std::vector<SourceDestBuffer> sbufs, const CompressedVectorWriterOptions &options );
+      std::shared_ptr<CompressedVectorReaderImpl> reader(
+         std::vector<SourceDestBuffer> dbufs, const CompressedVectorReaderOptions &options );
 
       int64_t getRecordCount() const
       {
@@ -25,6 +25,9 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <algorithm>
+#include <cmath>
+
 #include "CompressedVectorReaderImpl.h"
 #include "CheckedFile.h"
 #include "CompressedVectorNodeImpl.h"
@@ -36,9 +39,85 @@
 
 namespace e57
 {
+   /// Apply p' = matrix * p + translation to the points [beginIndex, endIndex) of three coordinate
+   /// buffers, in place. Points are independent, so the compiler can vectorize the loop.
+   template <typename T>
+   void _transformPoints( SourceDestBufferImpl *xBuf, SourceDestBufferImpl *yBuf,
+                          SourceDestBufferImpl *zBuf, unsigned beginIndex, unsigned endIndex,
+                          const double *matrix, const double *translation )
+   {
+      // Local copies, so the compiler knows the stores to the buffers can't change them
+      double m[9];
+      double t[3];
+      std::copy( matrix, matrix + 9, m );
+      std::copy( translation, translation + 3, t );
+
+      char *xBase = static_cast<char *>( xBuf->base() );
+      char *yBase = static_cast<char *>( yBuf->base() );
+      char *zBase = static_cast<char *>( zBuf->base() );
+      const size_t xStride = xBuf->stride();
+      const size_t yStride = yBuf->stride();
+      const size_t zStride = zBuf->stride();
+
+      for ( size_t i = beginIndex; i < endIndex; ++i )
+      {
+         T &x = *reinterpret_cast<T *>( &xBase[i * xStride] );
+         T &y = *reinterpret_cast<T *>( &yBase[i * yStride] );
+         T &z = *reinterpret_cast<T *>( &zBase[i * zStride] );
+
+         const double px = x;
+         const double py = y;
+         const double pz = z;
+
+         x = static_cast<T>( m[0] * px + m[1] * py + m[2] * pz + t[0] );
+         y = static_cast<T>( m[3] * px + m[4] * py + m[5] * pz + t[1] );
+         z = static_cast<T>( m[6] * px + m[7] * py + m[8] * pz + t[2] );
+      }
+   }
+
+   /// Convert (range, azimuth, elevation) to (x, y, z) for the points [beginIndex, endIndex).
+   /// Points are independent, so the compiler can vectorize the loop if it has vector sin and cos.
+   template <typename SphericalT, typename CartesianT>
+   void _sphericalToCartesian( SourceDestBufferImpl *const spherical[3],
+                               SourceDestBufferImpl *const cartesian[3], unsigned beginIndex,
+                               unsigned endIndex )
+   {
+      const char *rangeBase = static_cast<const char *>( spherical[0]->base() );
+      const char *azimuthBase = static_cast<const char *>( spherical[1]->base() );
+      const char *elevationBase = static_cast<const char *>( spherical[2]->base() );
+      const size_t rangeStride = spherical[0]->stride();
+      const size_t azimuthStride = spherical[1]->stride();
+      const size_t elevationStride = spherical[2]->stride();
+
+      char *xBase = static_cast<char *>( cartesian[0]->base() );
+      char *yBase = static_cast<char *>( cartesian[1]->base() );
+      char *zBase = static_cast<char *>( cartesian[2]->base() );
+      const size_t xStride = cartesian[0]->stride();
+      const size_t yStride = cartesian[1]->stride();
+      const size_t zStride = cartesian[2]->stride();
+
+      for ( size_t i = beginIndex; i < endIndex; ++i )
+      {
+         const double range = *reinterpret_cast<const SphericalT *>( &rangeBase[i * rangeStride] );
+         const double azimuth =
+            *reinterpret_cast<const SphericalT *>( &azimuthBase[i * azimuthStride] );
+         const double elevation =
+            *reinterpret_cast<const SphericalT *>( &elevationBase[i * elevationStride] );
+
+         const double rangeXY = range * std::cos( elevation );
+
+         *reinterpret_cast<CartesianT *>( &xBase[i * xStride] ) =
+            static_cast<CartesianT>( rangeXY * std::cos( azimuth ) );
+         *reinterpret_cast<CartesianT *>( &yBase[i * yStride] ) =
+            static_cast<CartesianT>( rangeXY * std::sin( azimuth ) );
+         *reinterpret_cast<CartesianT *>( &zBase[i * zStride] ) =
+            static_cast<CartesianT>( range * std::sin( elevation ) );
+      }
+   }
+
    CompressedVectorReaderImpl::CompressedVectorReaderImpl(
-      std::shared_ptr<CompressedVectorNodeImpl> cvi,
-      std::vector<SourceDestBuffer> &dbufs ) :
+      std::shared_ptr<CompressedVectorNodeImpl> cvi, std::vector<SourceDestBuffer> &dbufs,
+      const CompressedVectorReaderOptions &options ) :
       isOpen_( false ), // set to true when succeed below
       cVector_( cvi )
    {
@@ -60,6 +139,22 @@ namespace e57
                                                        " cvPathName=" + cVector_->pathName() );
       }
 
+      if ( options.decimation == 0 )
+      {
+         throw E57_EXCEPTION2( ErrorBadAPIArgument, "decimation=0 imageFileName=" +
+                                                       cVector_->imageFileName() +
+                                                       " cvPathName=" + cVector_->pathName() );
+      }
+
+      if ( options.packetStride == 0 )
+      {
+         throw E57_EXCEPTION2( ErrorBadAPIArgument, "packetStride=0 imageFileName=" +
+                                                       cVector_->imageFileName() +
+                                                       " cvPathName=" + cVector_->pathName() );
+      }
+
+      packetStride_ = options.packetStride;
+
       // Get CompressedArray's prototype node (all array elements must match this
       // type)
       proto_ = cVector_->getPrototype();
@@ -77,6 +172,17 @@ namespace e57
          std::shared_ptr<Decoder> decoder =
             Decoder::DecoderFactory( i, cVector_.get(), theDbuf, ustring() );
 
+         decoder->setDecimation( options.decimation );
+
+         // Packet previews need to know where records start without decoding earlier packets
+         uint64_t beginRecord = 0;
+         uint64_t endRecord = 0;
+         if ( ( packetStride_ > 1 ) && !decoder->packetRecordRange( 0, 0, beginRecord, endRecord ) )
+         {
+            throw E57_EXCEPTION2( ErrorNotImplemented, "packetStride=" + toString( packetStride_ ) +
+                                                          " pathName=" + dbufs.at( i ).pathName() );
+         }
+
          // Calc which stream the given path belongs to.  This depends on position
          // of the node in the proto tree.
          NodeImplSharedPtr readNode = proto_->get( dbufs.at( i ).pathName() );
@@ -90,6 +196,97 @@ namespace e57
                                  cVector_->childCount() );
       }
 
+      if ( !options.cartesianFromSpherical.empty() )
+      {
+         setUpSphericalConversion( options.cartesianFromSpherical );
+      }
+
+      // Each filter must test one of our numeric dbufs
+      for ( const RecordFilter &filter : options.filters )
+      {
+         if ( ( filter.comparison < FilterEqual ) || ( filter.comparison > FilterGreaterEqual ) )
+         {
+            throw E57_EXCEPTION2( ErrorBadAPIArgument,
+                                  "comparison=" + toString( filter.comparison ) +
+                                     " filterPathName=" + filter.pathName );
+         }
+
+         std::shared_ptr<SourceDestBufferImpl> filterBuffer = findBuffer( filter.pathName );
+
+         if ( !filterBuffer || ( filterBuffer->memoryRepresentation() == UString ) )
+         {
+            throw E57_EXCEPTION2( ErrorBadAPIArgument, "filterPathName=" + filter.pathName +
+                                                          " cvPathName=" + cVector_->pathName() );
+         }
+
+         filters_.push_back( filter );
+         filterBuffers_.push_back( filterBuffer );
+      }
+
+      if ( options.transformCartesian )
+      {
+         // Need all three cartesian coordinates, in the same floating point representation
+         const char *cartesianNames[3] = { "cartesianX", "cartesianY", "cartesianZ" };
+
+         for ( size_t axis = 0; axis < 3; ++axis )
+         {
+            cartesianBuffers_[axis] = findBuffer( cartesianNames[axis] );
+
+            if ( !cartesianBuffers_[axis] ||
+                 ( ( cartesianBuffers_[axis]->memoryRepresentation() != Real32 ) &&
+                   ( cartesianBuffers_[axis]->memoryRepresentation() != Real64 ) ) )
+            {
+               throw E57_EXCEPTION2( ErrorBadAPIArgument,
+                                     "transformCartesian pathName=" +
+                                        ustring( cartesianNames[axis] ) +
+                                        " cvPathName=" + cVector_->pathName() );
+            }
+         }
+
+         const MemoryRepresentation cartesianRepresentation =
+            cartesianBuffers_[0]->memoryRepresentation();
+
+         if ( ( cartesianBuffers_[1]->memoryRepresentation() != cartesianRepresentation ) ||
+              ( cartesianBuffers_[2]->memoryRepresentation() != cartesianRepresentation ) )
+         {
+            throw E57_EXCEPTION2( ErrorBadAPIArgument,
+                                  "transformCartesian cvPathName=" + cVector_->pathName() );
+         }
+
+         // Normalize the quaternion and convert it to a rotation matrix once, up front
+         const double *q = options.cartesianRotation;
+         const double norm = std::sqrt( q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3] );
+
+         if ( !( norm > 0.0 ) )
+         {
+            throw E57_EXCEPTION2( ErrorBadAPIArgument,
+                                  "cartesianRotation norm=" + toString( norm ) +
+                                     " cvPathName=" + cVector_->pathName() );
+         }
+
+         const double w = q[0] / norm;
+         const double x = q[1] / norm;
+         const double y = q[2] / norm;
+         const double z = q[3] / norm;
+
+         cartesianMatrix_[0] = 1.0 - 2.0 * ( y * y + z * z );
+         cartesianMatrix_[1] = 2.0 * ( x * y - w * z );
+         cartesianMatrix_[2] = 2.0 * ( x * z + w * y );
+         cartesianMatrix_[3] = 2.0 * ( x * y + w * z );
+         cartesianMatrix_[4] = 1.0 - 2.0 * ( x * x + z * z );
+         cartesianMatrix_[5] = 2.0 * ( y * z - w * x );
+         cartesianMatrix_[6] = 2.0 * ( x * z - w * y );
+         cartesianMatrix_[7] = 2.0 * ( y * z + w * x );
+         cartesianMatrix_[8] = 1.0 - 2.0 * ( x * x + y * y );
+
+         for ( size_t axis = 0; axis < 3; ++axis )
+         {
+            cartesianTranslation_[axis] = options.cartesianTranslation[axis];
+         }
+
+         transformCartesian_ = true;
+      }
+
       recordCount_ = 0;
 
       // Get how many records are actually defined
@@ -135,6 +332,9 @@ namespace e57
       //??? what if fault in this constructor?
       cache_ = new PacketReadCache( imf->file_, 32 );
 
+      previewNextPacketLogicalOffset_ = dataLogicalOffset;
+      previewStreamOffsets_.assign( channels_.size(), 0 );
+
       // Verify that packet given by dataPhysicalOffset is actually a data packet,
       // init channels
       {
@@ -249,31 +449,46 @@ namespace e57
          dbuf.impl()->rewind();
       }
 
-      // Allow decoders to use data they already have in their queue to fill newly
-      // empty dbufs This helps to keep decoder input queues smaller, which
-      // reduces backtracking in the packet cache.
-      for ( auto &channel : channels_ )
+      for ( auto &output : sphericalOutputs_ )
       {
-         channel.decoder->inputProcess( nullptr, 0 );
+         output.impl()->rewind();
       }
 
-      // Loop until every dbuf is full or we have reached end of the binary
-      // section.
+      // Decode into the dbufs, then convert, transform, and filter what was decoded. Filtering may
+      // free up space, so keep going until the dbufs are full of passing records or we run out of
+      // records.
+      unsigned processedCount = 0;
       while ( true )
       {
-         // Find the earliest packet position for channels that are still hungry
-         // It's important to call inputProcess of the decoders before this call,
-         // so current hungriness level is reflected.
-         uint64_t earliestPacketLogicalOffset = earliestPacketNeededForInput();
+         decodeRecords();
 
-         // If nobody's hungry, we are done with the read
-         if ( earliestPacketLogicalOffset == UINT64_MAX )
+         const unsigned decodedCount = channels_.front().dbuf.impl()->nextIndex();
+         if ( decodedCount == processedCount )
          {
             break;
          }
 
-         // Feed packet to the hungry decoders
-         feedPacketToDecoders( earliestPacketLogicalOffset );
+         if ( !sphericalOutputs_.empty() )
+         {
+            convertSphericalRecords( processedCount, decodedCount );
+         }
+
+         if ( transformCartesian_ )
+         {
+            transformRecords( processedCount, decodedCount );
+         }
+
+         if ( filters_.empty() )
+         {
+            break;
+         }
+
+         processedCount = filterRecords( processedCount );
+
+         if ( processedCount == channels_.front().dbuf.impl()->capacity() )
+         {
+            break;
+         }
       }
 
       // Verify that each channel produced the same number of records
@@ -300,6 +515,210 @@ namespace e57
       return outputCount;
    }
 
+   void CompressedVectorReaderImpl::decodeRecords()
+   {
+      if ( packetStride_ > 1 )
+      {
+         readPacketPreview();
+      }
+      else
+      {
+         // Allow decoders to use data they already have in their queue to fill newly
+         // empty dbufs This helps to keep decoder input queues smaller, which
+         // reduces backtracking in the packet cache.
+         for ( auto &channel : channels_ )
+         {
+            channel.decoder->inputProcess( nullptr, 0 );
+         }
+
+         // Loop until every dbuf is full or we have reached end of the binary
+         // section.
+         while ( true )
+         {
+            // Find the earliest packet position for channels that are still hungry
+            // It's important to call inputProcess of the decoders before this call,
+            // so current hungriness level is reflected.
+            uint64_t earliestPacketLogicalOffset = earliestPacketNeededForInput();
+
+            // If nobody's hungry, we are done with the read
+            if ( earliestPacketLogicalOffset == UINT64_MAX )
+            {
+               break;
+            }
+
+            // Feed packet to the hungry decoders
+            feedPacketToDecoders( earliestPacketLogicalOffset );
+         }
+      }
+   }
+
+   unsigned CompressedVectorReaderImpl::filterRecords( unsigned beginIndex )
+   {
+      const unsigned endIndex = channels_.front().dbuf.impl()->nextIndex();
+
+      // Start with everything passing, and let each filter knock out the records that fail it
+      filterPass_.assign( endIndex - beginIndex, 1 );
+
+      for ( size_t i = 0; i < filters_.size(); ++i )
+      {
+         const RecordFilter &filter = filters_[i];
+
+         filterBuffers_[i]->filterRecords( beginIndex, endIndex, filter.comparison, filter.value,
+                                           filterPass_ );
+      }
+
+      // Every channel must drop the same records so they stay in step
+      for ( DecodeChannel &channel : channels_ )
+      {
+         channel.dbuf.impl()->compactRecords( beginIndex, filterPass_ );
+      }
+
+      for ( SourceDestBuffer &output : sphericalOutputs_ )
+      {
+         output.impl()->compactRecords( beginIndex, filterPass_ );
+      }
+
+      return channels_.front().dbuf.impl()->nextIndex();
+   }
+
+   void CompressedVectorReaderImpl::transformRecords( unsigned beginIndex, unsigned endIndex )
+   {
+      SourceDestBufferImpl *xBuf = cartesianBuffers_[0].get();
+      SourceDestBufferImpl *yBuf = cartesianBuffers_[1].get();
+      SourceDestBufferImpl *zBuf = cartesianBuffers_[2].get();
+
+      // The constructor checked that all three have the same floating point representation
+      if ( xBuf->memoryRepresentation() == Real32 )
+      {
+         _transformPoints<float>( xBuf, yBuf, zBuf, beginIndex, endIndex, cartesianMatrix_,
+                                  cartesianTranslation_ );
+      }
+      else
+      {
+         _transformPoints<double>( xBuf, yBuf, zBuf, beginIndex, endIndex, cartesianMatrix_,
+                                   cartesianTranslation_ );
+      }
+   }
+
+   void CompressedVectorReaderImpl::convertSphericalRecords( unsigned beginIndex,
+                                                             unsigned endIndex )
+   {
+      SourceDestBufferImpl *spherical[3] = { sphericalBuffers_[0].get(), sphericalBuffers_[1].get(),
+                                             sphericalBuffers_[2].get() };
+      SourceDestBufferImpl *cartesian[3] = { sphericalOutputs_[0].impl().get(),
+                                             sphericalOutputs_[1].impl().get(),
+                                             sphericalOutputs_[2].impl().get() };
+
+      // setUpSphericalConversion() checked that each group of three has the same floating point
+      // representation
+      const bool sphericalDouble = ( spherical[0]->memoryRepresentation() == Real64 );
+      const bool cartesianDouble = ( cartesian[0]->memoryRepresentation() == Real64 );
+
+      if ( sphericalDouble && cartesianDouble )
+      {
+         _sphericalToCartesian<double, double>( spherical, cartesian, beginIndex, endIndex );
+      }
+      else if ( sphericalDouble )
+      {
+         _sphericalToCartesian<double, float>( spherical, cartesian, beginIndex, endIndex );
+      }
+      else if ( cartesianDouble )
+      {
+         _sphericalToCartesian<float, double>( spherical, cartesian, beginIndex, endIndex );
+      }
+      else
+      {
+         _sphericalToCartesian<float, float>( spherical, cartesian, beginIndex, endIndex );
+      }
+
+      for ( SourceDestBufferImpl *output : cartesian )
+      {
+         output->setNextIndex( endIndex );
+      }
+   }
+
+   void CompressedVectorReaderImpl::setUpSphericalConversion(
+      const std::vector<SourceDestBuffer> &cartesianBuffers )
+   {
+      const char *sphericalNames[3] = { "sphericalRange", "sphericalAzimuth",
+                                        "sphericalElevation" };
+      const char *cartesianNames[3] = { "cartesianX", "cartesianY", "cartesianZ" };
+
+      auto isFloatingPoint = []( const SourceDestBufferImpl &buffer ) {
+         return ( buffer.memoryRepresentation() == Real32 ) ||
+                ( buffer.memoryRepresentation() == Real64 );
+      };
+
+      // The spherical coordinates must all be read, into the same floating point representation
+      for ( size_t axis = 0; axis < 3; ++axis )
+      {
+         sphericalBuffers_[axis] = findBuffer( sphericalNames[axis] );
+
+         if ( !sphericalBuffers_[axis] || !isFloatingPoint( *sphericalBuffers_[axis] ) ||
+              ( sphericalBuffers_[axis]->memoryRepresentation() !=
+                sphericalBuffers_[0]->memoryRepresentation() ) )
+         {
+            throw E57_EXCEPTION2( ErrorBadAPIArgument, "cartesianFromSpherical pathName=" +
+                                                          ustring( sphericalNames[axis] ) +
+                                                          " cvPathName=" + cVector_->pathName() );
+         }
+      }
+
+      if ( cartesianBuffers.size() != 3 )
+      {
+         throw E57_EXCEPTION2( ErrorBadAPIArgument, "cartesianFromSpherical size=" +
+                                                       toString( cartesianBuffers.size() ) +
+                                                       " cvPathName=" + cVector_->pathName() );
+      }
+
+      // Keep the outputs in x, y, z order, whatever order they were given in
+      const size_t capacity = channels_.front().dbuf.capacity();
+
+      for ( size_t axis = 0; axis < 3; ++axis )
+      {
+         auto output = std::find_if( cartesianBuffers.begin(), cartesianBuffers.end(),
+                                     [&]( const SourceDestBuffer &buffer ) {
+                                        return buffer.pathName() == cartesianNames[axis];
+                                     } );
+
+         // Can't also be decoded from the file, and must be able to hold as much as the dbufs
+         if ( ( output == cartesianBuffers.end() ) || findBuffer( cartesianNames[axis] ) ||
+              !isFloatingPoint( *output->impl() ) ||
+              ( output->memoryRepresentation() !=
+                cartesianBuffers.front().memoryRepresentation() ) ||
+              ( output->capacity() != capacity ) )
+         {
+            throw E57_EXCEPTION2( ErrorBadAPIArgument, "cartesianFromSpherical pathName=" +
+                                                          ustring( cartesianNames[axis] ) +
+                                                          " cvPathName=" + cVector_->pathName() );
+         }
+
+         sphericalOutputs_.push_back( *output );
+      }
+   }
+
+   std::shared_ptr<SourceDestBufferImpl> CompressedVectorReaderImpl::findBuffer(
+      const ustring &pathName ) const
+   {
+      for ( const DecodeChannel &channel : channels_ )
+      {
+         if ( channel.dbuf.pathName() == pathName )
+         {
+            return channel.dbuf.impl();
+         }
+      }
+
+      for ( const SourceDestBuffer &output : sphericalOutputs_ )
+      {
+         if ( output.pathName() == pathName )
+         {
+            return output.impl();
+         }
+      }
+
+      return nullptr;
+   }
+
    uint64_t CompressedVectorReaderImpl::earliestPacketNeededForInput() const
    {
       uint64_t earliestPacketLogicalOffset = UINT64_MAX;
@@ -542,6 +961,171 @@ namespace e57
       return UINT64_MAX;
    }
 
+   void CompressedVectorReaderImpl::readPacketPreview()
+   {
+      // Each selected packet is decoded in isolation: every decoder is restarted at the first
+      // record all channels have complete in the packet, and stops at the last such record.
+      while ( true )
+      {
+         if ( previewPacketActive_ )
+         {
+            DataPacket *dpkt = dataPacket( channels_.front().currentPacketLogicalOffset );
+
+            bool packetFinished = true;
+
+            for ( DecodeChannel &channel : channels_ )
+            {
+               if ( channel.decoder->totalRecordsCompleted() >= previewEndRecord_ )
+               {
+                  continue;
+               }
+
+               unsigned int bsbLength = 0;
+               const char *bsbStart = dpkt->getBytestream( channel.bytestreamNumber, bsbLength );
+
+               const size_t uneatenIndex = std::min( channel.currentBytestreamBufferIndex,
+                                                     static_cast<size_t>( bsbLength ) );
+               const size_t uneatenLength = bsbLength - uneatenIndex;
+
+               const size_t bytesProcessed = channel.decoder->inputProcess(
+                  ( uneatenLength > 0 ) ? &bsbStart[uneatenIndex] : nullptr, uneatenLength );
+
+               channel.currentBytestreamBufferIndex =
+                  uneatenIndex + std::min( bytesProcessed, uneatenLength );
+
+               if ( channel.decoder->totalRecordsCompleted() < previewEndRecord_ )
+               {
+                  packetFinished = false;
+               }
+            }
+
+            const DecodeChannel &firstChannel = channels_.front();
+            const bool outputFull =
+               ( firstChannel.dbuf.impl()->nextIndex() == firstChannel.dbuf.impl()->capacity() );
+
+            if ( !packetFinished )
+            {
+               // The only reason to stop part way through a packet is running out of room.
+               if ( !outputFull )
+               {
+                  throw E57_EXCEPTION2( ErrorInternal,
+                                        "packetLogicalOffset=" +
+                                           toString( firstChannel.currentPacketLogicalOffset ) +
+                                           " previewEndRecord=" + toString( previewEndRecord_ ) );
+               }
+
+               return;
+            }
+
+            previewPacketActive_ = false;
+
+            if ( outputFull )
+            {
+               return;
+            }
+         }
+
+         if ( !previewFindNextPacket() )
+         {
+            return;
+         }
+
+         previewPacketActive_ = true;
+      }
+   }
+
+   bool CompressedVectorReaderImpl::previewFindNextPacket()
+   {
+      ImageFileImplSharedPtr imf( cVector_->destImageFile_ );
+
+      std::vector<uint16_t> bytestreamLengths;
+
+      while ( previewNextPacketLogicalOffset_ < sectionEndLogicalOffset_ )
+      {
+         const uint64_t packetLogicalOffset = previewNextPacketLogicalOffset_;
+
+         // Only read the header and the bytestream lengths, not the whole packet. All packet
+         // types have their length in the same place, so we can use it to skip to the next one.
+         char headerBuffer[sizeof( DataPacketHeader )];
+         imf->file_->seek( packetLogicalOffset, CheckedFile::Logical );
+         imf->file_->read( headerBuffer, sizeof( headerBuffer ) );
+
+         const auto &header = *reinterpret_cast<const DataPacketHeader *>( headerBuffer );
+
+         previewNextPacketLogicalOffset_ += header.packetLogicalLengthMinus1 + 1;
+
+         if ( header.packetType != DATA_PACKET )
+         {
+            continue;
+         }
+
+         bytestreamLengths.resize( header.bytestreamCount );
+         if ( !bytestreamLengths.empty() )
+         {
+            imf->file_->read( reinterpret_cast<char *>( bytestreamLengths.data() ),
+                              bytestreamLengths.size() * sizeof( uint16_t ) );
+         }
+
+         const bool selected = ( previewDataPacketCount_ % packetStride_ ) == 0;
+         ++previewDataPacketCount_;
+
+         // Find the records which every channel has complete in this packet
+         uint64_t beginRecord = 0;
+         uint64_t endRecord = maxRecordCount_;
+
+         for ( size_t i = 0; i < channels_.size(); ++i )
+         {
+            const unsigned bytestreamNumber = channels_[i].bytestreamNumber;
+            if ( bytestreamNumber >= bytestreamLengths.size() )
+            {
+               throw E57_EXCEPTION2( ErrorBadCVPacket,
+                                     "bytestreamCount=" + toString( header.bytestreamCount ) +
+                                        " bytestreamNumber=" + toString( bytestreamNumber ) );
+            }
+
+            if ( selected )
+            {
+               uint64_t channelBegin = 0;
+               uint64_t channelEnd = 0;
+               channels_[i].decoder->packetRecordRange( previewStreamOffsets_[i],
+                                                        bytestreamLengths[bytestreamNumber],
+                                                        channelBegin, channelEnd );
+
+               beginRecord = std::max( beginRecord, channelBegin );
+               endRecord = std::min( endRecord, channelEnd );
+            }
+         }
+
+         if ( selected && ( beginRecord < endRecord ) )
+         {
+            for ( size_t i = 0; i < channels_.size(); ++i )
+            {
+               DecodeChannel &channel = channels_[i];
+
+               channel.currentPacketLogicalOffset = packetLogicalOffset;
+               channel.currentBytestreamBufferLength = bytestreamLengths[channel.bytestreamNumber];
+               channel.currentBytestreamBufferIndex = channel.decoder->restartAt(
+                  beginRecord, endRecord, previewStreamOffsets_[i] );
+            }
+
+            previewEndRecord_ = endRecord;
+         }
+
+         // Keep track of where the next packet starts in each bytestream
+         for ( size_t i = 0; i < channels_.size(); ++i )
+         {
+            previewStreamOffsets_[i] += bytestreamLengths[channels_[i].bytestreamNumber];
+         }
+
+         if ( selected && ( beginRecord < endRecord ) )
+         {
+            return true;
+         }
+      }
+
+      return false;
+   }
+
    void CompressedVectorReaderImpl::seek( uint64_t /*recordNumber*/ )
    {
       checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
@@ -37,7 +37,8 @@ namespace e57
    {
    public:
       CompressedVectorReaderImpl( std::shared_ptr<CompressedVectorNodeImpl> cvi,
-                                  std::vector<SourceDestBuffer> &dbufs );
+                                  std::vector<SourceDestBuffer> &dbufs,
+                                  const CompressedVectorReaderOptions &options );
       ~CompressedVectorReaderImpl();
 
       unsigned read();
@@ -63,6 +64,16 @@ namespace e57
       void feedPacketToDecoders( uint64_t currentPacketLogicalOffset );
       uint64_t findNextDataPacket( uint64_t nextPacketLogicalOffset );
 
+      void decodeRecords();
+      unsigned filterRecords( unsigned beginIndex );
+      void transformRecords( unsigned beginIndex, unsigned endIndex );
+      void convertSphericalRecords( unsigned beginIndex, unsigned endIndex );
+      void setUpSphericalConversion( const std::vector<SourceDestBuffer> &cartesianBuffers );
+      std::shared_ptr<SourceDestBufferImpl> findBuffer( const ustring &pathName ) const;
+
+      void readPacketPreview();
+      bool previewFindNextPacket();
+
       //??? no default ctor, copy, assignment?
 
       bool isOpen_;
@@ -75,5 +86,36 @@ namespace e57
       uint64_t recordCount_; /// number of records written so far
       uint64_t maxRecordCount_;
       uint64_t sectionEndLogicalOffset_;
+
+      /// Only decode every Nth data packet (see CompressedVectorReaderOptions::packetStride)
+      uint64_t packetStride_ = 1;
+
+      /// Packet preview state: the next packet to look at, how many data packets we've seen, how
+      /// far into each channel's bytestream that packet starts, and the records being decoded.
+      uint64_t previewNextPacketLogicalOffset_ = 0;
+      uint64_t previewDataPacketCount_ = 0;
+      std::vector<uint64_t> previewStreamOffsets_;
+      bool previewPacketActive_ = false;
+      uint64_t previewEndRecord_ = 0;
+
+      /// Records must pass all of these filters to be transferred. filterBuffers_ holds the buffer
+      /// each filter tests, and filterPass_ the result for each record in a batch.
+      std::vector<RecordFilter> filters_;
+      std::vector<std::shared_ptr<SourceDestBufferImpl>> filterBuffers_;
+      std::vector<uint8_t> filterPass_;
+
+      /// Rigid body transform applied to the cartesian channels (see
+      /// CompressedVectorReaderOptions::transformCartesian), as a row-major rotation matrix and a
+      /// translation, and the cartesianX, cartesianY, and cartesianZ buffers.
+      bool transformCartesian_ = false;
+      double cartesianMatrix_[9] = {};
+      double cartesianTranslation_[3] = {};
+      std::shared_ptr<SourceDestBufferImpl> cartesianBuffers_[3];
+
+      /// Buffers filled by converting the spherical channels to cartesian coordinates (see
+      /// CompressedVectorReaderOptions::cartesianFromSpherical), and the sphericalRange,
+      /// sphericalAzimuth, and sphericalElevation buffers they are converted from.
+      std::vector<SourceDestBuffer> sphericalOutputs_;
+      std::shared_ptr<SourceDestBufferImpl> sphericalBuffers_[3];
    };
 }
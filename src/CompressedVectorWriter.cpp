@@ -315,6 +315,34 @@ CompressedVectorNode CompressedVectorWriter::compressedVectorNode() const
    return impl_->compressedVectorNode();
 }
 
+/*!
+@brief Get the smallest and largest value written to a numeric field so far.
+
+@details
+The range is only tracked if the CompressedVectorWriter was created with
+CompressedVectorWriterOptions::collectStatistics set. It is gathered while the records are encoded,
+in the field's units (i.e. after scaling), with NaNs left out. It is still available after
+close(), so it can be used to fill in bounds in the ImageFile's tree before the file is closed.
+
+@param [in] pathName The path name of the field in the prototype (e.g. "cartesianX").
+@param [out] minimum The smallest value written.
+@param [out] maximum The largest value written.
+
+@return true if the range was set, false if it isn't tracked, nothing has been written to the
+field yet, or the field holds strings.
+
+@throw ::ErrorPathUndefined pathName isn't defined in the prototype.
+@throw ::ErrorBadAPIArgument pathName isn't a field of the prototype.
+@throw ::ErrorInternal All objects in undocumented state
+
+@see CompressedVectorWriterOptions::collectStatistics, CompressedVectorNode::writer
+*/
+bool CompressedVectorWriter::fieldRange( const ustring &pathName, double &minimum,
+                                         double &maximum ) const
+{
+   return impl_->fieldRange( pathName, minimum, maximum );
+}
+
 /*!
 @brief Diagnostic function to print internal state of object to output stream in an indented format.
 @copydetails Node::dump()
@@ -25,7 +25,10 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <limits>
 #include <numeric>
 
 #include "CheckedFile.h"
@@ -38,6 +41,52 @@
 
 namespace e57
 {
+   /// Data packets queued for writing in the background before encoding has to wait. Enough to
+   /// ride out a slow write without holding much memory.
+   constexpr size_t WriteQueueMaxPackets = 16;
+
+   /// Smallest output buffer an encoder may be given, enough for a few words or string prefixes
+   constexpr size_t EncoderBufferMinSize = 1024;
+
+   /// Pages of data packets staged before they are written out as one block
+   constexpr size_t WriteStagePages = 128;
+
+   /// Where packetEmit() puts a packet: a DataPacket in memory...
+   struct DataPacketOutput
+   {
+      char *base;
+      size_t used = 0;
+
+      char *next( size_t &byteCount )
+      {
+#if VALIDATE_BASIC
+         // Double check we aren't accidentally going to write off the end of the packet
+         if ( used + byteCount > DATA_PACKET_MAX )
+         {
+            throw E57_EXCEPTION2( ErrorInternal, "used=" + toString( used ) +
+                                                    " byteCount=" + toString( byteCount ) );
+         }
+#endif
+         char *dest = base + used;
+         used += byteCount;
+         return dest;
+      }
+   };
+
+   /// ...or straight into the file's staged pages
+   struct StagedPacketOutput
+   {
+      PagedWriteBuffer &stage;
+      uint64_t logicalOffset;
+
+      char *next( size_t &byteCount )
+      {
+         char *dest = stage.append( logicalOffset, byteCount );
+         logicalOffset += byteCount;
+         return dest;
+      }
+   };
+
    struct SortByBytestreamNumber
    {
       bool operator()( const std::shared_ptr<Encoder> &lhs,
@@ -48,8 +97,15 @@ namespace e57
    };
 
    CompressedVectorWriterImpl::CompressedVectorWriterImpl(
-      std::shared_ptr<CompressedVectorNodeImpl> ni, std::vector<SourceDestBuffer> &sbufs ) :
-      cVector_( ni ), isOpen_( false ) // set to true when succeed below
+      std::shared_ptr<CompressedVectorNodeImpl> ni, std::vector<SourceDestBuffer> &sbufs,
+      const CompressedVectorWriterOptions &options ) :
+      cVector_( ni ), encodePool_( options.encodeThreads ),
+      encoderBufferSize_( options.encoderBufferSize ),
+      chunkRecords_( ( options.chunkRecords + 63 ) / 64 * 64 ),
+      collectStatistics_( options.collectStatistics ), fieldRangeSink_( options.fieldRangeSink ),
+      targetPacketSize_( options.targetPacketSize ),
+      alignPacketsToPages_( options.alignPacketsToPages ), packetMaxLength_( 0 ),
+      isOpen_( false ) // set to true when succeed below
    {
       //???  check if cvector already been written (can't write twice)
 
@@ -60,6 +116,15 @@ namespace e57
                                                        " cvPathName=" + cVector_->pathName() );
       }
 
+      if ( ( encoderBufferSize_ < EncoderBufferMinSize ) ||
+           ( encoderBufferSize_ > std::numeric_limits<unsigned>::max() ) )
+      {
+         throw E57_EXCEPTION2( ErrorBadAPIArgument,
+                               "encoderBufferSize=" + toString( encoderBufferSize_ ) +
+                                  " imageFileName=" + cVector_->imageFileName() +
+                                  " cvPathName=" + cVector_->pathName() );
+      }
+
       // Get CompressedArray's prototype node (all array elements must match this
       // type)
       proto_ = cVector_->getPrototype();
@@ -67,55 +132,66 @@ namespace e57
       // Check sbufs well formed (matches proto exactly)
       setBuffers( sbufs ); //??? copy code here?
 
-      // For each individual sbuf, create an appropriate Encoder based on the
-      // cVector_ attributes
-      for ( unsigned i = 0; i < sbufs_.size(); i++ )
-      {
-         // Create vector of single sbuf  ??? for now, may have groups later
-         std::vector<SourceDestBuffer> vTemp;
-         vTemp.push_back( sbufs_.at( i ) );
+      bytestreams_ = makeEncoders( sbufs_ );
+      valueRanges_.resize( bytestreams_.size() );
 
-         ustring codecPath = sbufs_.at( i ).pathName();
+      // Each packet has to hold its header and some of every field, or writing it gets nowhere
+      const size_t cPacketMinSize =
+         sizeof( DataPacketHeader ) + bytestreams_.size() * ( sizeof( uint16_t ) + 1 );
 
-         // Calc which stream the given path belongs to.  This depends on position
-         // of the node in the proto tree.
-         NodeImplSharedPtr readNode = proto_->get( sbufs.at( i ).pathName() );
-         uint64_t bytestreamNumber = 0;
-         if ( !proto_->findTerminalPosition( readNode, bytestreamNumber ) )
-         {
-            throw E57_EXCEPTION2( ErrorInternal, "sbufIndex=" + toString( i ) );
-         }
+      // Packets are a multiple of 4 bytes long, so that is as much as one of this size can hold
+      packetMaxLength_ = targetPacketSize_ / 4 * 4;
 
-         // EncoderFactory picks the appropriate encoder to match type declared in
-         // prototype
-         bytestreams_.push_back( Encoder::EncoderFactory( static_cast<unsigned>( bytestreamNumber ),
-                                                          cVector_, vTemp, codecPath ) );
+      if ( ( packetMaxLength_ <= cPacketMinSize ) || ( targetPacketSize_ > DATA_PACKET_MAX ) )
+      {
+         throw E57_EXCEPTION2( ErrorBadAPIArgument,
+                               "targetPacketSize=" + toString( targetPacketSize_ ) +
+                                  " imageFileName=" + cVector_->imageFileName() +
+                                  " cvPathName=" + cVector_->pathName() );
       }
 
-      // The bytestreams_ vector must be ordered by bytestreamNumber, not by order
-      // called specified sbufs, so sort it.
-      sort( bytestreams_.begin(), bytestreams_.end(), SortByBytestreamNumber() );
-#if ( E57_VALIDATION_LEVEL == VALIDATION_DEEP )
-      // Double check that all bytestreams are specified
-      for ( unsigned i = 0; i < bytestreams_.size(); i++ )
+#ifdef E57_WRITE_CRAZY_PACKET_MODE
+      //??? depends on number of streams
+      targetPacketSize_ = 500;
+      packetMaxLength_ = targetPacketSize_;
+#endif
+
+      // Aligned packets fill whole pages, so the gap after one doesn't waste most of a page, and
+      // stop there instead of running on into another one
+      if ( alignPacketsToPages_ )
       {
-         if ( bytestreams_.at( i )->bytestreamNumber() != i )
-         {
-            throw E57_EXCEPTION2( ErrorInternal,
-                                  "bytestreamIndex=" + toString( i ) + " bytestreamNumber=" +
-                                     toString( bytestreams_.at( i )->bytestreamNumber() ) );
-         }
+         constexpr size_t cPageSize = CheckedFile::logicalPageSize;
+         constexpr size_t cMaxPages = DATA_PACKET_MAX / cPageSize;
+
+         const size_t cPages =
+            std::min( ( targetPacketSize_ + cPageSize - 1 ) / cPageSize, cMaxPages );
+
+         targetPacketSize_ = cPages * cPageSize;
+         packetMaxLength_ = targetPacketSize_;
       }
-#endif
 
       ImageFileImplSharedPtr imf( ni->destImageFile_ );
 
+      // The gaps before aligned packets are filled by empty packets, whose lengths are multiples
+      // of 4, so the section has to start on a multiple of 4 as well
+      if ( alignPacketsToPages_ )
+      {
+         imf->allocateSpace( ( 4 - imf->unusedLogicalStart_ % 4 ) % 4, true );
+      }
+
       // Reserve space for CompressedVector binary section header, record location
       // so can save to when writer closes. Request that file be extended with
       // zeros since we will write to it at a later time (when writer closes).
       sectionHeaderLogicalStart_ =
          imf->allocateSpace( sizeof( CompressedVectorSectionHeader ), true );
 
+      if ( options.asyncWrite )
+      {
+         writeQueue_.reset( new WriteBehindQueue( imf, WriteQueueMaxPackets ) );
+      }
+
+      stage_.reset( new PagedWriteBuffer( imf, WriteStagePages, writeQueue_.get() ) );
+
       sectionLogicalLength_ = 0;
       dataPhysicalOffset_ = 0;
       topIndexPhysicalOffset_ = 0;
@@ -177,12 +253,22 @@ namespace e57
       // file. Know we are done when totalOutputAvailable() returns 0 after a
       // flush().
       flush();
-      while ( totalOutputAvailable() > 0 )
+      while ( totalOutputAvailable( bytestreams_ ) > 0 )
       {
          packetWrite();
          flush();
       }
 
+      // The data packets have to be on disk before the index and header are written
+      stage_->flush();
+      stage_.reset();
+
+      if ( writeQueue_ )
+      {
+         writeQueue_->finish();
+         writeQueue_.reset();
+      }
+
       // Write one index packet (required by standard).
       packetWriteIndex();
 
@@ -219,9 +305,25 @@ namespace e57
       cVector_->setRecordCount( recordCount_ );
       cVector_->setBinarySectionLogicalStart( sectionHeaderLogicalStart_ );
 
-      // Free channels
+      // Free channels, keeping what they have seen
+      addValueRanges( bytestreams_ );
       bytestreams_.clear();
 
+      // Hand the ranges on, so they outlive this writer
+      if ( fieldRangeSink_ )
+      {
+         for ( const auto &sbuf : sbufs_ )
+         {
+            double minimum = 0.0;
+            double maximum = 0.0;
+
+            if ( fieldRange( sbuf.pathName(), minimum, maximum ) )
+            {
+               fieldRangeSink_( sbuf.pathName(), minimum, maximum );
+            }
+         }
+      }
+
 #ifdef E57_VERBOSE
       std::cout << "  CompressedVectorWriter:" << std::endl;
       dump( 4 );
@@ -241,6 +343,41 @@ namespace e57
       return cVector_;
    }
 
+   bool CompressedVectorWriterImpl::fieldRange( const ustring &pathName, double &minimum,
+                                                double &maximum ) const
+   {
+      // don't checkImageFileOpen or checkWriterOpen, the ranges outlive both
+
+      if ( !collectStatistics_ )
+      {
+         return false;
+      }
+
+      NodeImplSharedPtr node = proto_->get( pathName );
+      uint64_t bytestreamNumber = 0;
+      if ( !proto_->findTerminalPosition( node, bytestreamNumber ) )
+      {
+         throw E57_EXCEPTION2( ErrorBadAPIArgument, "pathName=" + pathName );
+      }
+
+      ValueRange range = valueRanges_.at( static_cast<size_t>( bytestreamNumber ) );
+
+      // Encoders are sorted by bytestream number
+      if ( !bytestreams_.empty() )
+      {
+         range.add( bytestreams_.at( static_cast<size_t>( bytestreamNumber ) )->valueRange() );
+      }
+
+      if ( range.empty() )
+      {
+         return false;
+      }
+
+      minimum = range.minimum;
+      maximum = range.maximum;
+      return true;
+   }
+
    void CompressedVectorWriterImpl::setBuffers( std::vector<SourceDestBuffer> &sbufs )
    {
       // don't checkImageFileOpen
@@ -274,6 +411,64 @@ namespace e57
       sbufs_ = sbufs;
    }
 
+   CompressedVectorWriterImpl::EncoderList CompressedVectorWriterImpl::makeEncoders(
+      std::vector<SourceDestBuffer> &sbufs ) const
+   {
+      EncoderList encoders;
+
+      // For each individual sbuf, create an appropriate Encoder based on the
+      // cVector_ attributes
+      for ( unsigned i = 0; i < sbufs.size(); i++ )
+      {
+         // Create vector of single sbuf  ??? for now, may have groups later
+         std::vector<SourceDestBuffer> vTemp;
+         vTemp.push_back( sbufs.at( i ) );
+
+         ustring codecPath = sbufs.at( i ).pathName();
+
+         // Calc which stream the given path belongs to.  This depends on position
+         // of the node in the proto tree.
+         NodeImplSharedPtr readNode = proto_->get( sbufs.at( i ).pathName() );
+         uint64_t bytestreamNumber = 0;
+         if ( !proto_->findTerminalPosition( readNode, bytestreamNumber ) )
+         {
+            throw E57_EXCEPTION2( ErrorInternal, "sbufIndex=" + toString( i ) );
+         }
+
+         // EncoderFactory picks the appropriate encoder to match type declared in
+         // prototype
+         encoders.push_back( Encoder::EncoderFactory( static_cast<unsigned>( bytestreamNumber ),
+                                                      cVector_, vTemp, codecPath,
+                                                      encoderBufferSize_ ) );
+      }
+
+      if ( collectStatistics_ )
+      {
+         for ( auto &encoder : encoders )
+         {
+            encoder->trackValueRange();
+         }
+      }
+
+      // The encoders must be ordered by bytestreamNumber, not by order
+      // called specified sbufs, so sort it.
+      sort( encoders.begin(), encoders.end(), SortByBytestreamNumber() );
+#if ( E57_VALIDATION_LEVEL == VALIDATION_DEEP )
+      // Double check that all bytestreams are specified
+      for ( unsigned i = 0; i < encoders.size(); i++ )
+      {
+         if ( encoders.at( i )->bytestreamNumber() != i )
+         {
+            throw E57_EXCEPTION2( ErrorInternal,
+                                  "bytestreamIndex=" + toString( i ) + " bytestreamNumber=" +
+                                     toString( encoders.at( i )->bytestreamNumber() ) );
+         }
+      }
+#endif
+
+      return encoders;
+   }
+
    void CompressedVectorWriterImpl::write( std::vector<SourceDestBuffer> &sbufs,
                                            const size_t requestedRecordCount )
    {
@@ -314,98 +509,273 @@ namespace e57
          sbuf.impl()->rewind();
       }
 
-      // Loop until all channels have completed requestedRecordCount transfers
-      uint64_t endRecordIndex = recordCount_ + requestedRecordCount;
-      while ( true )
+      const uint64_t endRecordIndex = recordCount_ + requestedRecordCount;
+      const auto writePacket = [this] { packetWrite(); };
+
+      if ( chunkRecords_ > 0 )
       {
-         // Calc remaining record counts for all channels
-         uint64_t totalRecordCount = 0;
-         for ( auto &bytestream : bytestreams_ )
+         // Runs start on a multiple of 64 records, where every bytestream ends on a word boundary
+         const uint64_t runStart = std::min( ( recordCount_ + 63 ) / 64 * 64, endRecordIndex );
+         const auto chunkCount =
+            static_cast<size_t>( ( endRecordIndex - runStart ) / chunkRecords_ );
+
+         if ( chunkCount > 0 )
          {
-            totalRecordCount += endRecordIndex - bytestream->currentRecordIndex();
+            encodeRecords( bytestreams_, runStart, targetPacketSize_, &encodePool_, writePacket );
+            writeChunks( static_cast<size_t>( runStart - recordCount_ ), chunkCount );
          }
+      }
+
+      encodeRecords( bytestreams_, endRecordIndex, targetPacketSize_, &encodePool_, writePacket );
+
+      recordCount_ += requestedRecordCount;
+
+      // When we leave this function, will likely still have data in channel
+      // ioBuffers as well as partial words in Encoder registers.
+   }
+
+   void CompressedVectorWriterImpl::encodeRecords( EncoderList &streams,
+                                                   const uint64_t endRecordIndex,
+                                                   const size_t targetPacketSize, WorkerPool *pool,
+                                                   const std::function<void()> &writePacket )
+   {
+      // Bits needed per record, summed over all channels. This is exact except for strings,
+      // which use their average so far, so it is only worked out once per call.
+      float totalBitsPerRecord = 0;
+      for ( auto &bytestream : streams )
+      {
+         totalBitsPerRecord += bytestream->bitsPerRecord();
+      }
+
 #ifdef E57_VERBOSE
-         std::cout << "  totalRecordCount=" << totalRecordCount << std::endl; //???
+      std::cout << "  totalBitsPerRecord=" << totalBitsPerRecord << std::endl; //???
 #endif
 
+      // Loop until all channels have reached endRecordIndex
+      while ( true )
+      {
          // We are done if have no more work, break out of loop
-         if ( totalRecordCount == 0 )
+         const bool done =
+            std::all_of( streams.begin(), streams.end(), [=]( const auto &bytestream ) {
+               return bytestream->currentRecordIndex() >= endRecordIndex;
+            } );
+
+         if ( done )
          {
             break;
          }
 
-         // Estimate how many records can write before have enough data to fill
-         // data packet to efficient length Efficient packet length is >= 75%
-         // of maximum packet length. It is OK if get too much data (more than
-         // one packet) in an iteration. Reader will be able to handle packets
-         // whose streams are not exactly synchronized to the record
-         // boundaries. But try to do a good job of keeping the stream
-         // synchronization "close enough" (so a reader that can cache only two
-         // packets is efficient).
+         // Fill data packets to the target length, by default 75% of the maximum packet length.
+         // It is OK if get too much data (more than one packet) in an iteration. Reader will be
+         // able to handle packets whose streams are not exactly synchronized to the record
+         // boundaries. But try to do a good job of keeping the stream synchronization "close
+         // enough" (so a reader that can cache only two packets is efficient).
+         const size_t packetSize = currentPacketSize( streams );
 
 #ifdef E57_VERBOSE
-         std::cout << "  currentPacketSize()=" << currentPacketSize() << std::endl; //???
+         std::cout << "  currentPacketSize()=" << packetSize << std::endl; //???
 #endif
 
-#ifdef E57_WRITE_CRAZY_PACKET_MODE
-         //??? depends on number of streams
-         constexpr size_t E57_TARGET_PACKET_SIZE = 500;
-#else
-         constexpr size_t E57_TARGET_PACKET_SIZE = ( DATA_PACKET_MAX * 3 / 4 );
-#endif
          // If have more than target fraction of packet, send it now
-         if ( currentPacketSize() >= E57_TARGET_PACKET_SIZE )
-         { //???
-            packetWrite();
+         if ( packetSize >= targetPacketSize )
+         {
+            writePacket();
             continue; // restart loop so recalc statistics (packet size may not be
                       // zero after write, if have too much data)
          }
 
+         // Encode enough records in each channel to bring the packet up to the target size.
+         // Channels stay in step, and each gets a single processRecords() call.
+         const uint64_t plannedRecordCount =
+            recordsForPacketBytes( targetPacketSize - packetSize, totalBitsPerRecord );
+
 #ifdef E57_VERBOSE
-         //??? useful?
-         // Get approximation of number of bytes per record of CompressedVector
-         // and total of bytes used
-         float totalBitsPerRecord = 0; // an estimate of future performance
-         for ( auto &bytestream : bytestreams_ )
+         std::cout << "  plannedRecordCount=" << plannedRecordCount << std::endl; //???
+#endif
+
+         // Channels only touch their own source buffer and output, so they may be encoded
+         // concurrently. The packet is only assembled once they are all done.
+         const auto encodeStream = [&]( size_t i ) {
+            auto &bytestream = streams[i];
+
+            if ( bytestream->currentRecordIndex() < endRecordIndex )
+            {
+               const uint64_t remaining = endRecordIndex - bytestream->currentRecordIndex();
+               const uint64_t recordCount = std::min( remaining, plannedRecordCount );
+
+               bytestream->processRecords( static_cast<size_t>( recordCount ) );
+            }
+         };
+
+         const uint64_t recordsBefore = recordsEncoded( streams );
+
+         if ( pool != nullptr )
          {
-            totalBitsPerRecord += bytestream->bitsPerRecord();
+            pool->run( streams.size(), encodeStream );
+         }
+         else
+         {
+            for ( size_t i = 0; i < streams.size(); ++i )
+            {
+               encodeStream( i );
+            }
          }
 
-         const float totalBytesPerRecord = std::max( totalBitsPerRecord / 8, 0.1F ); //??? trust
+         // If nothing more could be encoded, an output buffer is full (see
+         // CompressedVectorWriterOptions::encoderBufferSize), so send what there is
+         if ( ( recordsEncoded( streams ) == recordsBefore ) &&
+              ( currentPacketSize( streams ) == packetSize ) )
+         {
+            if ( totalOutputAvailable( streams ) == 0 )
+            {
+               throw E57_EXCEPTION2( ErrorInternal, "packetSize=" + toString( packetSize ) );
+            }
 
-         std::cout << "  totalBytesPerRecord=" << totalBytesPerRecord << std::endl; //???
-#endif
+            writePacket();
+         }
+      }
+   }
+
+   void CompressedVectorWriterImpl::writeChunks( const size_t bufferBegin, const size_t chunkCount )
+   {
+      // Everything before the first run has to be in the file ahead of it. The encoders are on a
+      // word boundary, so there is nothing left in their registers.
+      while ( totalOutputAvailable( bytestreams_ ) > 0 )
+      {
+         packetWrite();
+      }
+
+      const auto chunkSize = static_cast<size_t>( chunkRecords_ );
+      const size_t waveSize = encodePool_.threadCount();
+
+      // Packets of one run, in file order
+      struct EncodedRun
+      {
+         std::vector<char> packets;
+         uint64_t packetCount = 0;
+      };
 
-         // Don't allow straggler to get too far behind. ???
-         // Don't allow a single channel to get too far ahead ???
-         // Process channels that are furthest behind first. ???
+      std::vector<DataPacket> packetBuffers( std::min( waveSize, chunkCount ) );
 
-         // !!!! For now just process one record per loop until packet is full
-         // enough, or completed request
-         for ( auto &bytestream : bytestreams_ )
+      // Encode one run per thread at a time, so only that many are held in memory
+      for ( size_t waveBegin = 0; waveBegin < chunkCount; waveBegin += waveSize )
+      {
+         const size_t waveCount = std::min( waveSize, chunkCount - waveBegin );
+
+         // Each run gets fresh encoders reading its own part of the buffers. They are made here
+         // since looking up the prototype isn't thread safe.
+         std::vector<EncoderList> runStreams( waveCount );
+         for ( size_t i = 0; i < waveCount; ++i )
          {
-            if ( bytestream->currentRecordIndex() < endRecordIndex )
+            const size_t begin = bufferBegin + ( waveBegin + i ) * chunkSize;
+
+            std::vector<SourceDestBuffer> windows;
+            for ( auto &sbuf : sbufs_ )
+            {
+               auto window = sbuf.impl()->window( begin, begin + chunkSize );
+               windows.push_back( SourceDestBuffer( window ) );
+            }
+
+            runStreams[i] = makeEncoders( windows );
+         }
+
+         std::vector<EncodedRun> runs( waveCount );
+         encodePool_.run( waveCount, [&]( size_t i ) {
+            auto &streams = runStreams[i];
+            auto &run = runs[i];
+            auto &packet = packetBuffers[i];
+
+            const auto writeRunPacket = [&] {
+               const unsigned packetLength = packetAssemble( streams, packetMaxLength_, packet );
+               const auto *bytes = reinterpret_cast<const char *>( &packet );
+
+               run.packets.insert( run.packets.end(), bytes, bytes + packetLength );
+               run.packetCount += ( packetLength > 0 ) ? 1 : 0;
+            };
+
+            encodeRecords( streams, chunkSize, targetPacketSize_, nullptr, writeRunPacket );
+
+            // Each run ends in complete packets. As in close(), a register which doesn't fit in
+            // a full output buffer is flushed after the next packet.
+            const auto flushRun = [&streams] {
+               for ( auto &bytestream : streams )
+               {
+                  bytestream->registerFlushToOutput();
+               }
+            };
+
+            flushRun();
+            while ( totalOutputAvailable( streams ) > 0 )
+            {
+               writeRunPacket();
+               flushRun();
+            }
+         } );
+
+         // Append the runs in order, each with an index entry pointing at its first packet
+         for ( size_t i = 0; i < waveCount; ++i )
+         {
+            addValueRanges( runStreams[i] );
+
+            const auto &run = runs[i];
+            if ( run.packetCount == 0 )
             {
-               // !!! For now, process up to 50 records at a time
-               uint64_t recordCount = endRecordIndex - bytestream->currentRecordIndex();
-               recordCount =
-                  ( recordCount < 50ULL ) ? recordCount : 50ULL; // min(recordCount, 50ULL);
-               bytestream->processRecords( static_cast<unsigned>( recordCount ) );
+               continue;
+            }
+
+            const uint64_t firstRecord = recordCount_ + bufferBegin + ( waveBegin + i ) * chunkSize;
+            const uint64_t packetPhysicalOffset =
+               packetWriteToFile( run.packets.data(), run.packets.size(), run.packetCount );
+
+            if ( ( firstRecord > 0 ) && ( chunkIndex_.size() + 1 < IndexPacket::MAX_ENTRIES ) )
+            {
+               chunkIndex_.push_back( { firstRecord, packetPhysicalOffset } );
             }
          }
       }
 
-      recordCount_ += requestedRecordCount;
+      // The main encoders carry on after the runs
+      for ( auto &bytestream : bytestreams_ )
+      {
+         bytestream->skipRecords( chunkCount * chunkSize );
+      }
+   }
 
-      // When we leave this function, will likely still have data in channel
-      // ioBuffers as well as partial words in Encoder registers.
+   uint64_t CompressedVectorWriterImpl::recordsForPacketBytes( size_t byteCount,
+                                                               float totalBitsPerRecord )
+   {
+      // Channels which don't produce any output (constants) can do everything in one go
+      if ( totalBitsPerRecord <= 0 )
+      {
+         return UINT64_MAX;
+      }
+
+      // Round up, so the packet reaches the target instead of creeping up on it. Bits still
+      // held in the encoders' registers may leave it a little short, which the next planning
+      // step takes care of.
+      const double recordCount = std::ceil( byteCount * 8.0 / totalBitsPerRecord );
+
+      return std::max( static_cast<uint64_t>( recordCount ), static_cast<uint64_t>( 1 ) );
+   }
+
+   // Total of the encoders' record indexes, which goes up whenever any of them takes a record
+   uint64_t CompressedVectorWriterImpl::recordsEncoded( const EncoderList &streams )
+   {
+      uint64_t total = 0;
+
+      for ( const auto &bytestream : streams )
+      {
+         total += bytestream->currentRecordIndex();
+      }
+
+      return total;
    }
 
-   size_t CompressedVectorWriterImpl::totalOutputAvailable() const
+   size_t CompressedVectorWriterImpl::totalOutputAvailable( const EncoderList &streams )
    {
       size_t total = 0;
 
-      for ( const auto &bytestream : bytestreams_ )
+      for ( const auto &bytestream : streams )
       {
          total += bytestream->outputAvailable();
       }
@@ -413,11 +783,19 @@ namespace e57
       return total;
    }
 
-   size_t CompressedVectorWriterImpl::currentPacketSize() const
+   void CompressedVectorWriterImpl::addValueRanges( const EncoderList &streams )
+   {
+      for ( const auto &bytestream : streams )
+      {
+         valueRanges_.at( bytestream->bytestreamNumber() ).add( bytestream->valueRange() );
+      }
+   }
+
+   size_t CompressedVectorWriterImpl::currentPacketSize( const EncoderList &streams )
    {
       // Calc current packet size
-      return ( sizeof( DataPacketHeader ) + bytestreams_.size() * sizeof( uint16_t ) +
-               totalOutputAvailable() );
+      return ( sizeof( DataPacketHeader ) + streams.size() * sizeof( uint16_t ) +
+               totalOutputAvailable( streams ) );
    }
 
    uint64_t CompressedVectorWriterImpl::packetWrite()
@@ -426,20 +804,72 @@ namespace e57
       std::cout << "CompressedVectorWriterImpl::packetWrite() called" << std::endl; //???
 #endif
 
+      std::vector<size_t> count;
+      const unsigned packetLength = packetPlan( bytestreams_, packetMaxLength_, count );
+
       // Double check that we have work to do
-      const size_t cTotalOutput = totalOutputAvailable();
-      if ( cTotalOutput == 0 )
+      if ( packetLength == 0 )
       {
          return ( 0 );
       }
 
-      // const bytestreams_ so it's clear it isn't modified in this function
-      const auto &cStreams = bytestreams_;
+      // Get smart pointer to ImageFileImpl from associated CompressedVector
+      ImageFileImplSharedPtr imf( cVector_->destImageFile_ );
+
+      packetAlign();
+
+      // Assemble the packet straight into the pages it will be written from
+      const uint64_t packetLogicalOffset = imf->allocateSpace( packetLength, false );
+
+      StagedPacketOutput output{ *stage_, packetLogicalOffset };
+      packetEmit( bytestreams_, count, packetLength, output );
+
+      // Return physical offset of data packet for potential use in seekIndex
+      return packetWritten( imf->file_->logicalToPhysical( packetLogicalOffset ), 1 );
+   }
+
+   // Fill dataPacket from the encoders' output and return its length, or 0 if they don't have
+   // any output. Doesn't touch the writer, so runs may be assembled on different threads.
+   unsigned CompressedVectorWriterImpl::packetAssemble( const EncoderList &streams,
+                                                        const size_t packetMaxLength,
+                                                        DataPacket &dataPacket )
+   {
+      std::vector<size_t> count;
+      const unsigned packetLength = packetPlan( streams, packetMaxLength, count );
+
+      if ( packetLength == 0 )
+      {
+         return 0;
+      }
+
+      DataPacketOutput output{ reinterpret_cast<char *>( &dataPacket ) };
+      packetEmit( streams, count, packetLength, output );
+
+      // Double check that data packet is well formed
+      dataPacket.verify( packetLength );
+
+      return packetLength;
+   }
+
+   // Work out how many bytes of each encoder's output go in the next data packet, which is at most
+   // packetMaxLength long (a multiple of 4), and return its length including padding, or 0 if
+   // they don't have any output.
+   unsigned CompressedVectorWriterImpl::packetPlan( const EncoderList &streams,
+                                                    const size_t packetMaxLength,
+                                                    std::vector<size_t> &count )
+   {
+      const size_t cTotalOutput = totalOutputAvailable( streams );
+      if ( cTotalOutput == 0 )
+      {
+         return 0;
+      }
+
+      const auto &cStreams = streams;
       const auto cNumByteStreams = cStreams.size();
 
       // Calc maximum number of bytestream values can put in data packet.
       const size_t cPacketMaxPayloadBytes =
-         DATA_PACKET_MAX - sizeof( DataPacketHeader ) - cNumByteStreams * sizeof( uint16_t );
+         packetMaxLength - sizeof( DataPacketHeader ) - cNumByteStreams * sizeof( uint16_t );
 
 #ifdef E57_VERBOSE
       std::cout << "  totalOutput=" << cTotalOutput << std::endl;
@@ -447,8 +877,8 @@ namespace e57
       std::cout << "  packetMaxPayloadBytes=" << cPacketMaxPayloadBytes << std::endl;
 #endif
 
-      // Allocate vector for number of bytes that each bytestream will write to file.
-      std::vector<size_t> count( cNumByteStreams );
+      // Number of bytes that each bytestream will write to file.
+      count.assign( cNumByteStreams, 0 );
 
       // See if we can fit into a single data packet
       if ( cTotalOutput < cPacketMaxPayloadBytes )
@@ -481,11 +911,11 @@ namespace e57
       }
 #endif
 
-#if VALIDATE_BASIC
-      // Double check sum of count is <= packetMaxPayloadBytes
       const size_t cTotalByteCount =
          std::accumulate( count.begin(), count.end(), static_cast<size_t>( 0 ) );
 
+#if VALIDATE_BASIC
+      // Double check sum of count is <= packetMaxPayloadBytes
       if ( cTotalByteCount > cPacketMaxPayloadBytes )
       {
          throw E57_EXCEPTION2( ErrorInternal,
@@ -494,112 +924,161 @@ namespace e57
       }
 #endif
 
-      // Get smart pointer to ImageFileImpl from associated CompressedVector
-      ImageFileImplSharedPtr imf( cVector_->destImageFile_ );
+      // packetLength must be multiple of 4, the rest is zero padding
+      const size_t cPacketLength =
+         sizeof( DataPacketHeader ) + cNumByteStreams * sizeof( uint16_t ) + cTotalByteCount;
 
-      // Use temp buf in object (is 64KBytes long) instead of allocating each time here
-      char *packet = reinterpret_cast<char *>( &dataPacket_ );
-
-      // To be safe, clear header part of packet
-      dataPacket_.header.reset();
-
-      // Write bytestreamBufferLength[bytestreamCount] after header, in dataPacket_
-      auto bsbLength = reinterpret_cast<uint16_t *>( &packet[sizeof( DataPacketHeader )] );
 #ifdef E57_VERBOSE
-      std::cout << "  packet=" << static_cast<void *>( packet ) << std::endl; //???
-      std::cout << "  bsbLength=" << bsbLength << std::endl;                  //???
+      std::cout << "  packetLength=" << cPacketLength << std::endl; //???
 #endif
-      for ( unsigned i = 0; i < cNumByteStreams; ++i )
+
+      return static_cast<unsigned>( ( cPacketLength + 3 ) / 4 * 4 );
+   }
+
+   // Put the header, bytestream lengths, bytestream contents and padding of a data packet
+   // planned by packetPlan() into output, in that order. output.next( n ) returns where the next
+   // n bytes go, reducing n if less than that fits there.
+   template <typename Output>
+   void CompressedVectorWriterImpl::packetEmit( const EncoderList &streams,
+                                                const std::vector<size_t> &count,
+                                                unsigned packetLength, Output &output )
+   {
+      const auto cNumByteStreams = streams.size();
+
+      const auto put = [&output]( const void *bytes, size_t length ) {
+         const auto *src = static_cast<const char *>( bytes );
+         while ( length > 0 )
+         {
+            size_t n = length;
+            memcpy( output.next( n ), src, n );
+            src += n;
+            length -= n;
+         }
+      };
+
+      DataPacketHeader header;
+      header.reset();
+      header.packetLogicalLengthMinus1 =
+         static_cast<uint16_t>( packetLength - 1 ); // %%% Truncation
+      header.bytestreamCount = static_cast<uint16_t>( cNumByteStreams ); // %%% Truncation
+
+      // Double check that the header is well formed
+      header.verify( packetLength );
+
+      put( &header, sizeof( header ) );
+
+      // bytestreamBufferLength[bytestreamCount] follows the header
+      size_t used = sizeof( header ) + cNumByteStreams * sizeof( uint16_t );
+      for ( size_t i = 0; i < cNumByteStreams; ++i )
       {
-         bsbLength[i] = static_cast<uint16_t>( count.at( i ) ); // %%% Truncation
-#ifdef E57_VERBOSE
-         std::cout << "  Writing " << bsbLength[i] << " bytes into bytestream " << i
-                   << std::endl; //???
-#endif
+         const auto bsbLength = static_cast<uint16_t>( count.at( i ) ); // %%% Truncation
+         put( &bsbLength, sizeof( bsbLength ) );
       }
 
-      // Get pointer to end of data so far
-      auto *p = reinterpret_cast<char *>( &bsbLength[cNumByteStreams] );
-#ifdef E57_VERBOSE
-      std::cout << "  after bsbLength, p=" << static_cast<void *>( p ) << std::endl; //???
-#endif
-
-      // Write contents of each bytestream in dataPacket_
+      // Read contents of each bytestream from encoder output into packet
       for ( size_t i = 0; i < cNumByteStreams; ++i )
       {
-         size_t n = count.at( i );
+         size_t remaining = count.at( i );
+         while ( remaining > 0 )
+         {
+            size_t n = remaining;
+            char *dest = output.next( n );
 
-#if VALIDATE_BASIC
-         // Double check we aren't accidentally going to write off end of vector<char>
-         if ( &p[n] > &packet[DATA_PACKET_MAX] )
+            streams.at( i )->outputRead( dest, n );
+            remaining -= n;
+         }
+
+         used += count.at( i );
+      }
+
+      // Zero padding up to packetLength
+      size_t padding = packetLength - used;
+      while ( padding > 0 )
+      {
+         size_t n = padding;
+         memset( output.next( n ), 0, n );
+         padding -= n;
+      }
+   }
+
+   // Write packetCount whole data packets, one after the other, at the beginning of free space in
+   // the file. Returns the physical offset of the first one.
+   uint64_t CompressedVectorWriterImpl::packetWriteToFile( const char *packets, size_t length,
+                                                          uint64_t packetCount )
+   {
+      // Get smart pointer to ImageFileImpl from associated CompressedVector
+      ImageFileImplSharedPtr imf( cVector_->destImageFile_ );
+
+      // The packets go out in one piece, unless each has to be moved up to a page boundary
+      uint64_t firstLogicalOffset = 0;
+      size_t used = 0;
+
+      while ( used < length )
+      {
+         size_t pieceLength = length - used;
+
+         if ( alignPacketsToPages_ )
          {
-            throw E57_EXCEPTION2( ErrorInternal, "n=" + toString( n ) );
+            const auto &header = *reinterpret_cast<const DataPacketHeader *>( packets + used );
+            pieceLength = header.packetLogicalLengthMinus1 + 1u;
+
+            packetAlign();
          }
-#endif
 
-         // Read from encoder output into packet
-         cStreams.at( i )->outputRead( p, n );
+         const uint64_t logicalOffset = imf->allocateSpace( pieceLength, false );
+
+         stage_->write( logicalOffset, packets + used, pieceLength );
 
-         // Move pointer to end of current data
-         p += n;
+         if ( used == 0 )
+         {
+            firstLogicalOffset = logicalOffset;
+         }
+
+         used += pieceLength;
       }
 
-      // Length of packet is difference in beginning pointer and ending pointer
-      auto packetLength = static_cast<unsigned>( p - packet ); //??? pointer diff portable?
-#ifdef E57_VERBOSE
-      std::cout << "  packetLength=" << packetLength << std::endl; //???
-#endif
+      return packetWritten( imf->file_->logicalToPhysical( firstLogicalOffset ), packetCount );
+   }
 
-#if VALIDATE_BASIC
-      // Double check that packetLength is what we expect
-      if ( packetLength !=
-           sizeof( DataPacketHeader ) + cNumByteStreams * sizeof( uint16_t ) + cTotalByteCount )
+   // If packets are aligned, fill the space up to the next page boundary with an empty packet, so
+   // the next data packet starts a page.
+   void CompressedVectorWriterImpl::packetAlign()
+   {
+      if ( !alignPacketsToPages_ )
       {
-         throw E57_EXCEPTION2( ErrorInternal, "packetLength=" + toString( packetLength ) +
-                                                 " bytestreamSize=" +
-                                                 toString( cNumByteStreams * sizeof( uint16_t ) ) +
-                                                 " totalByteCount=" + toString( cTotalByteCount ) );
+         return;
       }
-#endif
 
-      // packetLength must be multiple of 4, if not, add some zero padding
-      while ( packetLength % 4 )
+      ImageFileImplSharedPtr imf( cVector_->destImageFile_ );
+
+      constexpr size_t cPageSize = CheckedFile::logicalPageSize;
+      const auto cGap =
+         static_cast<size_t>( ( cPageSize - imf->unusedLogicalStart_ % cPageSize ) % cPageSize );
+
+      if ( cGap == 0 )
       {
-         // Double check we aren't accidentally going to write off end of
-         // vector<char>
-         if ( p >= &packet[DATA_PACKET_MAX - 1] )
-         {
-            throw E57_EXCEPTION1( ErrorInternal );
-         }
-         *p++ = 0;
-         packetLength++;
-#ifdef E57_VERBOSE
-         std::cout << "  padding with zero byte, new packetLength=" << packetLength
-                   << std::endl; //???
-#endif
+         return;
       }
 
-      // Prepare header in dataPacket_, now that we are sure of packetLength
-      dataPacket_.header.packetLogicalLengthMinus1 =
-         static_cast<uint16_t>( packetLength - 1 ); // %%% Truncation
-      dataPacket_.header.bytestreamCount =
-         static_cast<uint16_t>( cNumByteStreams ); // %%% Truncation
+      char padding[cPageSize] = {};
 
-      // Double check that data packet is well formed
-      dataPacket_.verify( packetLength );
+      EmptyPacketHeader header;
+      header.packetLogicalLengthMinus1 = static_cast<uint16_t>( cGap - 1 );
 
-      // Write whole data packet at beginning of free space in file
-      uint64_t packetLogicalOffset = imf->allocateSpace( packetLength, false );
-      uint64_t packetPhysicalOffset = imf->file_->logicalToPhysical( packetLogicalOffset );
-      imf->file_->seek( packetLogicalOffset ); //??? have seekLogical and seekPhysical instead?
-                                               // more explicit
-      imf->file_->write( packet, packetLength );
+      // Double check that the gap can be filled by a packet
+      header.verify( cGap );
 
-#ifdef E57_VERBOSE
-//  std::cout << "data packet:" << std::endl;
-//  dataPacket_.dump(4);
-#endif
+      memcpy( padding, &header, sizeof( header ) );
+
+      const uint64_t logicalOffset = imf->allocateSpace( cGap, false );
 
+      stage_->write( logicalOffset, padding, cGap );
+   }
+
+   // Account for packetCount data packets written at packetPhysicalOffset, and return it.
+   uint64_t CompressedVectorWriterImpl::packetWritten( uint64_t packetPhysicalOffset,
+                                                       uint64_t packetCount )
+   {
       // If first data packet written for this CompressedVector binary section,
       // save address to put in section header
       //??? what if no data packets?
@@ -610,20 +1089,15 @@ namespace e57
       {
          dataPhysicalOffset_ = packetPhysicalOffset;
       }
-      dataPacketsCount_++;
+      dataPacketsCount_ += packetCount;
 
-      // !!! update seekIndex here? if started new chunk?
-
-      // Return physical offset of data packet for potential use in seekIndex
-      return ( packetPhysicalOffset ); //??? needed
+      return ( packetPhysicalOffset );
    }
 
    // If we don't have any records, write a packet which is only the header + zero padding.
    // Code is a simplified version of packetWrite().
    void CompressedVectorWriterImpl::packetWriteZeroRecords()
    {
-      ImageFileImplSharedPtr imf( cVector_->destImageFile_ );
-
       dataPacket_.header.reset();
 
       // Use temp buf in object (is 64KBytes long) instead of allocating each time here
@@ -647,25 +1121,13 @@ namespace e57
       dataPacket_.verify( packetLength );
 
       // Write packet at beginning of free space in file
-      uint64_t packetLogicalOffset = imf->allocateSpace( packetLength, false );
-      uint64_t packetPhysicalOffset = imf->file_->logicalToPhysical( packetLogicalOffset );
-
-      imf->file_->seek( packetLogicalOffset );
-      imf->file_->write( packet, packetLength );
-
-      // If first data packet written for this CompressedVector binary section,
-      // save address to put in section header
-      if ( dataPacketsCount_ == 0 )
-      {
-         dataPhysicalOffset_ = packetPhysicalOffset;
-      }
-
-      dataPacketsCount_++;
+      packetWriteToFile( packet, packetLength, 1 );
    }
 
    // Write one index packet.
    // We don't have an interface to work with index packets, but one is required by the standard, so
-   // write one index packet with one entry pointing to the first data packet.
+   // write one index packet with one entry pointing to the first data packet, followed by one for
+   // each independently encoded run.
    void e57::CompressedVectorWriterImpl::packetWriteIndex()
    {
       ImageFileImplSharedPtr imf( cVector_->destImageFile_ );
@@ -674,10 +1136,14 @@ namespace e57
 
       indexPacket.entries[0].chunkPhysicalOffset = dataPhysicalOffset_;
 
-      const auto cPacketLength = sizeof( IndexPacketHeader ) + sizeof( IndexPacket::Entry );
+      std::copy( chunkIndex_.begin(), chunkIndex_.end(), &indexPacket.entries[1] );
+
+      const auto cEntryCount = 1 + chunkIndex_.size();
+      const auto cPacketLength =
+         sizeof( IndexPacketHeader ) + cEntryCount * sizeof( IndexPacket::Entry );
 
-      indexPacket.header.packetLogicalLengthMinus1 = cPacketLength - 1;
-      indexPacket.header.entryCount = 1;
+      indexPacket.header.packetLogicalLengthMinus1 = static_cast<uint16_t>( cPacketLength - 1 );
+      indexPacket.header.entryCount = static_cast<uint16_t>( cEntryCount );
 
       uint64_t packetLogicalOffset = imf->allocateSpace( cPacketLength, false );
       topIndexPhysicalOffset_ = imf->file_->logicalToPhysical( packetLogicalOffset );
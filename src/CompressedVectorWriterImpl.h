@@ -26,8 +26,13 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <functional>
+
 #include "Encoder.h"
+#include "PagedWriteBuffer.h"
 #include "Packet.h"
+#include "WorkerPool.h"
+#include "WriteBehindQueue.h"
 
 namespace e57
 {
@@ -35,7 +40,8 @@ namespace e57
    {
    public:
       CompressedVectorWriterImpl( std::shared_ptr<CompressedVectorNodeImpl> ni,
-                                  std::vector<SourceDestBuffer> &sbufs );
+                                  std::vector<SourceDestBuffer> &sbufs,
+                                  const CompressedVectorWriterOptions &options );
       ~CompressedVectorWriterImpl();
 
       void write( size_t requestedRecordCount );
@@ -43,6 +49,7 @@ namespace e57
       bool isOpen() const;
       std::shared_ptr<CompressedVectorNodeImpl> compressedVectorNode() const;
       void close();
+      bool fieldRange( const ustring &pathName, double &minimum, double &maximum ) const;
 
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
       void dump( int indent = 0, std::ostream &os = std::cout );
@@ -53,10 +60,30 @@ namespace e57
                                const char *srcFunctionName ) const;
       void checkWriterOpen( const char *srcFileName, int srcLineNumber,
                             const char *srcFunctionName ) const;
+      using EncoderList = std::vector<std::shared_ptr<Encoder>>;
+
       void setBuffers( std::vector<SourceDestBuffer> &sbufs ); //???needed?
-      size_t totalOutputAvailable() const;
-      size_t currentPacketSize() const;
+      EncoderList makeEncoders( std::vector<SourceDestBuffer> &sbufs ) const;
+      static void encodeRecords( EncoderList &streams, uint64_t endRecordIndex,
+                                 size_t targetPacketSize, WorkerPool *pool,
+                                 const std::function<void()> &writePacket );
+      void writeChunks( size_t bufferBegin, size_t chunkCount );
+      static uint64_t recordsForPacketBytes( size_t byteCount, float totalBitsPerRecord );
+      static uint64_t recordsEncoded( const EncoderList &streams );
+      static size_t totalOutputAvailable( const EncoderList &streams );
+      void addValueRanges( const EncoderList &streams );
+      static size_t currentPacketSize( const EncoderList &streams );
+      static unsigned packetAssemble( const EncoderList &streams, size_t packetMaxLength,
+                                      DataPacket &packet );
+      static unsigned packetPlan( const EncoderList &streams, size_t packetMaxLength,
+                                  std::vector<size_t> &count );
+      template <typename Output>
+      static void packetEmit( const EncoderList &streams, const std::vector<size_t> &count,
+                              unsigned packetLength, Output &output );
+      uint64_t packetWriteToFile( const char *packets, size_t length, uint64_t packetCount );
+      uint64_t packetWritten( uint64_t packetPhysicalOffset, uint64_t packetCount );
       uint64_t packetWrite();
+      void packetAlign();
       void packetWriteZeroRecords();
       void packetWriteIndex();
 
@@ -66,9 +93,53 @@ namespace e57
       std::shared_ptr<CompressedVectorNodeImpl> cVector_;
       NodeImplSharedPtr proto_;
 
-      std::vector<std::shared_ptr<Encoder>> bytestreams_;
+      EncoderList bytestreams_;
       DataPacket dataPacket_;
 
+      /// Threads the bytestreams are encoded on (see CompressedVectorWriterOptions::encodeThreads)
+      WorkerPool encodePool_;
+
+      /// Size of each encoder's output buffer (see
+      /// CompressedVectorWriterOptions::encoderBufferSize)
+      size_t encoderBufferSize_;
+
+      /// Records per independently encoded run, 0 if not used (see
+      /// CompressedVectorWriterOptions::chunkRecords)
+      uint64_t chunkRecords_;
+
+      /// Index entries for the runs written so far, after the implicit one for record 0
+      std::vector<IndexPacket::Entry> chunkIndex_;
+
+      /// Whether encoders track the range of their values (see
+      /// CompressedVectorWriterOptions::collectStatistics)
+      bool collectStatistics_;
+
+      /// Called with each field's value range on close (see
+      /// CompressedVectorWriterOptions::fieldRangeSink)
+      std::function<void( const ustring &, double, double )> fieldRangeSink_;
+
+      /// Size data packets are filled to before they are written, and the most they hold (see
+      /// CompressedVectorWriterOptions::targetPacketSize)
+      size_t targetPacketSize_;
+
+      /// Whether data packets start on page boundaries (see
+      /// CompressedVectorWriterOptions::alignPacketsToPages)
+      bool alignPacketsToPages_;
+
+      /// Longest data packet written: #targetPacketSize_ rounded down to a multiple of 4 bytes
+      size_t packetMaxLength_;
+
+      /// Value ranges by bytestream number, from the encoders which are gone (those of the runs,
+      /// and all of them once closed)
+      std::vector<ValueRange> valueRanges_;
+
+      /// Writes data packets to the file in the background, if asked for (see
+      /// CompressedVectorWriterOptions::asyncWrite)
+      std::unique_ptr<WriteBehindQueue> writeQueue_;
+
+      /// Pages data packets are assembled in before being written (by writeQueue_ if there is one)
+      std::unique_ptr<PagedWriteBuffer> stage_;
+
       bool isOpen_;
       uint64_t sectionHeaderLogicalStart_; /// start of CompressedVector binary section
       uint64_t sectionLogicalLength_;      /// total length of CompressedVector binary section
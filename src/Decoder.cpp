@@ -30,6 +30,7 @@
 
 #include "CompressedVectorNodeImpl.h"
 #include "Decoder.h"
+#include "DeltaCodec.h"
 #include "FloatNodeImpl.h"
 #include "ImageFileImpl.h"
 #include "IntegerNodeImpl.h"
@@ -56,6 +57,15 @@ std::shared_ptr<Decoder> Decoder::DecoderFactory( unsigned bytestreamNumber, //!
    decodeNode->dump( 2 );
 #endif
 
+   // The delta codec only takes integers
+   const FieldCodec codec = cVector->fieldCodec( path );
+   if ( ( codec == FieldCodec::Delta ) && ( decodeNode->type() != TypeInteger ) &&
+        ( decodeNode->type() != TypeScaledInteger ) )
+   {
+      throw E57_EXCEPTION2( ErrorBadCodecs, "pathName=" + path +
+                                               " nodeType=" + toString( decodeNode->type() ) );
+   }
+
    uint64_t maxRecordCount = cVector->childCount();
 
    switch ( decodeNode->type() )
@@ -83,6 +93,14 @@ std::shared_ptr<Decoder> Decoder::DecoderFactory( unsigned bytestreamNumber, //!
             return decoder;
          }
 
+         if ( codec == FieldCodec::Delta )
+         {
+            std::shared_ptr<Decoder> decoder( new DeltaIntegerDecoder(
+               false, bytestreamNumber, dbufs.at( 0 ), ini->minimum(), ini->maximum(), 1.0, 0.0,
+               maxRecordCount ) );
+            return decoder;
+         }
+
          if ( bitsPerRecord <= 8 )
          {
             std::shared_ptr<Decoder> decoder( new BitpackIntegerDecoder<uint8_t>(
@@ -138,6 +156,14 @@ std::shared_ptr<Decoder> Decoder::DecoderFactory( unsigned bytestreamNumber, //!
             return decoder;
          }
 
+         if ( codec == FieldCodec::Delta )
+         {
+            std::shared_ptr<Decoder> decoder( new DeltaIntegerDecoder(
+               true, bytestreamNumber, dbufs.at( 0 ), sini->minimum(), sini->maximum(),
+               sini->scale(), sini->offset(), maxRecordCount ) );
+            return decoder;
+         }
+
          if ( bitsPerRecord <= 8 )
          {
             std::shared_ptr<Decoder> decoder( new BitpackIntegerDecoder<uint8_t>(
@@ -197,10 +223,39 @@ Decoder::Decoder( unsigned bytestreamNumber ) : bytestreamNumber_( bytestreamNum
 {
 }
 
+void Decoder::setDecimation( uint64_t decimation )
+{
+   if ( decimation == 0 )
+   {
+      throw E57_EXCEPTION2( ErrorBadAPIArgument, "decimation=" + toString( decimation ) );
+   }
+
+   decimation_ = decimation;
+}
+
+uint64_t Decoder::recordSpanForDest( uint64_t recordIndex, size_t destRecords ) const
+{
+   if ( destRecords == 0 )
+   {
+      return 0;
+   }
+
+   // The last record we can keep is (destRecords - 1) decimation steps past the first kept one.
+   const uint64_t firstKept = nextKeptRecordOffset( recordIndex );
+   const uint64_t steps = static_cast<uint64_t>( destRecords - 1 );
+
+   if ( steps > ( UINT64_MAX - firstKept - 1 ) / decimation_ )
+   {
+      return UINT64_MAX;
+   }
+
+   return firstKept + steps * decimation_ + 1;
+}
+
 BitpackDecoder::BitpackDecoder( unsigned bytestreamNumber, SourceDestBuffer &dbuf,
                                 unsigned alignmentSize, uint64_t maxRecordCount ) :
    Decoder( bytestreamNumber ), maxRecordCount_( maxRecordCount ), destBuffer_( dbuf.impl() ),
-   inBuffer_( 1024 ), // !!! need to pick smarter channel buffer sizes
+   inBuffer_( CarryBufferSize ),
    inBufferAlignmentSize_( alignmentSize ), bitsPerWord_( 8 * alignmentSize ),
    bytesPerWord_( alignmentSize )
 {
@@ -222,84 +277,132 @@ size_t BitpackDecoder::inputProcess( const char *source, const size_t availableB
    std::cout << "BitpackDecoder::inputprocess() called, source=" << ( source ? source : "none" )
              << " availableByteCount=" << availableByteCount << std::endl;
 #endif
-   size_t bytesUnsaved = availableByteCount;
-   size_t bitsEaten = 0;
-   do
+   // Anything left in inBuffer_ is less than a whole record, so there's nothing to do without
+   // more input.
+   if ( ( source == nullptr ) || ( availableByteCount == 0 ) )
    {
-      size_t byteCount =
-         std::min( bytesUnsaved, inBuffer_.size() - static_cast<size_t>( inBufferEndByte_ ) );
+      return 0;
+   }
 
-      // Copy input bytes from caller, if any
-      if ( ( byteCount > 0 ) && ( source != nullptr ) )
-      {
-         memcpy( &inBuffer_[inBufferEndByte_], source, byteCount );
+   size_t bytesEaten = 0;
 
-         // Advance tail pointer.
-         inBufferEndByte_ += byteCount;
+   // If the previous input ended part way through a record, finish it off first.
+   if ( inBufferEndByte_ > 0 )
+   {
+      bytesEaten = inputProcessCarry( source, availableByteCount );
 
-         // Update amount available from caller
-         bytesUnsaved -= byteCount;
-         source += byteCount;
-      }
-#ifdef E57_VERBOSE
+      if ( inBufferEndByte_ > 0 )
       {
-         unsigned i;
-         unsigned firstByte = inBufferFirstBit_ / 8;
-         for ( i = 0; i < byteCount && i < 20; i++ )
-         {
-            std::cout << "  inBuffer[" << firstByte + i
-                      << "]=" << (unsigned)(unsigned char)( inBuffer_[firstByte + i] ) << std::endl;
-         }
-         if ( i < byteCount )
-         {
-            std::cout << "  " << byteCount - i << "source bytes unprinted..." << std::endl;
-         }
+         return bytesEaten;
       }
-#endif
+   }
 
-      // ??? fix doc for new bit interface
-      // Now that we have input stored in an aligned buffer, call derived class
-      // to try to eat some Note that end of filled buffer may not be at a
-      // natural boundary. The subclass may transfer this partial word in a
-      // full word transfer, but it must be careful to only use the defined
-      // bits. inBuffer_ is a multiple of largest word size, so this full word
-      // transfer off the end will always be in defined memory.
-
-      size_t firstWord = inBufferFirstBit_ / bitsPerWord_;
-      size_t firstNaturalBit = firstWord * bitsPerWord_;
-      size_t endBit = inBufferEndByte_ * 8;
+   // Return the number of bytes we ate/saved.
+   return bytesEaten + inputProcessDirect( source + bytesEaten, availableByteCount - bytesEaten );
+}
+
+size_t BitpackDecoder::inputProcessDirect( const char *source, const size_t byteCount )
+{
+   // Decode straight out of the caller's memory. The subclasses cope with source not being
+   // aligned and with the last word being cut short.
+   const size_t endBit = byteCount * 8;
+   size_t bitsEaten = 0;
+
+   if ( inBufferFirstBit_ < endBit )
+   {
 #ifdef E57_VERBOSE
       std::cout << "  feeding aligned decoder " << endBit - inBufferFirstBit_ << " bits."
                 << std::endl;
 #endif
-      bitsEaten =
-         inputProcessAligned( &inBuffer_[firstWord * bytesPerWord_],
-                              inBufferFirstBit_ - firstNaturalBit, endBit - firstNaturalBit );
-#ifdef E57_VERBOSE
-      std::cout << "  bitsEaten=" << bitsEaten << " firstWord=" << firstWord
-                << " firstNaturalBit=" << firstNaturalBit << " endBit=" << endBit << std::endl;
-#endif
+      bitsEaten = inputProcessAligned( source, inBufferFirstBit_, endBit );
+   }
 
 #if VALIDATE_BASIC
-      if ( bitsEaten > endBit - inBufferFirstBit_ )
+   if ( ( bitsEaten > 0 ) && ( inBufferFirstBit_ + bitsEaten > endBit ) )
+   {
+      throw E57_EXCEPTION2(
+         ErrorInternal, "bitsEaten=" + toString( bitsEaten ) + " endBit=" + toString( endBit ) +
+                           " inBufferFirstBit=" + toString( inBufferFirstBit_ ) );
+   }
+#endif
+
+   const size_t nextBit = inBufferFirstBit_ + bitsEaten;
+
+   // Whatever is left after the last record is padding.
+   if ( currentRecordIndex_ >= maxRecordCount_ )
+   {
+      inBufferFirstBit_ = 0;
+      return byteCount;
+   }
+
+   // The next record starts beyond this input (only possible right after restartAt()).
+   if ( nextBit >= endBit )
+   {
+      inBufferFirstBit_ = nextBit - endBit;
+      return byteCount;
+   }
+
+   // If what's left is only part of a record, keep it in inBuffer_ until the rest arrives. This
+   // is at most a few bytes. Otherwise the dest buffer is full, and the caller keeps the rest.
+   const unsigned bits = recordBits();
+   if ( ( bits > 0 ) && ( endBit - nextBit < bits ) )
+   {
+      const size_t carryByte = nextBit / 8;
+
+      inBufferEndByte_ = byteCount - carryByte;
+      memcpy( inBuffer_.data(), &source[carryByte], inBufferEndByte_ );
+      inBufferFirstBit_ = nextBit % 8;
+
+      return byteCount;
+   }
+
+   inBufferFirstBit_ = nextBit % 8;
+   return nextBit / 8;
+}
+
+size_t BitpackDecoder::inputProcessCarry( const char *source, const size_t availableByteCount )
+{
+   // Top up inBuffer_ with just enough bytes to complete the record that straddles the inputs.
+   const size_t carryByteCount = inBufferEndByte_;
+   const size_t recordByteCount = ( recordBits() + 7 ) / 8;
+
+   size_t byteCount = std::min( availableByteCount, recordByteCount );
+   byteCount = std::min( byteCount, inBuffer_.size() - carryByteCount );
+
+   memcpy( &inBuffer_[carryByteCount], source, byteCount );
+   inBufferEndByte_ += byteCount;
+
+   const size_t bitsEaten =
+      inputProcessAligned( inBuffer_.data(), inBufferFirstBit_, inBufferEndByte_ * 8 );
+
+   if ( bitsEaten == 0 )
+   {
+      // Still not a whole record, so hang on to everything.
+      if ( byteCount == availableByteCount )
       {
-         throw E57_EXCEPTION2(
-            ErrorInternal, "bitsEaten=" + toString( bitsEaten ) + " endBit=" + toString( endBit ) +
-                              " inBufferFirstBit=" + toString( inBufferFirstBit_ ) );
+         return byteCount;
       }
-#endif
-      inBufferFirstBit_ += bitsEaten;
 
-      // Shift uneaten data to beginning of inBuffer_, keep on natural word
-      // boundaries.
-      inBufferShiftDown();
+      // No room in the dest buffer, so give the new bytes back.
+      inBufferEndByte_ = carryByteCount;
+      return 0;
+   }
 
-      // If the lower level processing didn't eat anything on this iteration,
-      // stop looping and tell caller how much we ate or stored.
-   } while ( bytesUnsaved > 0 && bitsEaten > 0 );
+   // Carried bytes are all used up, so the next record starts in source.
+   const size_t sourceBit = inBufferFirstBit_ + bitsEaten - carryByteCount * 8;
 
-   // Return the number of bytes we ate/saved.
-   return ( availableByteCount - bytesUnsaved );
+#if VALIDATE_BASIC
+   if ( inBufferFirstBit_ + bitsEaten < carryByteCount * 8 )
+   {
+      throw E57_EXCEPTION2( ErrorInternal, "bitsEaten=" + toString( bitsEaten ) +
+                                              " carryByteCount=" + toString( carryByteCount ) );
+   }
+#endif
+
+   inBufferFirstBit_ = sourceBit % 8;
+   inBufferEndByte_ = 0;
+
+   return sourceBit / 8;
 }
 
 void BitpackDecoder::stateReset()
@@ -308,31 +411,58 @@ void BitpackDecoder::stateReset()
    inBufferEndByte_ = 0;
 }
 
-void BitpackDecoder::inBufferShiftDown()
+bool BitpackDecoder::packetRecordRange( uint64_t streamByteOffset, size_t byteCount,
+                                        uint64_t &beginRecord, uint64_t &endRecord ) const
 {
-   // Move uneaten data down to beginning of inBuffer_.
-   // Keep on natural boundaries.
-   // Moves all of word that contains inBufferFirstBit.
-   size_t firstWord = inBufferFirstBit_ / bitsPerWord_;
-   size_t firstNaturalByte = firstWord * bytesPerWord_;
+   const unsigned bits = recordBits();
+   if ( bits == 0 )
+   {
+      return false;
+   }
 
-#if VALIDATE_BASIC
-   if ( firstNaturalByte > inBufferEndByte_ )
+   // The first record we can decode is the first one whose word starts at or after
+   // streamByteOffset, since we can only feed inputProcessAligned() whole words.
+   const uint64_t firstWordByte =
+      ( ( streamByteOffset + bytesPerWord_ - 1 ) / bytesPerWord_ ) * bytesPerWord_;
+
+   beginRecord = ( firstWordByte * 8 + bits - 1 ) / bits;
+
+   // The last record we can decode is the last one whose bits all lie in the range.
+   endRecord = ( ( streamByteOffset + byteCount ) * 8 ) / bits;
+
+   if ( endRecord < beginRecord )
    {
-      throw E57_EXCEPTION2( ErrorInternal, "firstNaturalByte=" + toString( firstNaturalByte ) +
-                                              " inBufferEndByte=" + toString( inBufferEndByte_ ) );
+      endRecord = beginRecord;
    }
-#endif
-   size_t byteCount = inBufferEndByte_ - firstNaturalByte;
-   if ( byteCount > 0 )
+
+   return true;
+}
+
+size_t BitpackDecoder::restartAt( uint64_t recordIndex, uint64_t endRecordIndex,
+                                  uint64_t streamByteOffset )
+{
+   const unsigned bits = recordBits();
+   if ( bits == 0 )
    {
-      memmove( inBuffer_.data(), &inBuffer_[firstNaturalByte],
-               byteCount ); // Overlapping regions ok with memmove().
+      throw E57_EXCEPTION2( ErrorInternal, "bytestreamNumber=" + toString( bytestreamNumber_ ) );
    }
 
-   // Update indexes
-   inBufferEndByte_ = byteCount;
-   inBufferFirstBit_ = inBufferFirstBit_ % bitsPerWord_;
+   const uint64_t firstBit = recordIndex * bits;
+   const uint64_t firstWordByte = ( firstBit / bitsPerWord_ ) * bytesPerWord_;
+
+   if ( firstWordByte < streamByteOffset )
+   {
+      throw E57_EXCEPTION2( ErrorInternal, "firstWordByte=" + toString( firstWordByte ) +
+                                              " streamByteOffset=" + toString( streamByteOffset ) );
+   }
+
+   stateReset();
+
+   currentRecordIndex_ = recordIndex;
+   maxRecordCount_ = endRecordIndex;
+   inBufferFirstBit_ = static_cast<size_t>( firstBit % bitsPerWord_ );
+
+   return static_cast<size_t>( firstWordByte - streamByteOffset );
 }
 
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
@@ -385,20 +515,11 @@ size_t BitpackFloatDecoder::inputProcessAligned( const char *inbuf, const size_t
    // Read from inbuf, decode, store in destBuffer
    // Repeat until have filled destBuffer, or completed all records
 
-   size_t n = destBuffer_->capacity() - destBuffer_->nextIndex();
+   const size_t destRecords = destBuffer_->capacity() - destBuffer_->nextIndex();
 
    size_t typeSize = ( precision_ == PrecisionSingle ) ? sizeof( float ) : sizeof( double );
 
 #if VALIDATE_BASIC
-#if 0 // I know no way to do this portably <rs>
-   // Deactivate for now until a better solution is found.
-   // Verify that inbuf is naturally aligned to correct boundary (4 or 8 bytes).  Base class should be doing this for us.
-   if (reinterpret_cast<unsigned>(inbuf) % typeSize) {
-      throw E57_EXCEPTION2(ErrorInternal,
-                           "inbuf=" + toString(reinterpret_cast<unsigned>(inbuf))
-                           + " typeSize=" + toString(typeSize));
-   }
-#endif
    // Verify first bit is zero
    if ( firstBit != 0 )
    {
@@ -409,11 +530,9 @@ size_t BitpackFloatDecoder::inputProcessAligned( const char *inbuf, const size_t
    // Calc how many whole records worth of data we have in inbuf
    size_t maxInputRecords = ( endBit - firstBit ) / ( 8 * typeSize );
 
-   // Can't process more records than we have input data for.
-   if ( n > maxInputRecords )
-   {
-      n = maxInputRecords;
-   }
+   // Can't process more records than we have room for (skipped records don't take any room).
+   uint64_t span = recordSpanForDest( currentRecordIndex_, destRecords );
+   size_t n = ( span < maxInputRecords ) ? static_cast<size_t>( span ) : maxInputRecords;
 
    // Can't process more than defined in input file
    if ( n > maxRecordCount_ - currentRecordIndex_ )
@@ -425,39 +544,18 @@ size_t BitpackFloatDecoder::inputProcessAligned( const char *inbuf, const size_t
    std::cout << "  n:" << n << std::endl; //???
 #endif
 
+   // Records between the kept ones are skipped over without being read
+   const size_t firstKept = static_cast<size_t>( nextKeptRecordOffset( currentRecordIndex_ ) );
+
    if ( precision_ == PrecisionSingle )
    {
-      // Form the starting address for first data location in inBuffer
-      auto inp = reinterpret_cast<const float *>( inbuf );
-
       // Copy floats from inbuf to destBuffer_
-      for ( unsigned i = 0; i < n; i++ )
-      {
-         float value = *inp;
-
-#ifdef E57_VERBOSE
-         std::cout << "  got float value=" << value << std::endl;
-#endif
-         destBuffer_->setNextFloat( value );
-         inp++;
-      }
+      storeRecords<float>( inbuf, firstKept, n );
    }
    else
-   { // Double precision
-      // Form the starting address for first data location in inBuffer
-      auto inp = reinterpret_cast<const double *>( inbuf );
-
+   {
       // Copy doubles from inbuf to destBuffer_
-      for ( unsigned i = 0; i < n; i++ )
-      {
-         double value = *inp;
-
-#ifdef E57_VERBOSE
-         std::cout << "  got double value=" << value << std::endl;
-#endif
-         destBuffer_->setNextDouble( value );
-         inp++;
-      }
+      storeRecords<double>( inbuf, firstKept, n );
    }
 
    // Update counts of records processed
@@ -467,6 +565,63 @@ size_t BitpackFloatDecoder::inputProcessAligned( const char *inbuf, const size_t
    return ( n * 8 * typeSize );
 }
 
+template <typename T>
+void BitpackFloatDecoder::storeRecords( const char *inbuf, size_t firstRecord, size_t endRecord )
+{
+   const size_t step = static_cast<size_t>( decimation_ );
+
+   // inbuf may point straight into a packet, so it is only naturally aligned some of the time.
+   const bool aligned = ( reinterpret_cast<uintptr_t>( inbuf ) % sizeof( T ) ) == 0;
+
+   // Without decimation the records are already contiguous in inbuf. If the dest buffer has the
+   // same type and no gaps, this turns into a single memcpy.
+   if ( ( step == 1 ) && aligned )
+   {
+      if ( firstRecord < endRecord )
+      {
+         storeBatch( reinterpret_cast<const T *>( inbuf ) + firstRecord,
+                     endRecord - firstRecord );
+      }
+      return;
+   }
+
+   T values[GatherBatchSize];
+
+   size_t i = firstRecord;
+   while ( i < endRecord )
+   {
+      size_t batchCount = 0;
+
+      for ( ; ( batchCount < GatherBatchSize ) && ( i < endRecord ); ++batchCount, i += step )
+      {
+         memcpy( &values[batchCount], &inbuf[i * sizeof( T )], sizeof( T ) );
+      }
+
+      storeBatch( values, batchCount );
+   }
+}
+
+void BitpackFloatDecoder::storeBatch( const float *values, size_t count )
+{
+#ifdef E57_VERBOSE
+   std::cout << "  storing " << count << " float values" << std::endl;
+#endif
+   destBuffer_->setNextFloatBatch( values, count );
+}
+
+void BitpackFloatDecoder::storeBatch( const double *values, size_t count )
+{
+#ifdef E57_VERBOSE
+   std::cout << "  storing " << count << " double values" << std::endl;
+#endif
+   destBuffer_->setNextDoubleBatch( values, count );
+}
+
+unsigned BitpackFloatDecoder::recordBits() const
+{
+   return ( precision_ == PrecisionSingle ) ? 8 * sizeof( float ) : 8 * sizeof( double );
+}
+
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
 void BitpackFloatDecoder::dump( int indent, std::ostream &os )
 {
@@ -516,6 +671,14 @@ size_t BitpackStringDecoder::inputProcessAligned( const char *inbuf, const size_
    // available
    while ( currentRecordIndex_ < maxRecordCount_ && nBytesRead < nBytesAvailable )
    {
+      // Don't start on a record we would keep if there is no room left for it
+      if ( readingPrefix_ && ( nBytesPrefixRead_ == 0 ) &&
+           ( nextKeptRecordOffset( currentRecordIndex_ ) == 0 ) &&
+           ( destBuffer_->nextIndex() == destBuffer_->capacity() ) )
+      {
+         break;
+      }
+
 #ifdef E57_VERBOSE
       std::cout << "read string loop1: readingPrefix=" << readingPrefix_
                 << " prefixLength=" << prefixLength_ << " nBytesPrefixRead=" << nBytesPrefixRead_
@@ -582,7 +745,7 @@ size_t BitpackStringDecoder::inputProcessAligned( const char *inbuf, const size_
             prefixLength_ = 1;
             memset( prefixBytes_, 0, sizeof( prefixBytes_ ) );
             nBytesPrefixRead_ = 0;
-            currentString_ = "";
+            currentString_.clear();
             nBytesStringRead_ = 0;
          }
 #ifdef E57_VERBOSE
@@ -606,8 +769,22 @@ size_t BitpackStringDecoder::inputProcessAligned( const char *inbuf, const size_
             nBytesProcess = static_cast<unsigned>( nBytesNeeded );
          }
 
-         // Append to current string and update counts
-         currentString_ += ustring( inbuf, nBytesProcess );
+         // Records skipped by decimation are read past without being stored anywhere
+         const bool keep = ( nextKeptRecordOffset( currentRecordIndex_ ) == 0 );
+         const bool wholeString = ( nBytesStringRead_ == 0 ) && ( nBytesProcess == stringLength_ );
+
+         if ( keep && wholeString )
+         {
+            // The whole string is in inbuf, so store it straight from there
+            destBuffer_->setNextString( inbuf, nBytesProcess );
+         }
+         else if ( keep )
+         {
+            // The string continues in the next input, so accumulate it
+            currentString_.append( inbuf, nBytesProcess );
+         }
+
+         // Update counts
          inbuf += nBytesProcess;
          nBytesRead += nBytesProcess;
          nBytesStringRead_ += nBytesProcess;
@@ -615,8 +792,12 @@ size_t BitpackStringDecoder::inputProcessAligned( const char *inbuf, const size_
          // Check if completed reading the string contents
          if ( nBytesStringRead_ == stringLength_ )
          {
-            // Save accumulated string to dest buffer
-            destBuffer_->setNextString( currentString_ );
+            // Save accumulated string to dest buffer (unless it was stored above, or decimation
+            // skips it)
+            if ( keep && !wholeString )
+            {
+               destBuffer_->setNextString( currentString_.data(), currentString_.size() );
+            }
             currentRecordIndex_++;
 
             // Get ready to read next prefix
@@ -625,7 +806,7 @@ size_t BitpackStringDecoder::inputProcessAligned( const char *inbuf, const size_
             memset( prefixBytes_, 0, sizeof( prefixBytes_ ) );
             nBytesPrefixRead_ = 0;
             stringLength_ = 0;
-            currentString_ = "";
+            currentString_.clear();
             nBytesStringRead_ = 0;
          }
       }
@@ -679,6 +860,97 @@ BitpackIntegerDecoder<RegisterT>::BitpackIntegerDecoder( bool isScaledInteger,
    bitsPerRecord_ = imf->bitsNeeded( minimum_, maximum_ );
    destBitMask_ =
       ( bitsPerRecord_ == 64 ) ? ~0 : static_cast<RegisterT>( 1ULL << bitsPerRecord_ ) - 1;
+
+   selectDecodeKernel();
+}
+
+template <typename RegisterT>
+void BitpackIntegerDecoder<RegisterT>::destBufferSetNew( std::vector<SourceDestBuffer> &dbufs )
+{
+   BitpackDecoder::destBufferSetNew( dbufs );
+
+   // The new buffer may have a different stride
+   selectDecodeKernel();
+}
+
+template <typename RegisterT> void BitpackIntegerDecoder<RegisterT>::selectDecodeKernel()
+{
+   // Real buffers without conversion and bool/string buffers take the generic path, which also
+   // throws the right error for them.
+   const bool conversionOK = destBuffer_->doConversion();
+
+   switch ( destBuffer_->memoryRepresentation() )
+   {
+      case Int8:
+         decodeKernel_ = destKernel<int8_t>();
+         break;
+      case UInt8:
+         decodeKernel_ = destKernel<uint8_t>();
+         break;
+      case Int16:
+         decodeKernel_ = destKernel<int16_t>();
+         break;
+      case UInt16:
+         decodeKernel_ = destKernel<uint16_t>();
+         break;
+      case Int32:
+         decodeKernel_ = destKernel<int32_t>();
+         break;
+      case UInt32:
+         decodeKernel_ = destKernel<uint32_t>();
+         break;
+      case Int64:
+         decodeKernel_ = destKernel<int64_t>();
+         break;
+      case Real32:
+         decodeKernel_ =
+            conversionOK ? realKernel<float>() : &BitpackIntegerDecoder::decodeBatched;
+         break;
+      case Real64:
+         decodeKernel_ =
+            conversionOK ? realKernel<double>() : &BitpackIntegerDecoder::decodeBatched;
+         break;
+      case Bool:
+      case UString:
+         decodeKernel_ = &BitpackIntegerDecoder::decodeBatched;
+         break;
+   }
+}
+
+template <typename RegisterT>
+template <typename DestT>
+typename BitpackIntegerDecoder<RegisterT>::DecodeKernel
+   BitpackIntegerDecoder<RegisterT>::destKernel() const
+{
+   // Scaling only happens if the file says so and the user asked for it
+   const bool scaled = isScaledInteger_ && destBuffer_->doScaling();
+   const bool contiguous = ( destBuffer_->stride() == sizeof( DestT ) );
+
+   if ( scaled )
+   {
+      return contiguous ? &BitpackIntegerDecoder::decodeToDest<DestT, true, true>
+                        : &BitpackIntegerDecoder::decodeToDest<DestT, true, false>;
+   }
+
+   return contiguous ? &BitpackIntegerDecoder::decodeToDest<DestT, false, true>
+                     : &BitpackIntegerDecoder::decodeToDest<DestT, false, false>;
+}
+
+template <typename RegisterT>
+template <typename DestT>
+typename BitpackIntegerDecoder<RegisterT>::DecodeKernel
+   BitpackIntegerDecoder<RegisterT>::realKernel() const
+{
+   // Scaled values can never be out of range for a floating point buffer, so they get a kernel
+   // without any checks.
+   if ( isScaledInteger_ && destBuffer_->doScaling() )
+   {
+      return ( destBuffer_->stride() == sizeof( DestT ) )
+                ? &BitpackIntegerDecoder::decodeScaledToReal<DestT, true>
+                : &BitpackIntegerDecoder::decodeScaledToReal<DestT, false>;
+   }
+
+   return destKernel<DestT>();
 }
 
 template <typename RegisterT>
@@ -695,12 +967,6 @@ size_t BitpackIntegerDecoder<RegisterT>::inputProcessAligned( const char *inbuf,
    // Repeat until have filled destBuffer, or completed all records
 
 #if VALIDATE_BASIC
-#if 0 // I know now way to do this portably
-   // Deactivate for now until a better solution is found.
-   // Verify that inbuf is naturally aligned to RegisterT boundary (1, 2, 4,or 8 bytes).  Base class is doing this for us.
-   if ((reinterpret_cast<unsigned>(inbuf)) % sizeof(RegisterT))
-      throw E57_EXCEPTION2(ErrorInternal, "inbuf=" + toString(reinterpret_cast<unsigned>(inbuf)));
-#endif
    // Verify first bit is in first word
    if ( firstBit >= 8 * sizeof( RegisterT ) )
    {
@@ -716,9 +982,10 @@ size_t BitpackIntegerDecoder<RegisterT>::inputProcessAligned( const char *inbuf,
    size_t bitCount = endBit - firstBit;
    size_t maxInputRecords = bitCount / bitsPerRecord_;
 
-   // Number of transfers is the smaller of what was requested and what is
-   // available in input.
-   size_t recordCount = std::min( destRecords, maxInputRecords );
+   // Number of records consumed is the smaller of what was requested (counting the records
+   // skipped by decimation) and what is available in input.
+   uint64_t span = recordSpanForDest( currentRecordIndex_, destRecords );
+   size_t recordCount = ( span < maxInputRecords ) ? static_cast<size_t>( span ) : maxInputRecords;
 
    // Can't process more than defined in input file
    if ( static_cast<uint64_t>( recordCount ) > maxRecordCount_ - currentRecordIndex_ )
@@ -730,107 +997,300 @@ size_t BitpackIntegerDecoder<RegisterT>::inputProcessAligned( const char *inbuf,
    std::cout << "  recordCount=" << recordCount << std::endl;
 #endif
 
-   auto inp = reinterpret_cast<const RegisterT *>( inbuf );
-   unsigned wordPosition = 0; // The index in inbuf of the word we are currently working on.
+   const size_t firstKept = static_cast<size_t>( nextKeptRecordOffset( currentRecordIndex_ ) );
 
-   // clang-format off
-   // For example on little endian machine:
-   // Assume: registerT=uint32_t, bitOffset=20, destBitMask=0x00007fff (for a 15 bit value).
-   // inp[wordPosition]                    LLLLLLLL LLLLXXXX XXXXXXXX XXXXXXXX   Note LSB of value is at bit20
-   // inp(wordPosition+1]                  XXXXXXXX XXXXXXXX XXXXXXXX XXXXXHHH   H=high bits of value, X=uninteresting bits
-   // low = inp[i] >> bitOffset            00000000 00000000 0000LLLL LLLLLLLL   L=low bits of value, X=uninteresting bits
-   // high = inp[i+1] << (32-bitOffset)    XXXXXXXX XXXXXXXX XHHH0000 00000000
-   // w = high | low                       XXXXXXXX XXXXXXXX XHHHLLLL LLLLLLLL
-   // destBitmask                          00000000 00000000 01111111 11111111
-   // w & mask                             00000000 00000000 0HHHLLLL LLLLLLLL
-   // clang-format on
+   // A record of up to 57 bits lies within the 8 bytes starting at the byte holding its first
+   // bit, so it can be extracted with one unaligned load, a shift, and a mask, without any
+   // branches. This works until the records get within 8 bytes of the end of the input, so find
+   // the first record that doesn't have a full 8 bytes after it. The rest use unpackRecord().
+   const size_t inputBytes = endBit / 8;
+   size_t windowEndRecord = 0;
+
+   if ( ( bitsPerRecord_ <= MaxWindowBits ) && ( inputBytes >= sizeof( uint64_t ) ) )
+   {
+      const size_t lastWindowBit = ( inputBytes - sizeof( uint64_t ) ) * 8 + 7;
+      if ( lastWindowBit >= firstBit )
+      {
+         windowEndRecord = ( lastWindowBit - firstBit ) / bitsPerRecord_ + 1;
+      }
+   }
+
+   const size_t windowEnd = std::min( recordCount, windowEndRecord );
+
+   inputBytes_ = inputBytes;
 
-   size_t bitOffset = firstBit;
+   ( this->*decodeKernel_ )( inbuf, firstBit, firstKept, recordCount, windowEnd );
+
+   // Update counts of records processed
+   currentRecordIndex_ += recordCount;
+
+   // Return number of bits processed.
+   return ( recordCount * bitsPerRecord_ );
+}
 
-   for ( size_t i = 0; i < recordCount; i++ )
+template <typename RegisterT>
+template <typename DestT, bool Scaled, bool Contiguous>
+void BitpackIntegerDecoder<RegisterT>::decodeToDest( const char *inbuf, const size_t firstBit,
+                                                     const size_t firstRecord,
+                                                     const size_t endRecord,
+                                                     const size_t windowEnd )
+{
+   const size_t step = static_cast<size_t>( decimation_ );
+   const size_t stride = Contiguous ? sizeof( DestT ) : destBuffer_->stride();
+   const uint64_t windowMask = ( bitsPerRecord_ < 64 ) ? ( 1ULL << bitsPerRecord_ ) - 1 : ~0ULL;
+
+   unsigned destIndex = destBuffer_->nextIndex();
+   char *dest = static_cast<char *>( destBuffer_->base() ) + destIndex * stride;
+
+   // Convert one value into the dest buffer, the same way setNextInt64() would.
+   auto store = [&]( int64_t value ) {
+      DestT &result = *reinterpret_cast<DestT *>( dest );
+
+      const bool ok = Scaled ? SourceDestBufferImpl::convertScaledInt64( value, scale_, offset_,
+                                                                         result )
+                             : SourceDestBufferImpl::convertInt64( value, result );
+      if ( !ok )
+      {
+         // Everything before this one was stored
+         destBuffer_->setNextIndex( destIndex );
+
+         throw E57_EXCEPTION2( Scaled ? ErrorScaledValueNotRepresentable
+                                      : ErrorValueNotRepresentable,
+                               "pathName=" + destBuffer_->pathName() +
+                                  " value=" + toString( value ) );
+      }
+
+      dest += stride;
+      ++destIndex;
+   };
+
+   size_t i = firstRecord;
+
+   for ( ; i < windowEnd; i += step )
    {
-      // Get lower word (contains at least the LSbit of the value),
-      RegisterT low = inp[wordPosition];
+      const size_t bitPosition = firstBit + i * bitsPerRecord_;
 
-#ifdef E57_VERBOSE
-      std::cout << "  bitOffset: " << bitOffset << std::endl;
-      std::cout << "  low: " << binaryString( low ) << std::endl;
-#endif
+      uint64_t window;
+      memcpy( &window, &inbuf[bitPosition / 8], sizeof( window ) );
+
+      // Add minimum_ to value to get back what writer originally sent
+      store( minimum_ + ( ( window >> ( bitPosition % 8 ) ) & windowMask ) );
+   }
+
+   for ( ; i < endRecord; i += step )
+   {
+      const RegisterT w = unpackRecord( inbuf, firstBit + i * bitsPerRecord_ );
+
+      store( minimum_ + static_cast<uint64_t>( w ) );
+   }
+
+   destBuffer_->setNextIndex( destIndex );
+}
+
+template <typename RegisterT>
+template <typename DestT, bool Contiguous>
+void BitpackIntegerDecoder<RegisterT>::decodeScaledToReal( const char *inbuf,
+                                                           const size_t firstBit,
+                                                           const size_t firstRecord,
+                                                           const size_t endRecord,
+                                                           const size_t windowEnd )
+{
+   const size_t step = static_cast<size_t>( decimation_ );
+   const size_t stride = Contiguous ? sizeof( DestT ) : destBuffer_->stride();
+   const uint64_t windowMask = ( bitsPerRecord_ < 64 ) ? ( 1ULL << bitsPerRecord_ ) - 1 : ~0ULL;
+
+   unsigned destIndex = destBuffer_->nextIndex();
+   char *dest = static_cast<char *>( destBuffer_->base() ) + destIndex * stride;
+
+   // Unpack a batch of raw values, then scale the whole batch in a separate loop. The second loop
+   // has no branches or bit twiddling, so the compiler can vectorise it.
+   uint64_t raw[UnpackBatchSize];
+
+   size_t i = firstRecord;
+   while ( i < endRecord )
+   {
+      size_t batchCount = 0;
+
+      for ( ; ( batchCount < UnpackBatchSize ) && ( i < windowEnd ); ++batchCount, i += step )
+      {
+         const size_t bitPosition = firstBit + i * bitsPerRecord_;
+
+         uint64_t window;
+         memcpy( &window, &inbuf[bitPosition / 8], sizeof( window ) );
+
+         raw[batchCount] = ( window >> ( bitPosition % 8 ) ) & windowMask;
+      }
 
-      RegisterT w;
-      if ( bitOffset == 0 )
+      for ( ; ( batchCount < UnpackBatchSize ) && ( i < endRecord ); ++batchCount, i += step )
       {
-         // The left shift (used below) is not defined if shift is >= size of
-         // word
-         w = low;
+         raw[batchCount] = unpackRecord( inbuf, firstBit + i * bitsPerRecord_ );
       }
-      // Avoid reading the next word, unless it is needed
-      // If the last record finishes on the last bit of input, avoid UMR
-      else if ( bitOffset + bitsPerRecord_ <= RegisterBits )
+
+      // Same arithmetic as SourceDestBufferImpl::convertScaledInt64(), written straight to the
+      // user's buffer.
+      const int64_t minimum = minimum_;
+      const double scale = scale_;
+      const double offset = offset_;
+
+      if ( Contiguous )
       {
-         w = low >> bitOffset;
+         auto out = reinterpret_cast<DestT *>( dest );
+
+         for ( size_t k = 0; k < batchCount; ++k )
+         {
+            const auto value = static_cast<int64_t>( minimum + raw[k] );
+            out[k] = static_cast<DestT>( value * scale + offset );
+         }
       }
       else
       {
-         // Get upper word (may or may not contain interesting bits),
-         RegisterT high = inp[wordPosition + 1];
+         for ( size_t k = 0; k < batchCount; ++k )
+         {
+            const auto value = static_cast<int64_t>( minimum + raw[k] );
+            *reinterpret_cast<DestT *>( dest + k * stride ) =
+               static_cast<DestT>( value * scale + offset );
+         }
+      }
 
-#ifdef E57_VERBOSE
-         std::cout << "  high:" << binaryString( high ) << std::endl;
-#endif
+      dest += batchCount * stride;
+      destIndex += static_cast<unsigned>( batchCount );
+   }
 
-         // Shift high to just above the lower bits, shift low LSBit to bit0,
-         // OR together. Note shifts are logical (not arithmetic) because using
-         // unsigned variables.
-         w = ( high << ( RegisterBits - bitOffset ) ) | ( low >> bitOffset );
-      }
+   destBuffer_->setNextIndex( destIndex );
+}
 
-#ifdef E57_VERBOSE
-      std::cout << "  w:   " << binaryString( w ) << std::endl;
-#endif
+template <typename RegisterT>
+void BitpackIntegerDecoder<RegisterT>::decodeBatched( const char *inbuf, const size_t firstBit,
+                                                      const size_t firstRecord,
+                                                      const size_t endRecord,
+                                                      const size_t windowEnd )
+{
+   const size_t step = static_cast<size_t>( decimation_ );
+   const uint64_t windowMask = ( bitsPerRecord_ < 64 ) ? ( 1ULL << bitsPerRecord_ ) - 1 : ~0ULL;
 
-      // Mask off uninteresting bits
-      w &= destBitMask_;
+   // Unpack a batch of records at a time, then hand the whole batch to the dest buffer. Records
+   // skipped by decimation are never touched.
+   int64_t values[UnpackBatchSize];
 
-      // Add minimum_ to value to get back what writer originally sent
-      int64_t value = minimum_ + static_cast<uint64_t>( w );
+   size_t i = firstRecord;
+   while ( i < endRecord )
+   {
+      size_t batchCount = 0;
+
+      for ( ; ( batchCount < UnpackBatchSize ) && ( i < windowEnd ); ++batchCount, i += step )
+      {
+         const size_t bitPosition = firstBit + i * bitsPerRecord_;
+
+         uint64_t window;
+         memcpy( &window, &inbuf[bitPosition / 8], sizeof( window ) );
+
+         // Add minimum_ to value to get back what writer originally sent
+         values[batchCount] = minimum_ + ( ( window >> ( bitPosition % 8 ) ) & windowMask );
+      }
+
+      for ( ; ( batchCount < UnpackBatchSize ) && ( i < endRecord ); ++batchCount, i += step )
+      {
+         const RegisterT w = unpackRecord( inbuf, firstBit + i * bitsPerRecord_ );
+
+         values[batchCount] = minimum_ + static_cast<uint64_t>( w );
+      }
 
 #ifdef E57_VERBOSE
-      std::cout << "  Storing value=" << value << std::endl;
+      std::cout << "  Storing " << batchCount << " values, first=" << values[0] << std::endl;
 #endif
 
       // The parameter isScaledInteger_ determines which version of
-      // setNextInt64 gets called
+      // setNextInt64Batch gets called
       if ( isScaledInteger_ )
       {
-         destBuffer_->setNextInt64( value, scale_, offset_ );
+         destBuffer_->setNextInt64Batch( values, batchCount, scale_, offset_ );
       }
       else
       {
-         destBuffer_->setNextInt64( value );
+         destBuffer_->setNextInt64Batch( values, batchCount );
       }
+   }
+}
 
-      // Store the result in next available position in the user's dest buffer
+template <typename RegisterT>
+RegisterT BitpackIntegerDecoder<RegisterT>::unpackRecord( const char *inbuf,
+                                                          size_t bitPosition ) const
+{
+   // clang-format off
+   // For example on little endian machine:
+   // Assume: registerT=uint32_t, bitOffset=20, destBitMask=0x00007fff (for a 15 bit value).
+   // inp[wordPosition]                    LLLLLLLL LLLLXXXX XXXXXXXX XXXXXXXX   Note LSB of value is at bit20
+   // inp(wordPosition+1]                  XXXXXXXX XXXXXXXX XXXXXXXX XXXXXHHH   H=high bits of value, X=uninteresting bits
+   // low = inp[i] >> bitOffset            00000000 00000000 0000LLLL LLLLLLLL   L=low bits of value, X=uninteresting bits
+   // high = inp[i+1] << (32-bitOffset)    XXXXXXXX XXXXXXXX XHHH0000 00000000
+   // w = high | low                       XXXXXXXX XXXXXXXX XHHHLLLL LLLLLLLL
+   // destBitmask                          00000000 00000000 01111111 11111111
+   // w & mask                             00000000 00000000 0HHHLLLL LLLLLLLL
+   // clang-format on
+
+   // Calc which word the record starts in and its bit alignment within that word.
+   const size_t wordPosition = bitPosition / RegisterBits;
+   const size_t bitOffset = bitPosition % RegisterBits;
+
+   // Get lower word (contains at least the LSbit of the value),
+   RegisterT low = loadWord( inbuf, wordPosition );
 
-      // Calc next bit alignment and which word it starts in
-      bitOffset += bitsPerRecord_;
-      if ( bitOffset >= 8 * sizeof( RegisterT ) )
-      {
-         bitOffset -= 8 * sizeof( RegisterT );
-         wordPosition++;
-      }
 #ifdef E57_VERBOSE
-      std::cout << "  Processed " << i + 1 << " records, wordPosition=" << wordPosition
-                << " decoder:" << std::endl;
-      dump( 4 );
+   std::cout << "  bitOffset: " << bitOffset << std::endl;
+   std::cout << "  low: " << binaryString( low ) << std::endl;
 #endif
+
+   RegisterT w;
+   if ( bitOffset == 0 )
+   {
+      // The left shift (used below) is not defined if shift is >= size of
+      // word
+      w = low;
+   }
+   // Avoid reading the next word, unless it is needed
+   // If the last record finishes on the last bit of input, avoid UMR
+   else if ( bitOffset + bitsPerRecord_ <= RegisterBits )
+   {
+      w = low >> bitOffset;
    }
+   else
+   {
+      // Get upper word (may or may not contain interesting bits),
+      RegisterT high = loadWord( inbuf, wordPosition + 1 );
 
-   // Update counts of records processed
-   currentRecordIndex_ += recordCount;
+#ifdef E57_VERBOSE
+      std::cout << "  high:" << binaryString( high ) << std::endl;
+#endif
 
-   // Return number of bits processed.
-   return ( recordCount * bitsPerRecord_ );
+      // Shift high to just above the lower bits, shift low LSBit to bit0,
+      // OR together. Note shifts are logical (not arithmetic) because using
+      // unsigned variables.
+      w = ( high << ( RegisterBits - bitOffset ) ) | ( low >> bitOffset );
+   }
+
+#ifdef E57_VERBOSE
+   std::cout << "  w:   " << binaryString( w ) << std::endl;
+#endif
+
+   // Mask off uninteresting bits
+   return w & destBitMask_;
+}
+
+template <typename RegisterT>
+RegisterT BitpackIntegerDecoder<RegisterT>::loadWord( const char *inbuf,
+                                                      size_t wordPosition ) const
+{
+   // inbuf may point straight into a packet, so it isn't necessarily aligned, and the last word
+   // may run off the end of the input. Only the bytes that are there are read.
+   const size_t byteOffset = wordPosition * sizeof( RegisterT );
+   const size_t byteCount = ( inputBytes_ - byteOffset < sizeof( RegisterT ) )
+                               ? inputBytes_ - byteOffset
+                               : sizeof( RegisterT );
+
+   RegisterT word = 0;
+   memcpy( &word, &inbuf[byteOffset], byteCount );
+
+   return word;
 }
 
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
@@ -851,6 +1311,259 @@ void BitpackIntegerDecoder<RegisterT>::dump( int indent, std::ostream &os )
 
 //================================================================
 
+DeltaIntegerDecoder::DeltaIntegerDecoder( bool isScaledInteger, unsigned bytestreamNumber,
+                                          SourceDestBuffer &dbuf, int64_t minimum,
+                                          int64_t maximum, double scale, double offset,
+                                          uint64_t maxRecordCount ) :
+   Decoder( bytestreamNumber ), maxRecordCount_( maxRecordCount ), destBuffer_( dbuf.impl() ),
+   isScaledInteger_( isScaledInteger ), minimum_( minimum ), scale_( scale ), offset_( offset ),
+   valueBytes_( ( ImageFileImpl::bitsNeeded( minimum, maximum ) + 7 ) / 8 )
+{
+   blockValues_.reserve( DeltaBlockMaxRecords );
+}
+
+void DeltaIntegerDecoder::destBufferSetNew( std::vector<SourceDestBuffer> &dbufs )
+{
+   if ( dbufs.size() != 1 )
+   {
+      throw E57_EXCEPTION2( ErrorInternal, "dbufsSize=" + toString( dbufs.size() ) );
+   }
+
+   destBuffer_ = dbufs.at( 0 ).impl();
+}
+
+size_t DeltaIntegerDecoder::inputProcess( const char *source, const size_t availableByteCount )
+{
+#ifdef E57_VERBOSE
+   std::cout << "DeltaIntegerDecoder::inputprocess() called, source=" << (void *)( source )
+             << " availableByteCount=" << availableByteCount << std::endl;
+#endif
+   size_t bytesEaten = 0;
+
+   while ( true )
+   {
+      storeBlockValues();
+
+      // Stop if the dest buffer filled up part way through the block
+      if ( blockNext_ < blockValues_.size() )
+      {
+         return bytesEaten;
+      }
+
+      // Whatever is left after the last record is padding
+      if ( currentRecordIndex_ >= maxRecordCount_ )
+      {
+         return availableByteCount;
+      }
+
+      if ( ( source == nullptr ) || ( bytesEaten == availableByteCount ) )
+      {
+         return bytesEaten;
+      }
+
+      // Don't start on a block if there is no room for its first record
+      if ( ( nextKeptRecordOffset( currentRecordIndex_ ) == 0 ) &&
+           ( destBuffer_->nextIndex() == destBuffer_->capacity() ) )
+      {
+         return bytesEaten;
+      }
+
+      bytesEaten += takeBlock( source + bytesEaten, availableByteCount - bytesEaten );
+   }
+}
+
+size_t DeltaIntegerDecoder::blockSize( const char *block ) const
+{
+   const size_t count = static_cast<uint8_t>( block[0] ) + 1;
+   const unsigned width = static_cast<uint8_t>( block[1] ) & DeltaWidthMask;
+
+   return deltaBlockHeaderSize( valueBytes_ ) + ( ( count - 1 ) * width + 7 ) / 8;
+}
+
+size_t DeltaIntegerDecoder::takeBlock( const char *source, size_t byteCount )
+{
+   // Decode straight from source if the whole block is there
+   if ( partialBlock_.empty() && ( byteCount >= 2 ) )
+   {
+      const size_t blockBytes = blockSize( source );
+      if ( blockBytes <= byteCount )
+      {
+         decodeBlock( source );
+         return blockBytes;
+      }
+   }
+
+   // Otherwise gather it up, first the two bytes which say how long it is and then the rest
+   const size_t wanted = ( partialBlock_.size() < 2 )
+                            ? 2 - partialBlock_.size()
+                            : blockSize( partialBlock_.data() ) - partialBlock_.size();
+   const size_t takeCount = std::min( wanted, byteCount );
+
+   partialBlock_.insert( partialBlock_.end(), source, source + takeCount );
+
+   if ( ( partialBlock_.size() >= 2 ) &&
+        ( partialBlock_.size() == blockSize( partialBlock_.data() ) ) )
+   {
+      decodeBlock( partialBlock_.data() );
+      partialBlock_.clear();
+   }
+
+   return takeCount;
+}
+
+void DeltaIntegerDecoder::decodeBlock( const char *block )
+{
+   const size_t count = static_cast<uint8_t>( block[0] ) + 1;
+   const unsigned width = static_cast<uint8_t>( block[1] ) & DeltaWidthMask;
+   const bool useOffsets = ( static_cast<uint8_t>( block[1] ) & DeltaOffsetsFlag ) != 0;
+
+   if ( width > 64 )
+   {
+      throw E57_EXCEPTION2( ErrorBadCVPacket, "width=" + toString( width ) + " pathName=" +
+                                                 destBuffer_->pathName() );
+   }
+
+   const auto uMinimum = static_cast<uint64_t>( minimum_ );
+
+   uint64_t first = 0;
+   for ( unsigned i = 0; i < valueBytes_; ++i )
+   {
+      first |= static_cast<uint64_t>( static_cast<uint8_t>( block[2 + i] ) ) << ( 8 * i );
+   }
+
+   blockValues_.resize( count );
+   blockNext_ = 0;
+
+   // Values are kept as unsigned while adding up, which wraps instead of overflowing
+   uint64_t value = uMinimum + first;
+   blockValues_[0] = static_cast<int64_t>( value );
+
+   const auto *source =
+      reinterpret_cast<const uint8_t *>( block + deltaBlockHeaderSize( valueBytes_ ) );
+   const uint64_t mask = ( width == 64 ) ? ~0ULL : ( 1ULL << width ) - 1;
+   uint64_t accumulator = 0;
+   unsigned bitsHeld = 0;
+
+   for ( size_t i = 1; i < count; ++i )
+   {
+      uint64_t packed = 0;
+
+      if ( width > 0 )
+      {
+         // Top up a byte at a time while a whole byte fits
+         while ( ( bitsHeld < width ) && ( bitsHeld <= 56 ) )
+         {
+            accumulator |= static_cast<uint64_t>( *source++ ) << bitsHeld;
+            bitsHeld += 8;
+         }
+
+         if ( bitsHeld >= width )
+         {
+            packed = accumulator & mask;
+            accumulator = ( width == 64 ) ? 0 : ( accumulator >> width );
+            bitsHeld -= width;
+         }
+         else
+         {
+            // A wide value straddles one more byte than the accumulator can take
+            const uint64_t next = *source++;
+            const unsigned used = width - bitsHeld;
+
+            packed = ( accumulator | ( next << bitsHeld ) ) & mask;
+            accumulator = next >> used;
+            bitsHeld = 8 - used;
+         }
+      }
+
+      value = useOffsets ? ( uMinimum + packed ) : ( value + deltaUnzigzag( packed ) );
+      blockValues_[i] = static_cast<int64_t>( value );
+   }
+}
+
+void DeltaIntegerDecoder::storeBlockValues()
+{
+   while ( ( blockNext_ < blockValues_.size() ) && ( currentRecordIndex_ < maxRecordCount_ ) )
+   {
+      const size_t available = static_cast<size_t>(
+         std::min<uint64_t>( blockValues_.size() - blockNext_,
+                             maxRecordCount_ - currentRecordIndex_ ) );
+
+      // Step over records that decimation leaves out
+      const uint64_t skipCount = nextKeptRecordOffset( currentRecordIndex_ );
+      if ( skipCount > 0 )
+      {
+         const size_t n = static_cast<size_t>( std::min<uint64_t>( skipCount, available ) );
+         blockNext_ += n;
+         currentRecordIndex_ += n;
+         continue;
+      }
+
+      const size_t room = destBuffer_->capacity() - destBuffer_->nextIndex();
+      if ( room == 0 )
+      {
+         return;
+      }
+
+      // Without decimation the kept records are contiguous, so store as many as fit in one go
+      const size_t n = ( decimation_ == 1 ) ? std::min( available, room ) : 1;
+
+      if ( isScaledInteger_ )
+      {
+         destBuffer_->setNextInt64Batch( &blockValues_[blockNext_], n, scale_, offset_ );
+      }
+      else
+      {
+         destBuffer_->setNextInt64Batch( &blockValues_[blockNext_], n );
+      }
+
+      blockNext_ += n;
+      currentRecordIndex_ += n;
+   }
+}
+
+void DeltaIntegerDecoder::stateReset()
+{
+   partialBlock_.clear();
+   blockValues_.clear();
+   blockNext_ = 0;
+}
+
+bool DeltaIntegerDecoder::packetRecordRange( uint64_t /*streamByteOffset*/,
+                                             size_t /*byteCount*/, uint64_t & /*beginRecord*/,
+                                             uint64_t & /*endRecord*/ ) const
+{
+   // Blocks vary in length, so where a record is can't be known without reading up to it
+   return false;
+}
+
+size_t DeltaIntegerDecoder::restartAt( uint64_t /*recordIndex*/, uint64_t /*endRecordIndex*/,
+                                       uint64_t /*streamByteOffset*/ )
+{
+   throw E57_EXCEPTION2( ErrorInternal, "bytestreamNumber=" + toString( bytestreamNumber_ ) );
+}
+
+#ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
+void DeltaIntegerDecoder::dump( int indent, std::ostream &os )
+{
+   os << space( indent ) << "bytestreamNumber:   " << bytestreamNumber_ << std::endl;
+   os << space( indent ) << "currentRecordIndex: " << currentRecordIndex_ << std::endl;
+   os << space( indent ) << "maxRecordCount:     " << maxRecordCount_ << std::endl;
+   os << space( indent ) << "isScaledInteger:    " << isScaledInteger_ << std::endl;
+   os << space( indent ) << "minimum:            " << minimum_ << std::endl;
+   os << space( indent ) << "scale:              " << scale_ << std::endl;
+   os << space( indent ) << "offset:             " << offset_ << std::endl;
+   os << space( indent ) << "valueBytes:         " << valueBytes_ << std::endl;
+   os << space( indent ) << "partialBlock:       " << partialBlock_.size() << " bytes"
+      << std::endl;
+   os << space( indent ) << "blockValues:        " << blockValues_.size() - blockNext_
+      << " left" << std::endl;
+   os << space( indent ) << "destBuffer:" << std::endl;
+   destBuffer_->dump( indent + 4, os );
+}
+#endif
+
+//================================================================
+
 ConstantIntegerDecoder::ConstantIntegerDecoder( bool isScaledInteger, unsigned bytestreamNumber,
                                                 SourceDestBuffer &dbuf, int64_t minimum,
                                                 double scale, double offset,
@@ -884,35 +1597,156 @@ size_t ConstantIntegerDecoder::inputProcess( const char *source, const size_t av
    // availableByteCount.
 
    // Fill dest buffer unless get to maxRecordCount
-   size_t count = destBuffer_->capacity() - destBuffer_->nextIndex();
+   uint64_t span =
+      recordSpanForDest( currentRecordIndex_, destBuffer_->capacity() - destBuffer_->nextIndex() );
    uint64_t remainingRecordCount = maxRecordCount_ - currentRecordIndex_;
-   if ( static_cast<uint64_t>( count ) > remainingRecordCount )
+   size_t count = static_cast<size_t>( std::min( span, remainingRecordCount ) );
+
+   const size_t firstKept = static_cast<size_t>( nextKeptRecordOffset( currentRecordIndex_ ) );
+   const size_t step = static_cast<size_t>( decimation_ );
+
+   // Number of records kept out of [firstKept, count)
+   size_t keptCount = ( firstKept < count ) ? ( count - firstKept + step - 1 ) / step : 0;
+
+   const bool conversionOK = destBuffer_->doConversion();
+
+   switch ( destBuffer_->memoryRepresentation() )
    {
-      count = static_cast<unsigned>( remainingRecordCount );
+      case Int8:
+         fillRecords<int8_t>( keptCount );
+         break;
+      case UInt8:
+         fillRecords<uint8_t>( keptCount );
+         break;
+      case Int16:
+         fillRecords<int16_t>( keptCount );
+         break;
+      case UInt16:
+         fillRecords<uint16_t>( keptCount );
+         break;
+      case Int32:
+         fillRecords<int32_t>( keptCount );
+         break;
+      case UInt32:
+         fillRecords<uint32_t>( keptCount );
+         break;
+      case Int64:
+         fillRecords<int64_t>( keptCount );
+         break;
+      case Real32:
+         if ( conversionOK )
+         {
+            fillRecords<float>( keptCount );
+         }
+         else
+         {
+            fillBatched( keptCount );
+         }
+         break;
+      case Real64:
+         if ( conversionOK )
+         {
+            fillRecords<double>( keptCount );
+         }
+         else
+         {
+            fillBatched( keptCount );
+         }
+         break;
+      case Bool:
+      case UString:
+         // The generic path handles the odd bool mapping, and throws for strings
+         fillBatched( keptCount );
+         break;
    }
 
-   if ( isScaledInteger_ )
+   currentRecordIndex_ += count;
+   return ( count );
+}
+
+template <typename T> void ConstantIntegerDecoder::fillRecords( size_t keptCount )
+{
+   // Convert the value once, the same way setNextInt64() would
+   T value;
+
+   const bool scaled = isScaledInteger_ && destBuffer_->doScaling();
+   const bool ok = scaled ? SourceDestBufferImpl::convertScaledInt64( minimum_, scale_, offset_,
+                                                                      value )
+                          : SourceDestBufferImpl::convertInt64( minimum_, value );
+   if ( !ok )
+   {
+      throw E57_EXCEPTION2( scaled ? ErrorScaledValueNotRepresentable
+                                   : ErrorValueNotRepresentable,
+                            "pathName=" + destBuffer_->pathName() +
+                               " value=" + toString( minimum_ ) );
+   }
+
+   const unsigned destIndex = destBuffer_->nextIndex();
+   const size_t stride = destBuffer_->stride();
+   char *dest = static_cast<char *>( destBuffer_->base() ) + destIndex * stride;
+
+   if ( stride == sizeof( T ) )
+   {
+      std::fill_n( reinterpret_cast<T *>( dest ), keptCount, value );
+   }
+   else
    {
-      for ( size_t i = 0; i < count; i++ )
+      for ( size_t i = 0; i < keptCount; ++i, dest += stride )
       {
-         destBuffer_->setNextInt64( minimum_, scale_, offset_ );
+         *reinterpret_cast<T *>( dest ) = value;
       }
    }
-   else
+
+   destBuffer_->setNextIndex( destIndex + static_cast<unsigned>( keptCount ) );
+}
+
+void ConstantIntegerDecoder::fillBatched( size_t keptCount )
+{
+   // Store the same value in batches
+   int64_t values[FillBatchSize];
+   std::fill_n( values, FillBatchSize, minimum_ );
+
+   while ( keptCount > 0 )
    {
-      for ( size_t i = 0; i < count; i++ )
+      const size_t batchCount = ( keptCount < FillBatchSize ) ? keptCount : FillBatchSize;
+
+      if ( isScaledInteger_ )
+      {
+         destBuffer_->setNextInt64Batch( values, batchCount, scale_, offset_ );
+      }
+      else
       {
-         destBuffer_->setNextInt64( minimum_ );
+         destBuffer_->setNextInt64Batch( values, batchCount );
       }
+
+      keptCount -= batchCount;
    }
-   currentRecordIndex_ += count;
-   return ( count );
 }
 
 void ConstantIntegerDecoder::stateReset()
 {
 }
 
+bool ConstantIntegerDecoder::packetRecordRange( uint64_t /*streamByteOffset*/,
+                                                size_t /*byteCount*/, uint64_t &beginRecord,
+                                                uint64_t &endRecord ) const
+{
+   // We don't use any input, so any record can be produced from any packet.
+   beginRecord = 0;
+   endRecord = UINT64_MAX;
+
+   return true;
+}
+
+size_t ConstantIntegerDecoder::restartAt( uint64_t recordIndex, uint64_t endRecordIndex,
+                                          uint64_t /*streamByteOffset*/ )
+{
+   currentRecordIndex_ = recordIndex;
+   maxRecordCount_ = endRecordIndex;
+
+   return 0;
+}
+
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
 void ConstantIntegerDecoder::dump( int indent, std::ostream &os )
 {
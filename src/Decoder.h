@@ -46,11 +46,25 @@ namespace e57
       virtual size_t inputProcess( const char *source, size_t count ) = 0;
       virtual void stateReset() = 0;
 
+      /// Find the records [beginRecord, endRecord) that can be decoded using only the byteCount
+      /// bytes starting at streamByteOffset in the bytestream. Returns false if the records are
+      /// variable length, so this can't be known without decoding everything before them.
+      virtual bool packetRecordRange( uint64_t streamByteOffset, size_t byteCount,
+                                      uint64_t &beginRecord, uint64_t &endRecord ) const = 0;
+
+      /// Restart decoding at record recordIndex and stop before endRecordIndex. Input fed after
+      /// this must start at streamByteOffset plus the returned number of bytes.
+      virtual size_t restartAt( uint64_t recordIndex, uint64_t endRecordIndex,
+                                uint64_t streamByteOffset ) = 0;
+
       unsigned bytestreamNumber() const
       {
          return bytestreamNumber_;
       }
 
+      /// Only transfer every Nth record to the dest buffer (1 = every record).
+      void setDecimation( uint64_t decimation );
+
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
       virtual void dump( int indent = 0, std::ostream &os = std::cout ) = 0;
 #endif
@@ -58,7 +72,19 @@ namespace e57
    protected:
       explicit Decoder( unsigned bytestreamNumber );
 
+      /// Offset from recordIndex to the next record that will be kept.
+      uint64_t nextKeptRecordOffset( uint64_t recordIndex ) const
+      {
+         const uint64_t phase = recordIndex % decimation_;
+         return ( phase == 0 ) ? 0 : decimation_ - phase;
+      }
+
+      /// Number of records, starting at recordIndex, that may be consumed without keeping more
+      /// than destRecords of them.
+      uint64_t recordSpanForDest( uint64_t recordIndex, size_t destRecords ) const;
+
       unsigned int bytestreamNumber_;
+      uint64_t decimation_ = 1;
    };
 
    class BitpackDecoder : public Decoder
@@ -76,6 +102,11 @@ namespace e57
 
       void stateReset() override;
 
+      bool packetRecordRange( uint64_t streamByteOffset, size_t byteCount, uint64_t &beginRecord,
+                              uint64_t &endRecord ) const override;
+      size_t restartAt( uint64_t recordIndex, uint64_t endRecordIndex,
+                        uint64_t streamByteOffset ) override;
+
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
       void dump( int indent = 0, std::ostream &os = std::cout ) override;
 #endif
@@ -84,7 +115,17 @@ namespace e57
       BitpackDecoder( unsigned bytestreamNumber, SourceDestBuffer &dbuf, unsigned alignmentSize,
                       uint64_t maxRecordCount );
 
-      void inBufferShiftDown();
+      /// Number of bits each record takes in the bytestream, or 0 if variable length.
+      virtual unsigned recordBits() const = 0;
+
+      /// Decode from source in place, keeping a trailing partial record in inBuffer_.
+      size_t inputProcessDirect( const char *source, size_t byteCount );
+
+      /// Complete the partial record in inBuffer_ using the first bytes of source.
+      size_t inputProcessCarry( const char *source, size_t availableByteCount );
+
+      /// Room for a partial record left over from the previous input plus the bytes completing it.
+      static constexpr size_t CarryBufferSize = 32;
 
       uint64_t currentRecordIndex_ = 0;
       uint64_t maxRecordCount_ = 0;
@@ -112,6 +153,17 @@ namespace e57
 #endif
 
    protected:
+      unsigned recordBits() const override;
+
+      /// Store every kept record in [firstRecord, endRecord) in the dest buffer, in batches.
+      template <typename T>
+      void storeRecords( const char *inbuf, size_t firstRecord, size_t endRecord );
+      void storeBatch( const float *values, size_t count );
+      void storeBatch( const double *values, size_t count );
+
+      /// Number of decimated records gathered before storing them in the dest buffer in one go.
+      static constexpr size_t GatherBatchSize = 256;
+
       FloatPrecision precision_ = PrecisionSingle;
    };
 
@@ -128,6 +180,11 @@ namespace e57
 #endif
 
    protected:
+      unsigned recordBits() const override
+      {
+         return 0;
+      }
+
       bool readingPrefix_ = true;
       int prefixLength_ = 1;
       uint8_t prefixBytes_[8] = {};
@@ -144,6 +201,8 @@ namespace e57
                              SourceDestBuffer &dbuf, int64_t minimum, int64_t maximum, double scale,
                              double offset, uint64_t maxRecordCount );
 
+      void destBufferSetNew( std::vector<SourceDestBuffer> &dbufs ) override;
+
       size_t inputProcessAligned( const char *inbuf, size_t firstBit, size_t endBit ) override;
 
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
@@ -151,6 +210,49 @@ namespace e57
 #endif
 
    protected:
+      /// Decodes the kept records in [firstRecord, endRecord) into the dest buffer. Records before
+      /// windowEnd may be read with a single 64 bit window.
+      using DecodeKernel = void ( BitpackIntegerDecoder::* )( const char *inbuf, size_t firstBit,
+                                                             size_t firstRecord, size_t endRecord,
+                                                             size_t windowEnd );
+
+      unsigned recordBits() const override
+      {
+         return bitsPerRecord_;
+      }
+
+      /// Pick the kernel for the dest buffer's representation, stride, and scaling.
+      void selectDecodeKernel();
+      template <typename DestT> DecodeKernel destKernel() const;
+      template <typename DestT> DecodeKernel realKernel() const;
+
+      /// Kernel that converts straight into the dest buffer's memory as DestT.
+      template <typename DestT, bool Scaled, bool Contiguous>
+      void decodeToDest( const char *inbuf, size_t firstBit, size_t firstRecord, size_t endRecord,
+                         size_t windowEnd );
+
+      /// Kernel that unpacks, adds minimum_, and scales straight into a float or double buffer.
+      template <typename DestT, bool Contiguous>
+      void decodeScaledToReal( const char *inbuf, size_t firstBit, size_t firstRecord,
+                               size_t endRecord, size_t windowEnd );
+
+      /// Kernel that goes through SourceDestBufferImpl::setNextInt64Batch() for the
+      /// representations without a specialised kernel.
+      void decodeBatched( const char *inbuf, size_t firstBit, size_t firstRecord, size_t endRecord,
+                          size_t windowEnd );
+
+      /// Extract the (masked) record starting at bitPosition, using RegisterT sized reads.
+      RegisterT unpackRecord( const char *inbuf, size_t bitPosition ) const;
+
+      /// Read word wordPosition of inbuf, stopping at the end of the input.
+      RegisterT loadWord( const char *inbuf, size_t wordPosition ) const;
+
+      /// Number of records unpacked before storing them in the dest buffer in one go.
+      static constexpr size_t UnpackBatchSize = 256;
+
+      /// Widest record that always fits in a 64 bit window starting at its first byte.
+      static constexpr unsigned MaxWindowBits = 57;
+
       bool isScaledInteger_;
       int64_t minimum_;
       int64_t maximum_;
@@ -158,9 +260,74 @@ namespace e57
       double offset_;
       unsigned bitsPerRecord_;
       RegisterT destBitMask_;
+      DecodeKernel decodeKernel_ = nullptr;
+
+      /// Number of bytes of input in the current inputProcessAligned() call
+      size_t inputBytes_ = 0;
       static constexpr size_t RegisterBits = sizeof( RegisterT ) * 8;
    };
 
+   /// Decodes an Integer or ScaledInteger field stored with the delta codec (see DeltaCodec.h)
+   class DeltaIntegerDecoder : public Decoder
+   {
+   public:
+      DeltaIntegerDecoder( bool isScaledInteger, unsigned bytestreamNumber, SourceDestBuffer &dbuf,
+                           int64_t minimum, int64_t maximum, double scale, double offset,
+                           uint64_t maxRecordCount );
+      void destBufferSetNew( std::vector<SourceDestBuffer> &dbufs ) override;
+
+      uint64_t totalRecordsCompleted() override
+      {
+         return currentRecordIndex_;
+      }
+
+      size_t inputProcess( const char *source, size_t availableByteCount ) override;
+      void stateReset() override;
+
+      bool packetRecordRange( uint64_t streamByteOffset, size_t byteCount, uint64_t &beginRecord,
+                              uint64_t &endRecord ) const override;
+      size_t restartAt( uint64_t recordIndex, uint64_t endRecordIndex,
+                        uint64_t streamByteOffset ) override;
+
+#ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
+      void dump( int indent = 0, std::ostream &os = std::cout ) override;
+#endif
+
+   protected:
+      /// Length of the block starting at block, which must hold at least its first two bytes
+      size_t blockSize( const char *block ) const;
+
+      /// Use the next block from source, or as much of it as there is. Returns the number of
+      /// bytes used.
+      size_t takeBlock( const char *source, size_t byteCount );
+
+      /// Fill blockValues_ from a whole block
+      void decodeBlock( const char *block );
+
+      /// Move decoded values to the dest buffer until it is full or they are all used
+      void storeBlockValues();
+
+      uint64_t currentRecordIndex_ = 0;
+      uint64_t maxRecordCount_;
+
+      std::shared_ptr<SourceDestBufferImpl> destBuffer_;
+
+      bool isScaledInteger_;
+      int64_t minimum_;
+      double scale_;
+      double offset_;
+
+      /// Bytes taken by the first record of each block
+      unsigned valueBytes_;
+
+      /// Start of a block split between inputs
+      std::vector<char> partialBlock_;
+
+      /// The last block decoded, and the first of its values not yet stored
+      std::vector<int64_t> blockValues_;
+      size_t blockNext_ = 0;
+   };
+
    class ConstantIntegerDecoder : public Decoder
    {
    public:
@@ -177,11 +344,25 @@ namespace e57
       size_t inputProcess( const char *source, size_t availableByteCount ) override;
       void stateReset() override;
 
+      bool packetRecordRange( uint64_t streamByteOffset, size_t byteCount, uint64_t &beginRecord,
+                              uint64_t &endRecord ) const override;
+      size_t restartAt( uint64_t recordIndex, uint64_t endRecordIndex,
+                        uint64_t streamByteOffset ) override;
+
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
       void dump( int indent = 0, std::ostream &os = std::cout ) override;
 #endif
 
    protected:
+      /// Store keptCount copies of the value, converted once to the dest buffer's type T.
+      template <typename T> void fillRecords( size_t keptCount );
+
+      /// Store keptCount copies of the value through SourceDestBufferImpl::setNextInt64Batch().
+      void fillBatched( size_t keptCount );
+
+      /// Number of copies of the value stored in the dest buffer in one go by fillBatched().
+      static constexpr size_t FillBatchSize = 256;
+
       uint64_t currentRecordIndex_ = 0;
       uint64_t maxRecordCount_;
 
@@ -0,0 +1,45 @@
+// SPDX-License-Identifier: BSL-1.0
+// Copyright 2026 libE57Format contributors
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace e57
+{
+   // The delta codec (see DELTA_CODEC_URI) stores a field's bytestream as a run of blocks which
+   // can each be decoded on their own:
+   //
+   //   1 byte   number of records in the block, minus one
+   //   1 byte   bits per packed value in the low 7 bits, with DeltaOffsetsFlag set if the
+   //            values are offsets from the field's minimum rather than zigzag deltas
+   //   n bytes  the first record as an offset from the field's minimum, little endian, in as
+   //            many bytes as bitPackCodec would need bits
+   //   ...      the rest of the records packed least significant bit first, padded to a byte
+
+   /// Most records in a block. Small blocks keep a jump (e.g. the end of a scan line) from
+   /// widening the deltas of many records.
+   constexpr size_t DeltaBlockMaxRecords = 128;
+
+   /// Block values are offsets from the field's minimum, which is smaller when deltas aren't
+   constexpr uint8_t DeltaOffsetsFlag = 0x80;
+   constexpr uint8_t DeltaWidthMask = 0x7F;
+
+   /// Bytes before the packed values of a block whose first record takes valueBytes
+   inline size_t deltaBlockHeaderSize( unsigned valueBytes )
+   {
+      return 2 + valueBytes;
+   }
+
+   /// Map a difference (modulo 2^64) to an unsigned value which is small if it is near zero
+   inline uint64_t deltaZigzag( uint64_t delta )
+   {
+      return ( delta << 1 ) ^ ( 0 - ( delta >> 63 ) );
+   }
+
+   inline uint64_t deltaUnzigzag( uint64_t value )
+   {
+      return ( value >> 1 ) ^ ( 0 - ( value & 1 ) );
+   }
+}
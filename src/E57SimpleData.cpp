@@ -45,7 +45,9 @@ namespace e57
    }
 
    template <typename COORDTYPE>
-   Data3DPointsData_t<COORDTYPE>::Data3DPointsData_t( Data3D &data3D ) : _selfAllocated( true )
+   Data3DPointsData_t<COORDTYPE>::Data3DPointsData_t( Data3D &data3D,
+                                                      bool sphericalToCartesian ) :
+      convertSphericalToCartesian( sphericalToCartesian ), _selfAllocated( true )
    {
       static_assert( std::is_floating_point<COORDTYPE>::value, "Floating point type required." );
 
@@ -82,17 +84,17 @@ namespace e57
 
       const auto cPointCount = data3D.pointCount;
 
-      if ( data3D.pointFields.cartesianXField )
+      if ( data3D.pointFields.cartesianXField || sphericalToCartesian )
       {
          cartesianX = new COORDTYPE[cPointCount];
       }
 
-      if ( data3D.pointFields.cartesianYField )
+      if ( data3D.pointFields.cartesianYField || sphericalToCartesian )
       {
          cartesianY = new COORDTYPE[cPointCount];
       }
 
-      if ( data3D.pointFields.cartesianZField )
+      if ( data3D.pointFields.cartesianZField || sphericalToCartesian )
       {
          cartesianZ = new COORDTYPE[cPointCount];
       }
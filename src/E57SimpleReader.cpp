@@ -136,12 +136,26 @@ namespace e57
    CompressedVectorReader Reader::SetUpData3DPointsData( int64_t dataIndex, size_t pointCount,
                                                          const Data3DPointsFloat &buffers ) const
    {
-      return impl_->SetUpData3DPointsData( dataIndex, pointCount, buffers );
+      return impl_->SetUpData3DPointsData( dataIndex, pointCount, buffers, {} );
    }
 
    CompressedVectorReader Reader::SetUpData3DPointsData( int64_t dataIndex, size_t pointCount,
                                                          const Data3DPointsDouble &buffers ) const
    {
-      return impl_->SetUpData3DPointsData( dataIndex, pointCount, buffers );
+      return impl_->SetUpData3DPointsData( dataIndex, pointCount, buffers, {} );
+   }
+
+   CompressedVectorReader Reader::SetUpData3DPointsData(
+      int64_t dataIndex, size_t pointCount, const Data3DPointsFloat &buffers,
+      const CompressedVectorReaderOptions &readOptions ) const
+   {
+      return impl_->SetUpData3DPointsData( dataIndex, pointCount, buffers, readOptions );
+   }
+
+   CompressedVectorReader Reader::SetUpData3DPointsData(
+      int64_t dataIndex, size_t pointCount, const Data3DPointsDouble &buffers,
+      const CompressedVectorReaderOptions &readOptions ) const
+   {
+      return impl_->SetUpData3DPointsData( dataIndex, pointCount, buffers, readOptions );
    }
 } // end namespace e57
@@ -27,6 +27,7 @@
  */
 
 #include <algorithm>
+#include <cmath>
 #include <limits>
 
 #include "E57SimpleWriter.h"
@@ -163,6 +164,188 @@ namespace
                                   const e57::Data3DPointsFloat &inBuffers );
    template void _fillMinMaxData( e57::Data3D &ioData3DHeader,
                                   const e57::Data3DPointsDouble &inBuffers );
+
+   /// Bounds of the values in a set of buffers, for quantising them
+   struct QuantizeBounds
+   {
+      double minimum = std::numeric_limits<double>::max();
+      double maximum = std::numeric_limits<double>::lowest();
+      bool isFinite = true;
+
+      template <typename T> void add( const T *values, size_t count )
+      {
+         if ( values == nullptr )
+         {
+            return;
+         }
+
+         for ( size_t i = 0; i < count; ++i )
+         {
+            const auto value = static_cast<double>( values[i] );
+
+            isFinite = isFinite && std::isfinite( value );
+            minimum = std::min( value, minimum );
+            maximum = std::max( value, maximum );
+         }
+      }
+
+      /// True if the values can be stored as scaled integers with this scale (and an offset of 0)
+      bool fits( double scale ) const
+      {
+         // Leave plenty of room in int64_t for rounding
+         constexpr double cRawLimit = 4.0e18;
+
+         return isFinite && ( minimum <= maximum ) &&
+                ( std::max( -minimum, maximum ) / scale < cRawLimit );
+      }
+   };
+
+   /// Switch floating point fields to scaled integers with the precisions given in the writer
+   /// options, using the tightest bounds which hold the data. This is done before
+   /// _fillMinMaxData(), which leaves the bounds set here alone.
+   ///   - cartesian points and spherical range
+   ///   - spherical angles
+   ///   - intensity
+   ///   - time stamps
+   template <typename COORDTYPE>
+   void _quantizeFields( e57::Data3D &ioData3DHeader,
+                         const e57::Data3DPointsData_t<COORDTYPE> &inBuffers,
+                         const e57::WriterOptions &inOptions )
+   {
+      auto &pointFields = ioData3DHeader.pointFields;
+
+      const auto cCount = static_cast<size_t>( ioData3DHeader.pointCount );
+
+      const auto isFloatingPoint = []( e57::NumericalNodeType inNodeType ) {
+         return ( inNodeType == e57::NumericalNodeType::Float ) ||
+                ( inNodeType == e57::NumericalNodeType::Double );
+      };
+
+      if ( ( inOptions.pointRangePrecision > 0.0 ) &&
+           isFloatingPoint( pointFields.pointRangeNodeType ) )
+      {
+         QuantizeBounds bounds;
+         bounds.add( pointFields.cartesianXField ? inBuffers.cartesianX : nullptr, cCount );
+         bounds.add( pointFields.cartesianYField ? inBuffers.cartesianY : nullptr, cCount );
+         bounds.add( pointFields.cartesianZField ? inBuffers.cartesianZ : nullptr, cCount );
+         bounds.add( pointFields.sphericalRangeField ? inBuffers.sphericalRange : nullptr, cCount );
+
+         if ( bounds.fits( inOptions.pointRangePrecision ) )
+         {
+            pointFields.pointRangeNodeType = e57::NumericalNodeType::ScaledInteger;
+            pointFields.pointRangeScale = inOptions.pointRangePrecision;
+            pointFields.pointRangeMinimum = bounds.minimum;
+            pointFields.pointRangeMaximum = bounds.maximum;
+         }
+      }
+
+      if ( ( inOptions.anglePrecision > 0.0 ) && isFloatingPoint( pointFields.angleNodeType ) )
+      {
+         QuantizeBounds bounds;
+         bounds.add( pointFields.sphericalAzimuthField ? inBuffers.sphericalAzimuth : nullptr,
+                     cCount );
+         bounds.add( pointFields.sphericalElevationField ? inBuffers.sphericalElevation : nullptr,
+                     cCount );
+
+         if ( bounds.fits( inOptions.anglePrecision ) )
+         {
+            pointFields.angleNodeType = e57::NumericalNodeType::ScaledInteger;
+            pointFields.angleScale = inOptions.anglePrecision;
+            pointFields.angleMinimum = bounds.minimum;
+            pointFields.angleMaximum = bounds.maximum;
+         }
+      }
+
+      if ( ( inOptions.intensityPrecision > 0.0 ) && pointFields.intensityField &&
+           isFloatingPoint( pointFields.intensityNodeType ) )
+      {
+         auto &limits = ioData3DHeader.intensityLimits;
+
+         // The node's bounds come from the intensity limits, so the data has to be within them.
+         // Limits given by the caller are kept as they are. If the data doesn't fit in them,
+         // the field is left as floating point, which has no such restriction.
+         QuantizeBounds bounds;
+         bounds.add( inBuffers.intensity, cCount );
+
+         bool withinLimits = true;
+
+         if ( limits != e57::IntensityLimits{} )
+         {
+            withinLimits = ( limits.intensityMinimum <= bounds.minimum ) &&
+                           ( bounds.maximum <= limits.intensityMaximum );
+
+            bounds.minimum = limits.intensityMinimum;
+            bounds.maximum = limits.intensityMaximum;
+         }
+
+         if ( withinLimits && bounds.fits( inOptions.intensityPrecision ) )
+         {
+            pointFields.intensityNodeType = e57::NumericalNodeType::ScaledInteger;
+            pointFields.intensityScale = inOptions.intensityPrecision;
+            limits.intensityMinimum = bounds.minimum;
+            limits.intensityMaximum = bounds.maximum;
+         }
+      }
+
+      if ( ( inOptions.timePrecision > 0.0 ) && pointFields.timeStampField &&
+           isFloatingPoint( pointFields.timeNodeType ) )
+      {
+         QuantizeBounds bounds;
+         bounds.add( inBuffers.timeStamp, cCount );
+
+         if ( bounds.fits( inOptions.timePrecision ) )
+         {
+            pointFields.timeNodeType = e57::NumericalNodeType::ScaledInteger;
+            pointFields.timeScale = inOptions.timePrecision;
+            pointFields.timeMinimum = bounds.minimum;
+            pointFields.timeMaximum = bounds.maximum;
+         }
+      }
+   }
+
+   /// Integer fields whose buffer holds the same value for every point (see
+   /// WriterOptions::detectConstantFields)
+   template <typename COORDTYPE>
+   e57::WriterImpl::ConstantFields _constantFields(
+      const e57::Data3D &inData3DHeader, const e57::Data3DPointsData_t<COORDTYPE> &inBuffers )
+   {
+      e57::WriterImpl::ConstantFields constantFields;
+
+      const auto &pointFields = inData3DHeader.pointFields;
+      const auto count = static_cast<size_t>( inData3DHeader.pointCount );
+
+      const auto addIfConstant = [&]( const char *name, bool used, const auto *values ) {
+         if ( !used || ( values == nullptr ) || ( count == 0 ) )
+         {
+            return;
+         }
+
+         const auto first = values[0];
+         if ( std::all_of( values, values + count, [=]( auto value ) { return value == first; } ) )
+         {
+            constantFields[name] = static_cast<int64_t>( first );
+         }
+      };
+
+      addIfConstant( "colorRed", pointFields.colorRedField, inBuffers.colorRed );
+      addIfConstant( "colorGreen", pointFields.colorGreenField, inBuffers.colorGreen );
+      addIfConstant( "colorBlue", pointFields.colorBlueField, inBuffers.colorBlue );
+      addIfConstant( "returnIndex", pointFields.returnIndexField, inBuffers.returnIndex );
+      addIfConstant( "returnCount", pointFields.returnCountField, inBuffers.returnCount );
+      addIfConstant( "rowIndex", pointFields.rowIndexField, inBuffers.rowIndex );
+      addIfConstant( "columnIndex", pointFields.columnIndexField, inBuffers.columnIndex );
+      addIfConstant( "cartesianInvalidState", pointFields.cartesianInvalidStateField,
+                     inBuffers.cartesianInvalidState );
+      addIfConstant( "sphericalInvalidState", pointFields.sphericalInvalidStateField,
+                     inBuffers.sphericalInvalidState );
+      addIfConstant( "isIntensityInvalid", pointFields.isIntensityInvalidField,
+                     inBuffers.isIntensityInvalid );
+      addIfConstant( "isColorInvalid", pointFields.isColorInvalidField, inBuffers.isColorInvalid );
+      addIfConstant( "isTimeStampInvalid", pointFields.isTimeStampInvalidField,
+                     inBuffers.isTimeStampInvalid );
+
+      return constantFields;
+   }
 }
 
 namespace e57
@@ -223,9 +406,16 @@ namespace e57
 
    int64_t Writer::WriteData3DData( Data3D &data3DHeader, const Data3DPointsFloat &buffers )
    {
+      _quantizeFields( data3DHeader, buffers, impl_->Options() );
       _fillMinMaxData( data3DHeader, buffers );
 
-      const int64_t scanIndex = impl_->NewData3D( data3DHeader );
+      WriterImpl::ConstantFields constantFields;
+      if ( impl_->Options().detectConstantFields )
+      {
+         constantFields = _constantFields( data3DHeader, buffers );
+      }
+
+      const int64_t scanIndex = impl_->NewData3D( data3DHeader, constantFields );
 
       e57::CompressedVectorWriter dataWriter =
          impl_->SetUpData3DPointsData( scanIndex, data3DHeader.pointCount, buffers );
@@ -238,9 +428,16 @@ namespace e57
 
    int64_t Writer::WriteData3DData( Data3D &data3DHeader, const Data3DPointsDouble &buffers )
    {
+      _quantizeFields( data3DHeader, buffers, impl_->Options() );
       _fillMinMaxData( data3DHeader, buffers );
 
-      const int64_t scanIndex = impl_->NewData3D( data3DHeader );
+      WriterImpl::ConstantFields constantFields;
+      if ( impl_->Options().detectConstantFields )
+      {
+         constantFields = _constantFields( data3DHeader, buffers );
+      }
+
+      const int64_t scanIndex = impl_->NewData3D( data3DHeader, constantFields );
 
       e57::CompressedVectorWriter dataWriter =
          impl_->SetUpData3DPointsData( scanIndex, data3DHeader.pointCount, buffers );
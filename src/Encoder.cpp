@@ -29,6 +29,7 @@
 #include <cstring>
 
 #include "CompressedVectorNodeImpl.h"
+#include "DeltaCodec.h"
 #include "Encoder.h"
 #include "FloatNodeImpl.h"
 #include "ImageFileImpl.h"
@@ -40,10 +41,31 @@
 
 using namespace e57;
 
+namespace
+{
+   /// Smallest and largest of count values, leaving out NaNs. Returns false if there are none.
+   template <typename T> bool valueBounds( const T *values, size_t count, T &low, T &high )
+   {
+      constexpr bool cHasInfinity = std::numeric_limits<T>::has_infinity;
+
+      low = cHasInfinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+      high = cHasInfinity ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::lowest();
+
+      for ( size_t i = 0; i < count; ++i )
+      {
+         low = std::min( low, values[i] );
+         high = std::max( high, values[i] );
+      }
+
+      return low <= high;
+   }
+}
+
 std::shared_ptr<Encoder> Encoder::EncoderFactory( unsigned bytestreamNumber,
                                                   std::shared_ptr<CompressedVectorNodeImpl> cVector,
                                                   std::vector<SourceDestBuffer> &sbufs,
-                                                  ustring & /*codecPath*/ )
+                                                  ustring & /*codecPath*/,
+                                                  size_t outputBufferSize )
 {
    //??? For now, only handle one input
    if ( sbufs.size() != 1 )
@@ -53,6 +75,8 @@ std::shared_ptr<Encoder> Encoder::EncoderFactory( unsigned bytestreamNumber,
 
    SourceDestBuffer sbuf = sbufs.at( 0 );
 
+   const auto cOutputMaxSize = static_cast<unsigned>( outputBufferSize );
+
    // Get node we are going to encode from the CompressedVector's prototype
    NodeImplSharedPtr prototype = cVector->getPrototype();
    ustring path = sbuf.pathName();
@@ -62,6 +86,16 @@ std::shared_ptr<Encoder> Encoder::EncoderFactory( unsigned bytestreamNumber,
    std::cout << "Node to encode:" << std::endl; //???
    encodeNode->dump( 2 );
 #endif
+
+   // The delta codec only takes integers
+   const FieldCodec codec = cVector->fieldCodec( path );
+   if ( ( codec == FieldCodec::Delta ) && ( encodeNode->type() != TypeInteger ) &&
+        ( encodeNode->type() != TypeScaledInteger ) )
+   {
+      throw E57_EXCEPTION2( ErrorBadCodecs, "pathName=" + path +
+                                               " nodeType=" + toString( encodeNode->type() ) );
+   }
+
    switch ( encodeNode->type() )
    {
       case TypeInteger:
@@ -88,10 +122,18 @@ std::shared_ptr<Encoder> Encoder::EncoderFactory( unsigned bytestreamNumber,
             return encoder;
          }
 
+         if ( codec == FieldCodec::Delta )
+         {
+            std::shared_ptr<Encoder> encoder( new DeltaIntegerEncoder(
+               false, bytestreamNumber, sbuf, cOutputMaxSize, ini->minimum(), ini->maximum(),
+               1.0, 0.0 ) );
+            return encoder;
+         }
+
          if ( bitsPerRecord <= 8 )
          {
             std::shared_ptr<Encoder> encoder( new BitpackIntegerEncoder<uint8_t>(
-               false, bytestreamNumber, sbuf, DATA_PACKET_MAX /*!!!*/, ini->minimum(),
+               false, bytestreamNumber, sbuf, cOutputMaxSize, ini->minimum(),
                ini->maximum(), 1.0, 0.0 ) );
             return encoder;
          }
@@ -99,7 +141,7 @@ std::shared_ptr<Encoder> Encoder::EncoderFactory( unsigned bytestreamNumber,
          if ( bitsPerRecord <= 16 )
          {
             std::shared_ptr<Encoder> encoder( new BitpackIntegerEncoder<uint16_t>(
-               false, bytestreamNumber, sbuf, DATA_PACKET_MAX /*!!!*/, ini->minimum(),
+               false, bytestreamNumber, sbuf, cOutputMaxSize, ini->minimum(),
                ini->maximum(), 1.0, 0.0 ) );
             return encoder;
          }
@@ -107,13 +149,13 @@ std::shared_ptr<Encoder> Encoder::EncoderFactory( unsigned bytestreamNumber,
          if ( bitsPerRecord <= 32 )
          {
             std::shared_ptr<Encoder> encoder( new BitpackIntegerEncoder<uint32_t>(
-               false, bytestreamNumber, sbuf, DATA_PACKET_MAX /*!!!*/, ini->minimum(),
+               false, bytestreamNumber, sbuf, cOutputMaxSize, ini->minimum(),
                ini->maximum(), 1.0, 0.0 ) );
             return encoder;
          }
 
          std::shared_ptr<Encoder> encoder( new BitpackIntegerEncoder<uint64_t>(
-            false, bytestreamNumber, sbuf, DATA_PACKET_MAX /*!!!*/, ini->minimum(), ini->maximum(),
+            false, bytestreamNumber, sbuf, cOutputMaxSize, ini->minimum(), ini->maximum(),
             1.0, 0.0 ) );
          return encoder;
       }
@@ -143,10 +185,18 @@ std::shared_ptr<Encoder> Encoder::EncoderFactory( unsigned bytestreamNumber,
             return encoder;
          }
 
+         if ( codec == FieldCodec::Delta )
+         {
+            std::shared_ptr<Encoder> encoder( new DeltaIntegerEncoder(
+               true, bytestreamNumber, sbuf, cOutputMaxSize, sini->minimum(), sini->maximum(),
+               sini->scale(), sini->offset() ) );
+            return encoder;
+         }
+
          if ( bitsPerRecord <= 8 )
          {
             std::shared_ptr<Encoder> encoder( new BitpackIntegerEncoder<uint8_t>(
-               true, bytestreamNumber, sbuf, DATA_PACKET_MAX /*!!!*/, sini->minimum(),
+               true, bytestreamNumber, sbuf, cOutputMaxSize, sini->minimum(),
                sini->maximum(), sini->scale(), sini->offset() ) );
             return encoder;
          }
@@ -154,7 +204,7 @@ std::shared_ptr<Encoder> Encoder::EncoderFactory( unsigned bytestreamNumber,
          if ( bitsPerRecord <= 16 )
          {
             std::shared_ptr<Encoder> encoder( new BitpackIntegerEncoder<uint16_t>(
-               true, bytestreamNumber, sbuf, DATA_PACKET_MAX /*!!!*/, sini->minimum(),
+               true, bytestreamNumber, sbuf, cOutputMaxSize, sini->minimum(),
                sini->maximum(), sini->scale(), sini->offset() ) );
             return encoder;
          }
@@ -162,13 +212,13 @@ std::shared_ptr<Encoder> Encoder::EncoderFactory( unsigned bytestreamNumber,
          if ( bitsPerRecord <= 32 )
          {
             std::shared_ptr<Encoder> encoder( new BitpackIntegerEncoder<uint32_t>(
-               true, bytestreamNumber, sbuf, DATA_PACKET_MAX /*!!!*/, sini->minimum(),
+               true, bytestreamNumber, sbuf, cOutputMaxSize, sini->minimum(),
                sini->maximum(), sini->scale(), sini->offset() ) );
             return encoder;
          }
 
          std::shared_ptr<Encoder> encoder( new BitpackIntegerEncoder<uint64_t>(
-            true, bytestreamNumber, sbuf, DATA_PACKET_MAX /*!!!*/, sini->minimum(), sini->maximum(),
+            true, bytestreamNumber, sbuf, cOutputMaxSize, sini->minimum(), sini->maximum(),
             sini->scale(), sini->offset() ) );
          return encoder;
       }
@@ -180,14 +230,14 @@ std::shared_ptr<Encoder> Encoder::EncoderFactory( unsigned bytestreamNumber,
 
          // !!! need to pick smarter channel buffer sizes, here and elsewhere
          std::shared_ptr<Encoder> encoder( new BitpackFloatEncoder(
-            bytestreamNumber, sbuf, DATA_PACKET_MAX /*!!!*/, fni->precision() ) );
+            bytestreamNumber, sbuf, cOutputMaxSize, fni->precision() ) );
          return encoder;
       }
 
       case TypeString:
       {
          std::shared_ptr<Encoder> encoder(
-            new BitpackStringEncoder( bytestreamNumber, sbuf, DATA_PACKET_MAX /*!!!*/ ) );
+            new BitpackStringEncoder( bytestreamNumber, sbuf, cOutputMaxSize ) );
 
          return encoder;
       }
@@ -220,6 +270,12 @@ BitpackEncoder::BitpackEncoder( unsigned bytestreamNumber, SourceDestBuffer &sbu
 {
 }
 
+void BitpackEncoder::skipRecords( size_t recordCount )
+{
+   sourceBuffer_->setNextIndex( sourceBuffer_->nextIndex() + static_cast<unsigned>( recordCount ) );
+   currentRecordIndex_ += recordCount;
+}
+
 unsigned BitpackEncoder::sourceBufferNextIndex()
 {
    return ( sourceBuffer_->nextIndex() );
@@ -232,7 +288,7 @@ uint64_t BitpackEncoder::currentRecordIndex()
 
 size_t BitpackEncoder::outputAvailable() const
 {
-   return outBufferEnd_ - outBufferFirst_;
+   return ( outBufferEnd_ - outBufferFirst_ ) + ( outBufferWrapped_ ? outBufferWrapEnd_ : 0 );
 }
 
 void BitpackEncoder::outputRead( char *dest, const size_t byteCount )
@@ -249,38 +305,35 @@ void BitpackEncoder::outputRead( char *dest, const size_t byteCount )
                                               " outputAvailable=" + toString( outputAvailable() ) );
    }
 
-   // Copy output bytes to caller
-   memcpy( dest, &outBuffer_[outBufferFirst_], byteCount );
+   // Copy output bytes to caller, from the end of outBuffer_ first
+   const size_t firstCount = std::min( byteCount, outBufferEnd_ - outBufferFirst_ );
 
-#ifdef E57_VERBOSE
-   {
-      unsigned i;
-      for ( i = 0; i < byteCount && i < 20; i++ )
-      {
-         std::cout << "  outBuffer[" << outBufferFirst_ + i << "]="
-                   << static_cast<unsigned>(
-                         static_cast<unsigned char>( outBuffer_[outBufferFirst_ + i] ) )
-                   << std::endl; //???
-      }
-
-      if ( i < byteCount )
-      {
-         std::cout << "  " << byteCount - 1 << " bytes unprinted..." << std::endl;
-      }
-   }
-#endif
+   memcpy( dest, &outBuffer_[outBufferFirst_], firstCount );
 
    // Advance head pointer.
-   outBufferFirst_ += byteCount;
+   outBufferFirst_ += firstCount;
 
-   // Don't slide remaining data down now, wait until do some more processing (that's when data
-   // needs to be aligned).
+   // The rest comes from the part which wrapped around to the start, which is now the first part.
+   // Nothing is moved, so writing carries on after it.
+   if ( ( outBufferFirst_ == outBufferEnd_ ) && outBufferWrapped_ )
+   {
+      const size_t restCount = byteCount - firstCount;
+
+      memcpy( dest + firstCount, &outBuffer_[0], restCount );
+
+      outBufferFirst_ = restCount;
+      outBufferEnd_ = outBufferWrapEnd_;
+      outBufferWrapEnd_ = 0;
+      outBufferWrapped_ = false;
+   }
 }
 
 void BitpackEncoder::outputClear()
 {
    outBufferFirst_ = 0;
    outBufferEnd_ = 0;
+   outBufferWrapEnd_ = 0;
+   outBufferWrapped_ = false;
 }
 
 void BitpackEncoder::sourceBufferSetNew( std::vector<SourceDestBuffer> &sbufs )
@@ -309,54 +362,66 @@ void BitpackEncoder::outputSetMaxSize( unsigned byteCount )
    }
 }
 
-void BitpackEncoder::outBufferShiftDown()
+char *BitpackEncoder::outBufferSpace( size_t &bytesFree )
 {
-   // Move data down closer to beginning of outBuffer_.
-   // But keep outBufferEnd_ as a multiple of outBufferAlignmentSize_.
-   // This ensures that writes into buffer can occur on natural boundaries.
-   // Otherwise some CPUs will fault.
+   size_t position = 0;
 
-   if ( outBufferFirst_ == outBufferEnd_ )
+   if ( outBufferWrapped_ )
+   {
+      // Carry on after the wrapped part, up to the oldest unread output
+      position = outBufferWrapEnd_;
+      bytesFree = outBufferFirst_ - outBufferWrapEnd_;
+   }
+   else if ( outBufferFirst_ == outBufferEnd_ )
    {
       // Buffer is empty, reset indices to 0
       outBufferFirst_ = 0;
       outBufferEnd_ = 0;
-      return;
+
+      bytesFree = outBuffer_.size();
    }
+   else if ( outBufferFirst_ > outBuffer_.size() - outBufferEnd_ )
+   {
+      // There is more room before the unread output than after it, so wrap around to the start.
+      // That keeps writes on natural boundaries, which some CPUs need.
+      outBufferWrapped_ = true;
+      outBufferWrapEnd_ = 0;
 
-   // Round newEnd up to nearest multiple of outBufferAlignmentSize_.
-   size_t newEnd = outputAvailable();
-   size_t remainder = newEnd % outBufferAlignmentSize_;
-   if ( remainder > 0 )
+      bytesFree = outBufferFirst_;
+   }
+   else
    {
-      newEnd += outBufferAlignmentSize_ - remainder;
+      position = outBufferEnd_;
+      bytesFree = outBuffer_.size() - outBufferEnd_;
    }
-   size_t newFirst = outBufferFirst_ - ( outBufferEnd_ - newEnd );
-   size_t byteCount = outBufferEnd_ - outBufferFirst_;
 
-   // Double check round up worked
-   if ( newEnd % outBufferAlignmentSize_ )
+#if VALIDATE_BASIC
+   // Double check writes will be aligned naturally in memory
+   if ( position % outBufferAlignmentSize_ )
    {
       throw E57_EXCEPTION2( ErrorInternal,
-                            "newEnd=" + toString( newEnd ) +
+                            "position=" + toString( position ) +
                                " outBufferAlignmentSize=" + toString( outBufferAlignmentSize_ ) );
    }
+#endif
 
-   // Be paranoid before memory copy
-   if ( newFirst + byteCount > outBuffer_.size() )
+   return &outBuffer_[position];
+}
+
+void BitpackEncoder::outBufferCommit( size_t byteCount )
+{
+   size_t &end = outBufferWrapped_ ? outBufferWrapEnd_ : outBufferEnd_;
+   const size_t limit = outBufferWrapped_ ? outBufferFirst_ : outBuffer_.size();
+
+   // Double check end is ok
+   if ( end + byteCount > limit )
    {
-      throw E57_EXCEPTION2( ErrorInternal, "newFirst=" + toString( newFirst ) +
+      throw E57_EXCEPTION2( ErrorInternal, "end=" + toString( end ) +
                                               " byteCount=" + toString( byteCount ) +
-                                              " outBufferSize=" + toString( outBuffer_.size() ) );
+                                              " limit=" + toString( limit ) );
    }
 
-   // Move available data down closer to beginning of outBuffer_. Overlapping regions ok with
-   // memmove().
-   memmove( &outBuffer_[newFirst], &outBuffer_[outBufferFirst_], byteCount );
-
-   // Update indexes
-   outBufferFirst_ = newFirst;
-   outBufferEnd_ = newEnd;
+   end += byteCount;
 }
 
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
@@ -368,6 +433,8 @@ void BitpackEncoder::dump( int indent, std::ostream &os ) const
    os << space( indent ) << "outBuffer.size:           " << outBuffer_.size() << std::endl;
    os << space( indent ) << "outBufferFirst:           " << outBufferFirst_ << std::endl;
    os << space( indent ) << "outBufferEnd:             " << outBufferEnd_ << std::endl;
+   os << space( indent ) << "outBufferWrapped:         " << outBufferWrapped_ << std::endl;
+   os << space( indent ) << "outBufferWrapEnd:         " << outBufferWrapEnd_ << std::endl;
    os << space( indent ) << "outBufferAlignmentSize:   " << outBufferAlignmentSize_ << std::endl;
    os << space( indent ) << "currentRecordIndex:       " << currentRecordIndex_ << std::endl;
    os << space( indent ) << "outBuffer:" << std::endl;
@@ -402,24 +469,15 @@ uint64_t BitpackFloatEncoder::processRecords( size_t recordCount )
              << std::endl; //???
 #endif
 
-   // Before we add any more, try to shift current contents of outBuffer_ down to beginning of
-   // buffer. This leaves outBufferEnd_ at a natural boundary.
-   outBufferShiftDown();
-
    size_t typeSize = ( precision_ == PrecisionSingle ) ? sizeof( float ) : sizeof( double );
 
-#if VALIDATE_BASIC
-   // Verify that outBufferEnd_ is multiple of typeSize (so transfers of floats are aligned
-   // naturally in memory).
-   if ( outBufferEnd_ % typeSize )
-   {
-      throw E57_EXCEPTION2( ErrorInternal, "outBufferEnd=" + toString( outBufferEnd_ ) +
-                                              " typeSize=" + toString( typeSize ) );
-   }
-#endif
+   // Form the starting address for next available location in outBuffer (which is on a natural
+   // boundary for floats)
+   size_t bytesFree = 0;
+   char *outp = outBufferSpace( bytesFree );
 
    // Figure out how many records will fit in output.
-   size_t maxOutputRecords = ( outBuffer_.size() - outBufferEnd_ ) / typeSize;
+   size_t maxOutputRecords = bytesFree / typeSize;
 
    // Can't process more records than will safely fit in output stream
    if ( recordCount > maxOutputRecords )
@@ -429,36 +487,43 @@ uint64_t BitpackFloatEncoder::processRecords( size_t recordCount )
 
    if ( precision_ == PrecisionSingle )
    {
-      // Form the starting address for next available location in outBuffer
-      auto outp = reinterpret_cast<float *>( &outBuffer_[outBufferEnd_] );
-
-      // Copy floats from sourceBuffer_ to outBuffer_
-      for ( unsigned i = 0; i < recordCount; i++ )
-      {
-         outp[i] = sourceBuffer_->getNextFloat();
-#ifdef E57_VERBOSE
-         std::cout << "encoding float: " << outp[i] << std::endl;
-#endif
-      }
+      // Copy floats from sourceBuffer_ to outBuffer_ (a single memcpy if the source buffer is
+      // a contiguous float array)
+      sourceBuffer_->getNextFloatBatch( reinterpret_cast<float *>( outp ), recordCount );
    }
    else
    {
       // Double precision
-      // Form the starting address for next available location in outBuffer
-      auto outp = reinterpret_cast<double *>( &outBuffer_[outBufferEnd_] );
+      // Copy doubles from sourceBuffer_ to outBuffer_ (a single memcpy if the source buffer is
+      // a contiguous double array)
+      sourceBuffer_->getNextDoubleBatch( reinterpret_cast<double *>( outp ), recordCount );
+   }
 
-      // Copy doubles from sourceBuffer_ to outBuffer_
-      for ( unsigned i = 0; i < recordCount; i++ )
+   // Scan the values while they are still in cache
+   if ( trackValueRange_ )
+   {
+      if ( precision_ == PrecisionSingle )
       {
-         outp[i] = sourceBuffer_->getNextDouble();
-#ifdef E57_VERBOSE
-         std::cout << "encoding double: " << outp[i] << std::endl;
-#endif
+         float low = 0.0f;
+         float high = 0.0f;
+         if ( valueBounds( reinterpret_cast<const float *>( outp ), recordCount, low, high ) )
+         {
+            valueRange_.add( low, high );
+         }
+      }
+      else
+      {
+         double low = 0.0;
+         double high = 0.0;
+         if ( valueBounds( reinterpret_cast<const double *>( outp ), recordCount, low, high ) )
+         {
+            valueRange_.add( low, high );
+         }
       }
    }
 
    // Update end of outBuffer
-   outBufferEnd_ += recordCount * typeSize;
+   outBufferCommit( recordCount * typeSize );
 
    // Update counts of records processed
    currentRecordIndex_ += recordCount;
@@ -508,15 +573,11 @@ uint64_t BitpackStringEncoder::processRecords( size_t recordCount )
              << std::endl; //???
 #endif
 
-   // Before we add any more, try to shift current contents of outBuffer_ down to beginning of
-   // buffer.
-   outBufferShiftDown();
-
-   // Figure out how many bytes outBuffer can accept.
-   size_t bytesFree = outBuffer_.size() - outBufferEnd_;
-
-   // Form the starting address for next available location in outBuffer
-   char *outp = &outBuffer_[outBufferEnd_];
+   // Form the starting address for next available location in outBuffer, and figure out how
+   // many bytes it can accept.
+   size_t bytesFree = 0;
+   char *outp = outBufferSpace( bytesFree );
+   const size_t bytesAvailable = bytesFree;
    unsigned recordsProcessed = 0;
 
    // Don't start loop unless have at least 8 bytes for worst case string length prefix
@@ -612,7 +673,7 @@ uint64_t BitpackStringEncoder::processRecords( size_t recordCount )
    }
 
    // Update end of outBuffer
-   outBufferEnd_ = outBuffer_.size() - bytesFree;
+   outBufferCommit( bytesAvailable - bytesFree );
 
    // Update counts of records processed
    currentRecordIndex_ += recordsProcessed;
@@ -652,6 +713,73 @@ void BitpackStringEncoder::dump( int indent, std::ostream &os ) const
 
 //================================================================
 
+void IntegerFieldLimits::fetchBatch( SourceDestBufferImpl &source, int64_t *values,
+                                     size_t count ) const
+{
+   // isScaledInteger determines which version of getNextInt64Batch gets called
+   if ( isScaledInteger )
+   {
+      source.getNextInt64Batch( values, count, scale, offset );
+   }
+   else
+   {
+      source.getNextInt64Batch( values, count );
+   }
+}
+
+void IntegerFieldLimits::checkBatchRange( const int64_t *values, size_t count ) const
+{
+   // Look for any bad value without branching, so the common case is a single vectorisable pass
+   bool outOfBounds = false;
+   for ( size_t i = 0; i < count; ++i )
+   {
+      outOfBounds |= ( values[i] < minimum ) | ( maximum < values[i] );
+   }
+
+   if ( !outOfBounds )
+   {
+      return;
+   }
+
+   // Report the first one
+   for ( size_t i = 0; i < count; ++i )
+   {
+      const int64_t rawValue = values[i];
+
+      if ( rawValue < minimum || maximum < rawValue )
+      {
+         throw E57_EXCEPTION2( ErrorValueOutOfBounds, "rawValue=" + toString( rawValue ) +
+                                                         " minimum=" + toString( minimum ) +
+                                                         " maximum=" + toString( maximum ) );
+      }
+   }
+}
+
+void IntegerFieldLimits::addToValueRange( const int64_t *values, size_t count,
+                                          ValueRange &range ) const
+{
+   int64_t low = 0;
+   int64_t high = 0;
+   if ( !valueBounds( values, count, low, high ) )
+   {
+      return;
+   }
+
+   if ( !isScaledInteger )
+   {
+      range.add( static_cast<double>( low ), static_cast<double>( high ) );
+      return;
+   }
+
+   // A negative scale swaps the ends around
+   const double scaledLow = low * scale + offset;
+   const double scaledHigh = high * scale + offset;
+
+   range.add( std::min( scaledLow, scaledHigh ), std::max( scaledLow, scaledHigh ) );
+}
+
+//================================================================
+
 template <typename RegisterT>
 BitpackIntegerEncoder<RegisterT>::BitpackIntegerEncoder(
    bool isScaledInteger, unsigned bytestreamNumber, SourceDestBuffer &sbuf, unsigned outputMaxSize,
@@ -661,12 +789,8 @@ BitpackIntegerEncoder<RegisterT>::BitpackIntegerEncoder(
    ImageFileImplSharedPtr imf( sbuf.impl()->destImageFile() ); //??? should be function for this,
                                                                // imf->parentFile()  --> ImageFile?
 
-   isScaledInteger_ = isScaledInteger;
-   minimum_ = minimum;
-   maximum_ = maximum;
-   scale_ = scale;
-   offset_ = offset;
-   bitsPerRecord_ = imf->bitsNeeded( minimum_, maximum_ );
+   limits_ = { isScaledInteger, minimum, maximum, scale, offset };
+   bitsPerRecord_ = imf->bitsNeeded( minimum, maximum );
    sourceBitMask_ = ( bitsPerRecord_ == 64 ) ? ~0 : ( 1ULL << bitsPerRecord_ ) - 1;
    registerBitsUsed_ = 0;
    register_ = 0;
@@ -690,23 +814,18 @@ uint64_t BitpackIntegerEncoder<RegisterT>::processRecords( size_t recordCount )
    }
 #endif
 
-   // Before we add any more, try to shift current contents of outBuffer_ down to beginning of
-   // buffer. This leaves outBufferEnd_ at a natural boundary.
-   outBufferShiftDown();
+   // Form the starting address for next available location in outBuffer (which is on a natural
+   // boundary for RegisterT)
+   size_t bytesFree = 0;
+   char *outp = outBufferSpace( bytesFree );
 
 #ifdef VALIDATE_BASIC
-   // Verify that outBufferEnd_ is multiple of sizeof(RegisterT) (so transfers of RegisterT are
-   // aligned naturally in memory).
-   if ( outBufferEnd_ % sizeof( RegisterT ) )
-   {
-      throw E57_EXCEPTION2( ErrorInternal, "outBufferEnd=" + toString( outBufferEnd_ ) );
-   }
-   size_t transferMax = ( outBuffer_.size() - outBufferEnd_ ) / sizeof( RegisterT );
+   size_t transferMax = bytesFree / sizeof( RegisterT );
 #endif
 
    // Precalculate exact maximum number of records that will fit in output
    // before overflow.
-   size_t outputWordCapacity = ( outBuffer_.size() - outBufferEnd_ ) / sizeof( RegisterT );
+   size_t outputWordCapacity = bytesFree / sizeof( RegisterT );
    size_t maxOutputRecords = ( outputWordCapacity * 8 * sizeof( RegisterT ) +
                                8 * sizeof( RegisterT ) - registerBitsUsed_ - 1 ) /
                              bitsPerRecord_;
@@ -719,124 +838,134 @@ uint64_t BitpackIntegerEncoder<RegisterT>::processRecords( size_t recordCount )
              << std::endl;
 #endif
 
-   // Form the starting address for next available location in outBuffer
-   auto outp = reinterpret_cast<RegisterT *>( &outBuffer_[outBufferEnd_] );
-   unsigned outTransferred = 0;
+   size_t outBytes = 0;
+
+   // Values are fetched from sourceBuffer_, checked, and packed a batch at a time
+   int64_t rawValues[FetchBatchSize];
+   uint64_t uValues[FetchBatchSize];
+
+   const auto uMinimum = static_cast<uint64_t>( limits_.minimum );
 
-   // Copy bits from sourceBuffer_ to outBuffer_
-   for ( unsigned i = 0; i < recordCount; i++ )
+   for ( size_t i = 0; i < recordCount; )
    {
-      int64_t rawValue;
+      const size_t remaining = recordCount - i;
+      const size_t batchCount = ( remaining < FetchBatchSize ) ? remaining : FetchBatchSize;
 
-      // The parameter isScaledInteger_ determines which version of getNextInt64 gets called
-      if ( isScaledInteger_ )
-      {
-         rawValue = sourceBuffer_->getNextInt64( scale_, offset_ );
-      }
-      else
+      limits_.fetchBatch( *sourceBuffer_, rawValues, batchCount );
+
+      // Enforce min/max specification on values
+      limits_.checkBatchRange( rawValues, batchCount );
+
+      if ( trackValueRange_ )
       {
-         rawValue = sourceBuffer_->getNextInt64();
+         limits_.addToValueRange( rawValues, batchCount, valueRange_ );
       }
 
-      // Enforce min/max specification on value
-      if ( rawValue < minimum_ || maximum_ < rawValue )
+      // Offset from the minimum. Done in unsigned arithmetic, which gives the same bits without
+      // risking signed overflow. Mask off upper bits (just in case).
+      for ( size_t j = 0; j < batchCount; ++j )
       {
-         throw E57_EXCEPTION2( ErrorValueOutOfBounds, "rawValue=" + toString( rawValue ) +
-                                                         " minimum=" + toString( minimum_ ) +
-                                                         " maximum=" + toString( maximum_ ) );
+         uValues[j] = ( static_cast<uint64_t>( rawValues[j] ) - uMinimum ) & sourceBitMask_;
       }
 
-      auto uValue = static_cast<uint64_t>( rawValue - minimum_ );
+      outBytes += packBatch( uValues, batchCount, &outp[outBytes] );
 
-#ifdef E57_VERBOSE
-      std::cout << "encoding integer rawValue=" << binaryString( rawValue ) << " = "
-                << hexString( rawValue ) << std::endl;
-      std::cout << "                 uValue  =" << binaryString( uValue ) << " = "
-                << hexString( uValue ) << std::endl;
-#endif
 #ifdef VALIDATE_BASIC
-      // Double check that no bits outside of the mask are set
-      if ( uValue & ~static_cast<uint64_t>( sourceBitMask_ ) )
+      // Double check we stayed within bounds
+      if ( outBytes > transferMax * sizeof( RegisterT ) )
       {
-         throw E57_EXCEPTION2( ErrorInternal, "uValue=" + toString( uValue ) );
+         throw E57_EXCEPTION2( ErrorInternal, "outBytes=" + toString( outBytes ) +
+                                                 " transferMax" + toString( transferMax ) );
       }
 #endif
-      // Mask off upper bits (just in case)
-      uValue &= static_cast<uint64_t>( sourceBitMask_ );
 
-      // See if uValue bits will fit in register
-      unsigned newRegisterBitsUsed = registerBitsUsed_ + bitsPerRecord_;
+      i += batchCount;
 #ifdef E57_VERBOSE
-      std::cout << "  registerBitsUsed=" << registerBitsUsed_
-                << "  newRegisterBitsUsed=" << newRegisterBitsUsed << std::endl;
-#endif
-      if ( newRegisterBitsUsed > 8 * sizeof( RegisterT ) )
-      {
-         // Have more than one registers worth, fill register, transfer, then fill some more
-         register_ |= static_cast<RegisterT>( uValue ) << registerBitsUsed_;
-#ifdef VALIDATE_BASIC
-         // Before transfer, double check address within bounds
-         if ( outTransferred >= transferMax )
-         {
-            throw E57_EXCEPTION2( ErrorInternal, "outTransferred=" + toString( outTransferred ) +
-                                                    " transferMax" + toString( transferMax ) );
-         }
+      std::cout << "  After " << outBytes << " bytes and " << i << " records, encoder:"
+                << std::endl;
+      dump( 4 );
 #endif
-         outp[outTransferred] = register_;
+   }
 
-         outTransferred++;
+   // Update tail of output buffer
+   outBufferCommit( outBytes );
 
-         register_ =
-            static_cast<RegisterT>( uValue ) >> ( 8 * sizeof( RegisterT ) - registerBitsUsed_ );
-         registerBitsUsed_ = newRegisterBitsUsed - 8 * sizeof( RegisterT );
-      }
-      else if ( newRegisterBitsUsed == 8 * sizeof( RegisterT ) )
-      {
-         // Input will exactly fill register, insert value, then transfer
-         register_ |= static_cast<RegisterT>( uValue ) << registerBitsUsed_;
-#ifdef VALIDATE_BASIC
-         // Before transfer, double check address within bounds
-         if ( outTransferred >= transferMax )
-         {
-            throw E57_EXCEPTION2( ErrorInternal, "outTransferred=" + toString( outTransferred ) +
-                                                    " transferMax" + toString( transferMax ) );
-         }
-#endif
-         outp[outTransferred] = register_;
+   // Update counts of records processed
+   currentRecordIndex_ += recordCount;
 
-         outTransferred++;
+   return ( currentRecordIndex_ );
+}
 
-         register_ = 0;
-         registerBitsUsed_ = 0;
+template <typename RegisterT>
+size_t BitpackIntegerEncoder<RegisterT>::packBatch( const uint64_t *values, size_t count,
+                                                    char *out )
+{
+   // A record that fills a whole register is simply narrowed and stored. The register is always
+   // empty between records, so this is a plain copy loop.
+   if ( bitsPerRecord_ == RegisterBits )
+   {
+      for ( size_t i = 0; i < count; ++i )
+      {
+         const auto word = static_cast<RegisterT>( values[i] );
+         memcpy( &out[i * sizeof( RegisterT )], &word, sizeof( RegisterT ) );
       }
-      else
+
+      return count * sizeof( RegisterT );
+   }
+
+   // Otherwise accumulate 64 bits at a time, whatever RegisterT is. On a little endian machine
+   // the bitstream comes out the same as it would one RegisterT at a time, with a lot fewer
+   // stores and branches.
+   uint64_t accumulator = register_;
+   unsigned bitsUsed = registerBitsUsed_;
+   size_t byteCount = 0;
+
+   for ( size_t i = 0; i < count; ++i )
+   {
+      const uint64_t uValue = values[i];
+
+      accumulator |= uValue << bitsUsed;
+      bitsUsed += bitsPerRecord_;
+
+      if ( bitsUsed >= 64 )
       {
-         // There is extra room in register, insert value, but don't do transfer yet
-         register_ |= static_cast<RegisterT>( uValue ) << registerBitsUsed_;
-         registerBitsUsed_ = newRegisterBitsUsed;
+         memcpy( &out[byteCount], &accumulator, sizeof( uint64_t ) );
+         byteCount += sizeof( uint64_t );
+
+         // Keep the bits of uValue that didn't fit
+         bitsUsed -= 64;
+         accumulator = ( bitsUsed > 0 ) ? ( uValue >> ( bitsPerRecord_ - bitsUsed ) ) : 0;
       }
-#ifdef E57_VERBOSE
-      std::cout << "  After " << outTransferred << " transfers and " << i + 1
-                << " records, encoder:" << std::endl;
-      dump( 4 );
-#endif
    }
 
-   // Update tail of output buffer
-   outBufferEnd_ += outTransferred * sizeof( RegisterT );
-#ifdef VALIDATE_BASIC
-   // Double check end is ok
-   if ( outBufferEnd_ > outBuffer_.size() )
+   // Write out any whole registers left, the rest stays in register_
+   while ( bitsUsed >= RegisterBits )
    {
-      throw E57_EXCEPTION2( ErrorInternal, "outBufferEnd=" + toString( outBufferEnd_ ) +
-                                              " outBuffersize=" + toString( outBuffer_.size() ) );
+      const auto word = static_cast<RegisterT>( accumulator );
+      memcpy( &out[byteCount], &word, sizeof( RegisterT ) );
+      byteCount += sizeof( RegisterT );
+
+      // Two shifts, since a single shift by 64 is undefined for RegisterT = uint64_t
+      accumulator = ( accumulator >> ( RegisterBits - 1 ) ) >> 1;
+      bitsUsed -= RegisterBits;
    }
-#endif
 
-   // Update counts of records processed
-   currentRecordIndex_ += recordCount;
+   register_ = static_cast<RegisterT>( accumulator );
+   registerBitsUsed_ = bitsUsed;
 
-   return ( currentRecordIndex_ );
+   return byteCount;
+}
+
+template <typename RegisterT>
+void BitpackIntegerEncoder<RegisterT>::skipRecords( size_t recordCount )
+{
+   // Skipped records mustn't leave a gap in the middle of a word
+   if ( registerBitsUsed_ != 0 )
+   {
+      throw E57_EXCEPTION2( ErrorInternal, "registerBitsUsed=" + toString( registerBitsUsed_ ) );
+   }
+
+   BitpackEncoder::skipRecords( recordCount );
 }
 
 template <typename RegisterT> bool BitpackIntegerEncoder<RegisterT>::registerFlushToOutput()
@@ -851,13 +980,15 @@ template <typename RegisterT> bool BitpackIntegerEncoder<RegisterT>::registerFlu
    // RegisterT boundary
    if ( registerBitsUsed_ > 0 )
    {
-      if ( outBufferEnd_ < outBuffer_.size() - sizeof( RegisterT ) )
+      size_t bytesFree = 0;
+      char *outp = outBufferSpace( bytesFree );
+
+      if ( bytesFree >= sizeof( RegisterT ) )
       {
-         auto outp = reinterpret_cast<RegisterT *>( &outBuffer_[outBufferEnd_] );
-         *outp = register_;
+         memcpy( outp, &register_, sizeof( RegisterT ) );
          register_ = 0;
          registerBitsUsed_ = 0;
-         outBufferEnd_ += sizeof( RegisterT );
+         outBufferCommit( sizeof( RegisterT ) );
          return true; // flush succeeded  ??? is this used? correctly?
       }
 
@@ -877,11 +1008,11 @@ template <typename RegisterT>
 void BitpackIntegerEncoder<RegisterT>::dump( int indent, std::ostream &os ) const
 {
    BitpackEncoder::dump( indent, os );
-   os << space( indent ) << "isScaledInteger:  " << isScaledInteger_ << std::endl;
-   os << space( indent ) << "minimum:          " << minimum_ << std::endl;
-   os << space( indent ) << "maximum:          " << maximum_ << std::endl;
-   os << space( indent ) << "scale:            " << scale_ << std::endl;
-   os << space( indent ) << "offset:           " << offset_ << std::endl;
+   os << space( indent ) << "isScaledInteger:  " << limits_.isScaledInteger << std::endl;
+   os << space( indent ) << "minimum:          " << limits_.minimum << std::endl;
+   os << space( indent ) << "maximum:          " << limits_.maximum << std::endl;
+   os << space( indent ) << "scale:            " << limits_.scale << std::endl;
+   os << space( indent ) << "offset:           " << limits_.offset << std::endl;
    os << space( indent ) << "bitsPerRecord:    " << bitsPerRecord_ << std::endl;
    os << space( indent ) << "sourceBitMask:    " << binaryString( sourceBitMask_ ) << " "
       << hexString( sourceBitMask_ ) << std::endl;
@@ -891,6 +1022,209 @@ void BitpackIntegerEncoder<RegisterT>::dump( int indent, std::ostream &os ) cons
 }
 #endif
 
+template class e57::BitpackIntegerEncoder<uint8_t>;
+template class e57::BitpackIntegerEncoder<uint16_t>;
+template class e57::BitpackIntegerEncoder<uint32_t>;
+template class e57::BitpackIntegerEncoder<uint64_t>;
+
+//================================================================
+
+DeltaIntegerEncoder::DeltaIntegerEncoder( bool isScaledInteger, unsigned bytestreamNumber,
+                                          SourceDestBuffer &sbuf, unsigned outputMaxSize,
+                                          int64_t minimum, int64_t maximum, double scale,
+                                          double offset ) :
+   BitpackEncoder( bytestreamNumber, sbuf, outputMaxSize, 1 ),
+   limits_{ isScaledInteger, minimum, maximum, scale, offset },
+   bitpackBits_( ImageFileImpl::bitsNeeded( minimum, maximum ) ),
+   valueBytes_( ( bitpackBits_ + 7 ) / 8 )
+{
+}
+
+uint64_t DeltaIntegerEncoder::processRecords( size_t recordCount )
+{
+#ifdef E57_VERBOSE
+   std::cout << "DeltaIntegerEncoder::processRecords() called, recordCount=" << recordCount
+             << std::endl;
+   dump( 4 );
+#endif
+
+   int64_t values[DeltaBlockMaxRecords];
+
+   while ( recordCount > 0 )
+   {
+      size_t bytesFree = 0;
+      char *outp = outBufferSpace( bytesFree );
+
+      // Not even room for a block of one record, so wait until some output has been read
+      if ( bytesFree < deltaBlockHeaderSize( valueBytes_ ) )
+      {
+         break;
+      }
+
+      const size_t fetchCount = std::min( recordCount, DeltaBlockMaxRecords );
+
+      limits_.fetchBatch( *sourceBuffer_, values, fetchCount );
+      limits_.checkBatchRange( values, fetchCount );
+
+      size_t blockBytes = 0;
+      const size_t count = encodeBlock( values, fetchCount, outp, bytesFree, blockBytes );
+
+      // Put back the values which didn't fit, they start the next block
+      if ( count < fetchCount )
+      {
+         sourceBuffer_->setNextIndex( sourceBuffer_->nextIndex() -
+                                      static_cast<unsigned>( fetchCount - count ) );
+      }
+
+      if ( trackValueRange_ )
+      {
+         limits_.addToValueRange( values, count, valueRange_ );
+      }
+
+      outBufferCommit( blockBytes );
+      outputBytes_ += blockBytes;
+      outputRecords_ += count;
+
+      currentRecordIndex_ += count;
+      recordCount -= count;
+   }
+
+   return currentRecordIndex_;
+}
+
+size_t DeltaIntegerEncoder::encodeBlock( const int64_t *values, size_t count, char *out,
+                                         size_t bytesFree, size_t &blockBytes ) const
+{
+   const size_t headerSize = deltaBlockHeaderSize( valueBytes_ );
+   const auto uMinimum = static_cast<uint64_t>( limits_.minimum );
+
+   // Both ways of storing the records after the first, in unsigned arithmetic which wraps
+   // instead of overflowing
+   uint64_t deltas[DeltaBlockMaxRecords];
+   uint64_t offsets[DeltaBlockMaxRecords];
+
+   for ( size_t i = 1; i < count; ++i )
+   {
+      deltas[i] =
+         deltaZigzag( static_cast<uint64_t>( values[i] ) - static_cast<uint64_t>( values[i - 1] ) );
+      offsets[i] = static_cast<uint64_t>( values[i] ) - uMinimum;
+   }
+
+   // Use whichever needs fewer bits, dropping records off the end until the block fits. Fewer
+   // records never need more bits, so this settles quickly.
+   bool useOffsets = false;
+   unsigned width = 0;
+
+   while ( true )
+   {
+      uint64_t deltaBits = 0;
+      uint64_t offsetBits = 0;
+      for ( size_t i = 1; i < count; ++i )
+      {
+         deltaBits |= deltas[i];
+         offsetBits |= offsets[i];
+      }
+
+      const unsigned deltaWidth = ImageFileImpl::bitsNeeded( 0, static_cast<int64_t>( deltaBits ) );
+      const unsigned offsetWidth =
+         ImageFileImpl::bitsNeeded( 0, static_cast<int64_t>( offsetBits ) );
+
+      useOffsets = ( offsetWidth < deltaWidth );
+      width = useOffsets ? offsetWidth : deltaWidth;
+
+      blockBytes = headerSize + ( ( count - 1 ) * width + 7 ) / 8;
+      if ( blockBytes <= bytesFree )
+      {
+         break;
+      }
+
+      count = 1 + ( bytesFree - headerSize ) * 8 / width;
+   }
+
+   out[0] = static_cast<char>( count - 1 );
+   out[1] = static_cast<char>( width | ( useOffsets ? DeltaOffsetsFlag : 0 ) );
+
+   uint64_t first = static_cast<uint64_t>( values[0] ) - uMinimum;
+   for ( unsigned i = 0; i < valueBytes_; ++i, first >>= 8 )
+   {
+      out[2 + i] = static_cast<char>( first & 0xFF );
+   }
+
+   // Pack least significant bit first, a byte at a time so it doesn't matter what endianness
+   // the machine has
+   const uint64_t *packed = useOffsets ? offsets : deltas;
+   char *dest = out + headerSize;
+   uint64_t accumulator = 0;
+   unsigned bitsUsed = 0;
+
+   for ( size_t i = 1; ( i < count ) && ( width > 0 ); ++i )
+   {
+      const uint64_t value = packed[i];
+
+      accumulator |= value << bitsUsed;
+      unsigned bitCount = bitsUsed + width;
+
+      // Only bitsUsed < 8 bits were waiting, so this can't overflow by more than a byte
+      if ( bitCount >= 64 )
+      {
+         for ( unsigned j = 0; j < 8; ++j, accumulator >>= 8 )
+         {
+            *dest++ = static_cast<char>( accumulator & 0xFF );
+         }
+
+         accumulator = ( bitsUsed > 0 ) ? ( value >> ( 64 - bitsUsed ) ) : 0;
+         bitCount -= 64;
+      }
+
+      for ( ; bitCount >= 8; bitCount -= 8, accumulator >>= 8 )
+      {
+         *dest++ = static_cast<char>( accumulator & 0xFF );
+      }
+
+      bitsUsed = bitCount;
+   }
+
+   if ( bitsUsed > 0 )
+   {
+      *dest = static_cast<char>( accumulator & 0xFF );
+   }
+
+   return count;
+}
+
+bool DeltaIntegerEncoder::registerFlushToOutput()
+{
+   // Blocks are always whole, so nothing is held back
+   return true;
+}
+
+float DeltaIntegerEncoder::bitsPerRecord()
+{
+   // Like strings, go by the average so far, starting from what bitpacking would take
+   if ( outputRecords_ == 0 )
+   {
+      return static_cast<float>( bitpackBits_ );
+   }
+
+   return static_cast<float>( outputBytes_ * 8.0 / outputRecords_ );
+}
+
+#ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
+void DeltaIntegerEncoder::dump( int indent, std::ostream &os ) const
+{
+   BitpackEncoder::dump( indent, os );
+   os << space( indent ) << "isScaledInteger:  " << limits_.isScaledInteger << std::endl;
+   os << space( indent ) << "minimum:          " << limits_.minimum << std::endl;
+   os << space( indent ) << "maximum:          " << limits_.maximum << std::endl;
+   os << space( indent ) << "scale:            " << limits_.scale << std::endl;
+   os << space( indent ) << "offset:           " << limits_.offset << std::endl;
+   os << space( indent ) << "bitpackBits:      " << bitpackBits_ << std::endl;
+   os << space( indent ) << "valueBytes:       " << valueBytes_ << std::endl;
+   os << space( indent ) << "outputBytes:      " << outputBytes_ << std::endl;
+   os << space( indent ) << "outputRecords:    " << outputRecords_ << std::endl;
+}
+#endif
+
 //================================================================
 
 ConstantIntegerEncoder::ConstantIntegerEncoder( unsigned bytestreamNumber, SourceDestBuffer &sbuf,
@@ -908,23 +1242,43 @@ uint64_t ConstantIntegerEncoder::processRecords( size_t recordCount )
    dump( 4 );
 #endif
 
-   // Check that all source values are == minimum_
-   for ( unsigned i = 0; i < recordCount; i++ )
+   // Check that all source values are == minimum_, a batch at a time
+   int64_t values[FetchBatchSize];
+
+   for ( size_t i = 0; i < recordCount; i += FetchBatchSize )
    {
-      int64_t nextInt64 = sourceBuffer_->getNextInt64();
-      if ( nextInt64 != minimum_ )
+      const size_t remaining = recordCount - i;
+      const size_t batchCount = ( remaining < FetchBatchSize ) ? remaining : FetchBatchSize;
+
+      sourceBuffer_->getNextInt64Batch( values, batchCount );
+
+      for ( size_t j = 0; j < batchCount; j++ )
       {
-         throw E57_EXCEPTION2( ErrorValueOutOfBounds, "nextInt64=" + toString( nextInt64 ) +
-                                                         " minimum=" + toString( minimum_ ) );
+         if ( values[j] != minimum_ )
+         {
+            throw E57_EXCEPTION2( ErrorValueOutOfBounds, "nextInt64=" + toString( values[j] ) +
+                                                            " minimum=" + toString( minimum_ ) );
+         }
       }
    }
 
+   if ( trackValueRange_ && ( recordCount > 0 ) )
+   {
+      valueRange_.add( static_cast<double>( minimum_ ), static_cast<double>( minimum_ ) );
+   }
+
    // Update counts of records processed
    currentRecordIndex_ += recordCount;
 
    return ( currentRecordIndex_ );
 }
 
+void ConstantIntegerEncoder::skipRecords( size_t recordCount )
+{
+   sourceBuffer_->setNextIndex( sourceBuffer_->nextIndex() + static_cast<unsigned>( recordCount ) );
+   currentRecordIndex_ += recordCount;
+}
+
 unsigned ConstantIntegerEncoder::sourceBufferNextIndex()
 {
    return ( sourceBuffer_->nextIndex() );
@@ -27,20 +27,73 @@
 
 #pragma once
 
+#include <algorithm>
+#include <limits>
+
 #include "Common.h"
 
 namespace e57
 {
+   /// Smallest and largest of the values given to an encoder (see
+   /// CompressedVectorWriterOptions::collectStatistics)
+   struct ValueRange
+   {
+      double minimum = std::numeric_limits<double>::infinity();
+      double maximum = -std::numeric_limits<double>::infinity();
+
+      /// True if no values have been added
+      bool empty() const
+      {
+         return minimum > maximum;
+      }
+
+      void add( double low, double high )
+      {
+         minimum = std::min( minimum, low );
+         maximum = std::max( maximum, high );
+      }
+
+      void add( const ValueRange &other )
+      {
+         add( other.minimum, other.maximum );
+      }
+   };
+
+   /// Limits and scaling of an Integer or ScaledInteger field, with the checks and statistics
+   /// its encoders share
+   struct IntegerFieldLimits
+   {
+      bool isScaledInteger = false;
+      int64_t minimum = 0;
+      int64_t maximum = 0;
+      double scale = 1.0;
+      double offset = 0.0;
+
+      /// Get the next count raw values from source, scaling them if need be
+      void fetchBatch( SourceDestBufferImpl &source, int64_t *values, size_t count ) const;
+
+      /// Throw ErrorValueOutOfBounds if any of the values is outside [minimum, maximum].
+      void checkBatchRange( const int64_t *values, size_t count ) const;
+
+      /// Add the range of a batch of raw values, scaled if need be, to range
+      void addToValueRange( const int64_t *values, size_t count, ValueRange &range ) const;
+   };
+
    class Encoder
    {
    public:
       static std::shared_ptr<Encoder> EncoderFactory(
          unsigned bytestreamNumber, std::shared_ptr<CompressedVectorNodeImpl> cVector,
-         std::vector<SourceDestBuffer> &sbuf, ustring &codecPath );
+         std::vector<SourceDestBuffer> &sbuf, ustring &codecPath, size_t outputBufferSize );
 
       virtual ~Encoder() = default;
 
       virtual uint64_t processRecords( size_t recordCount ) = 0;
+
+      /// Count the next recordCount records of the source buffer as done without encoding them,
+      /// because they went into separate data packets. Only valid on a word boundary.
+      virtual void skipRecords( size_t recordCount ) = 0;
+
       virtual unsigned sourceBufferNextIndex() = 0;
       virtual uint64_t currentRecordIndex() = 0;
       virtual float bitsPerRecord() = 0;
@@ -59,6 +112,20 @@ namespace e57
          return bytestreamNumber_;
       }
 
+      /// Keep track of the smallest and largest value encoded from now on. Only numeric
+      /// encoders do.
+      void trackValueRange()
+      {
+         trackValueRange_ = true;
+      }
+
+      /// Range of the values encoded since trackValueRange(), in the field's units (i.e.
+      /// scaled)
+      const ValueRange &valueRange() const
+      {
+         return valueRange_;
+      }
+
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
       virtual void dump( int indent = 0, std::ostream &os = std::cout ) const;
 #endif
@@ -66,13 +133,20 @@ namespace e57
    protected:
       explicit Encoder( unsigned bytestreamNumber );
 
+      /// Number of integer values fetched from the source buffer in one go.
+      static constexpr size_t FetchBatchSize = 256;
+
       unsigned bytestreamNumber_;
+
+      bool trackValueRange_ = false;
+      ValueRange valueRange_;
    };
 
    class BitpackEncoder : public Encoder
    {
    public:
       uint64_t processRecords( size_t recordCount ) override = 0;
+      void skipRecords( size_t recordCount ) override;
       unsigned sourceBufferNextIndex() override;
       uint64_t currentRecordIndex() override;
       float bitsPerRecord() override = 0;
@@ -94,13 +168,23 @@ namespace e57
       BitpackEncoder( unsigned bytestreamNumber, SourceDestBuffer &sbuf, unsigned outputMaxSize,
                       unsigned alignmentSize );
 
-      void outBufferShiftDown();
+      /// Where the next output goes. bytesFree is set to how many bytes can go there without
+      /// overwriting output which hasn't been read yet.
+      char *outBufferSpace( size_t &bytesFree );
+
+      /// Count byteCount bytes put at outBufferSpace() as output
+      void outBufferCommit( size_t byteCount );
 
       std::shared_ptr<SourceDestBufferImpl> sourceBuffer_;
 
+      /// Output is kept in outBuffer_ as a ring, so reading it never moves what is left. Unread
+      /// output is [outBufferFirst_, outBufferEnd_) followed, once writing has wrapped around to
+      /// the start, by [0, outBufferWrapEnd_).
       std::vector<char> outBuffer_;
       size_t outBufferFirst_;
       size_t outBufferEnd_;
+      size_t outBufferWrapEnd_ = 0;
+      bool outBufferWrapped_ = false;
       size_t outBufferAlignmentSize_;
 
       uint64_t currentRecordIndex_;
@@ -154,6 +238,7 @@ namespace e57
                              int64_t maximum, double scale, double offset );
 
       uint64_t processRecords( size_t recordCount ) override;
+      void skipRecords( size_t recordCount ) override;
       bool registerFlushToOutput() override;
       float bitsPerRecord() override;
 
@@ -162,22 +247,67 @@ namespace e57
 #endif
 
    protected:
-      bool isScaledInteger_;
-      int64_t minimum_;
-      int64_t maximum_;
-      double scale_;
-      double offset_;
+      /// Pack values (already offset by the minimum) after the bits in register_, storing each
+      /// filled word in out. Returns the number of bytes stored.
+      size_t packBatch( const uint64_t *values, size_t count, char *out );
+
+      static constexpr unsigned RegisterBits = sizeof( RegisterT ) * 8;
+
+      IntegerFieldLimits limits_;
       unsigned bitsPerRecord_;
       uint64_t sourceBitMask_;
       unsigned registerBitsUsed_;
       RegisterT register_;
    };
 
+   extern template class BitpackIntegerEncoder<uint8_t>;
+   extern template class BitpackIntegerEncoder<uint16_t>;
+   extern template class BitpackIntegerEncoder<uint32_t>;
+   extern template class BitpackIntegerEncoder<uint64_t>;
+
+   /// Encodes an Integer or ScaledInteger field with the delta codec (see DeltaCodec.h). Blocks
+   /// are byte aligned and always whole, so there is no register to carry between calls.
+   class DeltaIntegerEncoder : public BitpackEncoder
+   {
+   public:
+      DeltaIntegerEncoder( bool isScaledInteger, unsigned bytestreamNumber, SourceDestBuffer &sbuf,
+                           unsigned outputMaxSize, int64_t minimum, int64_t maximum, double scale,
+                           double offset );
+
+      uint64_t processRecords( size_t recordCount ) override;
+      bool registerFlushToOutput() override;
+      float bitsPerRecord() override;
+
+#ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
+      void dump( int indent = 0, std::ostream &os = std::cout ) const override;
+#endif
+
+   protected:
+      /// Encode the first count values as a block in out, leaving off as many values at the end
+      /// as it takes to fit in bytesFree. Returns the number of values in the block, and sets
+      /// blockBytes to its length.
+      size_t encodeBlock( const int64_t *values, size_t count, char *out, size_t bytesFree,
+                          size_t &blockBytes ) const;
+
+      IntegerFieldLimits limits_;
+
+      /// Bits a bitpacked record would take, as a starting point for bitsPerRecord()
+      unsigned bitpackBits_;
+
+      /// Bytes taken by the first record of each block
+      unsigned valueBytes_;
+
+      /// Output so far, for bitsPerRecord(). Records skipped for runs don't count.
+      uint64_t outputBytes_ = 0;
+      uint64_t outputRecords_ = 0;
+   };
+
    class ConstantIntegerEncoder : public Encoder
    {
    public:
       ConstantIntegerEncoder( unsigned bytestreamNumber, SourceDestBuffer &sbuf, int64_t minimum );
       uint64_t processRecords( size_t recordCount ) override;
+      void skipRecords( size_t recordCount ) override;
       unsigned sourceBufferNextIndex() override;
       uint64_t currentRecordIndex() override;
       float bitsPerRecord() override;
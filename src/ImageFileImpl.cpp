@@ -377,6 +377,7 @@ namespace e57
       // zeros here.
       if ( doExtendNow )
       {
+         std::lock_guard<std::mutex> lock( fileMutex_ );
          file_->extend( unusedLogicalStart_ );
       }
 
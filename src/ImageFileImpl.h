@@ -28,6 +28,7 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
 
 #include "Common.h"
 
@@ -98,6 +99,8 @@ namespace e57
       friend class BlobNodeImpl;
       friend class CompressedVectorWriterImpl;
       friend class CompressedVectorReaderImpl;
+      friend class PagedWriteBuffer;
+      friend class WriteBehindQueue;
 
       static void readFileHeader( CheckedFile *file, E57FileHeader &header );
 
@@ -113,6 +116,10 @@ namespace e57
 
       CheckedFile *file_;
 
+      /// Held while using file_ if a CompressedVectorWriter may be writing to it from another
+      /// thread (see CompressedVectorWriterOptions::asyncWrite)
+      std::mutex fileMutex_;
+
       // Read file attributes
       uint64_t xmlLogicalOffset_;
       uint64_t xmlLogicalLength_;
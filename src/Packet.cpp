@@ -33,20 +33,6 @@
 
 using namespace e57;
 
-struct EmptyPacketHeader
-{
-   const uint8_t packetType = EMPTY_PACKET;
-
-   uint8_t reserved1 = 0; // must be zero
-   uint16_t packetLogicalLengthMinus1 = 0;
-
-   void verify( unsigned bufferLength = 0 ) const; //???use
-
-#ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
-   void dump( int indent = 0, std::ostream &os = std::cout ) const;
-#endif
-};
-
 //=============================================================================
 // PacketReadCache
 
@@ -182,4 +182,21 @@ namespace e57
          uint64_t chunkPhysicalOffset = 0;
       } entries[MAX_ENTRIES];
    };
+
+   /// Fills space in a compressed vector section which doesn't hold data, e.g. the gap left to
+   /// start the next data packet on a page boundary. Also used to read the type and length of a
+   /// packet of any type.
+   struct EmptyPacketHeader
+   {
+      const uint8_t packetType = EMPTY_PACKET;
+
+      uint8_t reserved1 = 0; // must be zero
+      uint16_t packetLogicalLengthMinus1 = 0;
+
+      void verify( unsigned bufferLength = 0 ) const;
+
+#ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
+      void dump( int indent = 0, std::ostream &os = std::cout ) const;
+#endif
+   };
 }
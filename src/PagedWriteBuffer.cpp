@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: BSL-1.0
+// Copyright 2026 libE57Format contributors
+
+#include <algorithm>
+#include <cstring>
+
+#include "PagedWriteBuffer.h"
+#include "CheckedFile.h"
+#include "ImageFileImpl.h"
+#include "WriteBehindQueue.h"
+
+namespace e57
+{
+   namespace
+   {
+      constexpr uint64_t LogicalPageSize = CheckedFile::logicalPageSize;
+      constexpr uint64_t PhysicalPageSize = CheckedFile::physicalPageSize;
+   }
+
+   PagedWriteBuffer::PagedWriteBuffer( ImageFileImplSharedPtr imf, size_t pageCapacity,
+                                       WriteBehindQueue *queue ) :
+      imf_( std::move( imf ) ), queue_( queue ), pageCapacity_( pageCapacity )
+   {
+      if ( pageCapacity_ == 0 )
+      {
+         throw E57_EXCEPTION2( ErrorInternal, "pageCapacity=0" );
+      }
+
+      pages_.resize( pageCapacity_ * PhysicalPageSize );
+   }
+
+   char *PagedWriteBuffer::append( uint64_t logicalOffset, size_t &byteCount )
+   {
+      const uint64_t page = logicalOffset / LogicalPageSize;
+
+      const bool isEmpty = ( logicalBegin_ == logicalEnd_ );
+      const bool isFull = ( page >= firstPage_ + pageCapacity_ );
+
+      // Start again from here if this doesn't carry on from what is staged
+      if ( isEmpty || isFull || ( logicalOffset != logicalEnd_ ) )
+      {
+         flush();
+
+         firstPage_ = page;
+         logicalBegin_ = logicalOffset;
+         logicalEnd_ = logicalOffset;
+      }
+
+      const auto pageOffset = static_cast<size_t>( logicalOffset - page * LogicalPageSize );
+
+      byteCount = std::min( byteCount, static_cast<size_t>( LogicalPageSize ) - pageOffset );
+      logicalEnd_ += byteCount;
+
+      return pageData( page ) + pageOffset;
+   }
+
+   void PagedWriteBuffer::write( uint64_t logicalOffset, const char *bytes, size_t length )
+   {
+      while ( length > 0 )
+      {
+         size_t byteCount = length;
+         char *dest = append( logicalOffset, byteCount );
+
+         memcpy( dest, bytes, byteCount );
+
+         logicalOffset += byteCount;
+         bytes += byteCount;
+         length -= byteCount;
+      }
+   }
+
+   void PagedWriteBuffer::flush()
+   {
+      if ( logicalBegin_ == logicalEnd_ )
+      {
+         return;
+      }
+
+      uint64_t position = logicalBegin_;
+
+      // A partial first page may share bytes with something else in the file
+      if ( position % LogicalPageSize != 0 )
+      {
+         const uint64_t blockEnd =
+            std::min( ( position / LogicalPageSize + 1 ) * LogicalPageSize, logicalEnd_ );
+
+         writeBlock( position, blockEnd );
+         position = blockEnd;
+      }
+
+      // The same goes for a partial last page, which is written before handing pages_ over
+      const uint64_t wholePagesEnd = logicalEnd_ / LogicalPageSize * LogicalPageSize;
+
+      if ( ( position < logicalEnd_ ) && ( wholePagesEnd < logicalEnd_ ) )
+      {
+         writeBlock( std::max( position, wholePagesEnd ), logicalEnd_ );
+      }
+
+      // Whole pages are only ours, so they are written as they are
+      if ( position < wholePagesEnd )
+      {
+         const uint64_t page = position / LogicalPageSize;
+         const auto pageIndex = static_cast<size_t>( page - firstPage_ );
+         const auto pageCount =
+            static_cast<size_t>( ( wholePagesEnd - position ) / LogicalPageSize );
+
+         if ( queue_ != nullptr )
+         {
+            queue_->writePages( std::move( pages_ ), pageIndex, pageCount, page );
+
+            pages_ = queue_->takeSparePages();
+            pages_.resize( pageCapacity_ * PhysicalPageSize );
+         }
+         else
+         {
+            imf_->file_->writePhysicalPages( &pages_[pageIndex * PhysicalPageSize], page,
+                                             pageCount );
+         }
+      }
+
+      logicalBegin_ = logicalEnd_;
+   }
+
+   char *PagedWriteBuffer::pageData( uint64_t page )
+   {
+      return &pages_[static_cast<size_t>( page - firstPage_ ) * PhysicalPageSize];
+   }
+
+   // Write part of a page, merging it with the rest of the page in the file
+   void PagedWriteBuffer::writeBlock( uint64_t logicalBegin, uint64_t logicalEnd )
+   {
+      const uint64_t page = logicalBegin / LogicalPageSize;
+      const char *bytes = pageData( page ) + ( logicalBegin - page * LogicalPageSize );
+      const auto length = static_cast<size_t>( logicalEnd - logicalBegin );
+
+      if ( queue_ != nullptr )
+      {
+         queue_->write( logicalBegin, bytes, length );
+      }
+      else
+      {
+         imf_->file_->seek( logicalBegin );
+         imf_->file_->write( bytes, length );
+      }
+   }
+}
@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: BSL-1.0
+// Copyright 2026 libE57Format contributors
+
+#pragma once
+
+#include <vector>
+
+#include "Common.h"
+
+namespace e57
+{
+   class WriteBehindQueue;
+
+   /// Staging area for data appended to an ImageFile, laid out the same as the file's physical
+   /// pages (logical bytes followed by a checksum). Data is put straight into the pages by the
+   /// caller, and whole pages are written out in one go once the area is full or flush() is
+   /// called. Only the partly filled pages at either end are merged with what is in the file.
+   class PagedWriteBuffer
+   {
+   public:
+      /// Stage up to pageCapacity pages at a time. If queue isn't null, pages are written by it
+      /// instead of directly.
+      PagedWriteBuffer( ImageFileImplSharedPtr imf, size_t pageCapacity,
+                        WriteBehindQueue *queue );
+
+      /// Where to put the data for logicalOffset onwards. byteCount is reduced to the number of
+      /// bytes which can go there (up to the end of the page), which the caller has to fill in.
+      /// Appending to the end of what is staged carries on, anywhere else flushes it first.
+      char *append( uint64_t logicalOffset, size_t &byteCount );
+
+      /// Copy length bytes in at logicalOffset.
+      void write( uint64_t logicalOffset, const char *bytes, size_t length );
+
+      /// Write out everything staged.
+      void flush();
+
+   private:
+      char *pageData( uint64_t page );
+      void writeBlock( uint64_t logicalBegin, uint64_t logicalEnd );
+
+      ImageFileImplSharedPtr imf_;
+      WriteBehindQueue *queue_;
+      size_t pageCapacity_;
+
+      std::vector<char> pages_;
+
+      /// Logical range staged, starting in page firstPage_ (the first entry in pages_)
+      uint64_t firstPage_ = 0;
+      uint64_t logicalBegin_ = 0;
+      uint64_t logicalEnd_ = 0;
+   };
+}
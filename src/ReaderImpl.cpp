@@ -191,7 +191,8 @@ namespace e57
    ReaderImpl::ReaderImpl( const ustring &filePath, const ReaderOptions &options ) :
       imf_( filePath, "r", options.checksumPolicy ), root_( imf_.root() ),
       data3D_( root_.isDefined( "/data3D" ) ? root_.get( "/data3D" ) : VectorNode( imf_ ) ),
-      images2D_( root_.isDefined( "/images2D" ) ? root_.get( "/images2D" ) : VectorNode( imf_ ) )
+      images2D_( root_.isDefined( "/images2D" ) ? root_.get( "/images2D" ) : VectorNode( imf_ ) ),
+      applyPose_( options.applyPose )
    {
    }
 
@@ -1273,8 +1274,11 @@ namespace e57
             {
                const FloatNode floatIntensity( intensityProto );
 
-               data3DHeader.intensityLimits.intensityMinimum = floatIntensity.minimum();
-               data3DHeader.intensityLimits.intensityMaximum = floatIntensity.maximum();
+               if ( data3DHeader.intensityLimits.intensityMaximum == 0.0 )
+               {
+                  data3DHeader.intensityLimits.intensityMinimum = floatIntensity.minimum();
+                  data3DHeader.intensityLimits.intensityMaximum = floatIntensity.maximum();
+               }
 
                if ( floatIntensity.precision() == PrecisionSingle )
                {
@@ -1560,7 +1564,8 @@ namespace e57
 
    template <typename COORDTYPE>
    CompressedVectorReader ReaderImpl::SetUpData3DPointsData(
-      int64_t dataIndex, size_t count, const Data3DPointsData_t<COORDTYPE> &buffers ) const
+      int64_t dataIndex, size_t count, const Data3DPointsData_t<COORDTYPE> &buffers,
+      const CompressedVectorReaderOptions &readOptions ) const
    {
       static_assert( std::is_floating_point<COORDTYPE>::value, "Floating point type required." );
 
@@ -1706,7 +1711,71 @@ namespace e57
          }
       }
 
-      CompressedVectorReader reader = points.reader( destBuffers );
+      CompressedVectorReaderOptions options( readOptions );
+
+      const bool haveCartesianBuffers = ( buffers.cartesianX != nullptr ) &&
+                                        ( buffers.cartesianY != nullptr ) &&
+                                        ( buffers.cartesianZ != nullptr );
+      bool haveCartesian = haveCartesianBuffers && proto.isDefined( "cartesianX" ) &&
+                           proto.isDefined( "cartesianY" ) && proto.isDefined( "cartesianZ" );
+
+      // Convert spherical coordinates to cartesian as they are read
+      if ( buffers.convertSphericalToCartesian )
+      {
+         if ( !haveCartesianBuffers )
+         {
+            throw E57_EXCEPTION2( ErrorBadAPIArgument,
+                                  "convertSphericalToCartesian requires cartesianX, cartesianY, "
+                                  "and cartesianZ buffers" );
+         }
+
+         if ( proto.isDefined( "cartesianX" ) || proto.isDefined( "cartesianY" ) ||
+              proto.isDefined( "cartesianZ" ) )
+         {
+            throw E57_EXCEPTION2( ErrorBadAPIArgument,
+                                  "convertSphericalToCartesian used with cartesian data" );
+         }
+
+         options.cartesianFromSpherical.clear();
+         options.cartesianFromSpherical.emplace_back( imf_, "cartesianX", buffers.cartesianX,
+                                                      count, true );
+         options.cartesianFromSpherical.emplace_back( imf_, "cartesianY", buffers.cartesianY,
+                                                      count, true );
+         options.cartesianFromSpherical.emplace_back( imf_, "cartesianZ", buffers.cartesianZ,
+                                                      count, true );
+
+         haveCartesian = true;
+      }
+
+      // Apply the scan's pose to the cartesian coordinates as they are read
+
+      if ( applyPose_ && haveCartesian && !options.transformCartesian && scan.isDefined( "pose" ) )
+      {
+         const StructureNode pose( scan.get( "pose" ) );
+
+         if ( pose.isDefined( "rotation" ) )
+         {
+            const StructureNode rotation( pose.get( "rotation" ) );
+
+            options.cartesianRotation[0] = FloatNode( rotation.get( "w" ) ).value();
+            options.cartesianRotation[1] = FloatNode( rotation.get( "x" ) ).value();
+            options.cartesianRotation[2] = FloatNode( rotation.get( "y" ) ).value();
+            options.cartesianRotation[3] = FloatNode( rotation.get( "z" ) ).value();
+         }
+
+         if ( pose.isDefined( "translation" ) )
+         {
+            const StructureNode translation( pose.get( "translation" ) );
+
+            options.cartesianTranslation[0] = FloatNode( translation.get( "x" ) ).value();
+            options.cartesianTranslation[1] = FloatNode( translation.get( "y" ) ).value();
+            options.cartesianTranslation[2] = FloatNode( translation.get( "z" ) ).value();
+         }
+
+         options.transformCartesian = true;
+      }
+
+      CompressedVectorReader reader = points.reader( destBuffers, options );
 
       return reader;
    }
@@ -1738,9 +1807,11 @@ namespace e57
 
    // Explicit template instantiation
    template CompressedVectorReader ReaderImpl::SetUpData3DPointsData(
-      int64_t dataIndex, size_t pointCount, const Data3DPointsData_t<float> &buffers ) const;
+      int64_t dataIndex, size_t pointCount, const Data3DPointsData_t<float> &buffers,
+      const CompressedVectorReaderOptions &readOptions ) const;
 
    template CompressedVectorReader ReaderImpl::SetUpData3DPointsData(
-      int64_t dataIndex, size_t pointCount, const Data3DPointsData_t<double> &buffers ) const;
+      int64_t dataIndex, size_t pointCount, const Data3DPointsData_t<double> &buffers,
+      const CompressedVectorReaderOptions &readOptions ) const;
 
 } // end namespace e57
@@ -77,7 +77,8 @@ namespace e57
 
       template <typename COORDTYPE>
       CompressedVectorReader SetUpData3DPointsData(
-         int64_t dataIndex, size_t pointCount, const Data3DPointsData_t<COORDTYPE> &buffers ) const;
+         int64_t dataIndex, size_t pointCount, const Data3DPointsData_t<COORDTYPE> &buffers,
+         const CompressedVectorReaderOptions &readOptions ) const;
 
       StructureNode GetRawE57Root() const;
 
@@ -94,5 +95,8 @@ namespace e57
       VectorNode data3D_;
 
       VectorNode images2D_;
+
+      /// Transform cartesian points by their scan's pose when reading them
+      bool applyPose_;
    }; // end Reader class
 } // end namespace e57
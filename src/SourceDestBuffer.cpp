@@ -302,6 +302,46 @@ SourceDestBuffer::SourceDestBuffer( const ImageFile &destImageFile, const ustrin
 {
 }
 
+/*!
+@brief Designate a string arena to transfer data to/from a CompressedVector as a block.
+
+@param [in] destImageFile The ImageFile where the new node will eventually be stored.
+@param [in] pathName The pathname of the field in CompressedVectorNode that will transfer data
+to/from.
+@param [in] b The caller created arena to transfer strings from/to.
+@param [in] capacity The maximum number of strings in a block.
+
+@details
+This overloaded form of the SourceDestBuffer constructor declares a StringArena to be the
+source/destination of a transfer of StringNode values stored in a CompressedVectorNode. It behaves
+like the std::vector<ustring> form, except that all of the strings of a block are stored back to
+back in @a b->data instead of in separate strings.
+
+The @a b->offsets and @a b->lengths vectors are resized to @a capacity. In a read into the
+SourceDestBuffer, @a b->data is replaced with the strings of each block, and string i of the block
+is described by @a b->offsets[i] and @a b->lengths[i]. For a write, the caller fills in all three
+members for the records to be written.
+
+The API user is responsible for ensuring that the lifetime of the @a b arena exceeds the time that
+it is used in transfers.
+
+@pre capacity must be > 0.
+@pre The @a destImageFile must be open (i.e. destImageFile.isOpen() must be true).
+
+@throw ::ErrorBadAPIArgument
+@throw ::ErrorBadPathName
+@throw ::ErrorBadBuffer
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorInternal All objects in undocumented state
+
+@see SourceDestBuffer(const ImageFile &, const ustring &, std::vector<ustring> *)
+*/
+SourceDestBuffer::SourceDestBuffer( const ImageFile &destImageFile, const ustring &pathName,
+                                    StringArena *b, size_t capacity ) :
+   impl_( new SourceDestBufferImpl( destImageFile.impl(), pathName, b, capacity ) )
+{
+}
+
 /*!
 @brief Get path name in prototype that this SourceDestBuffer will transfer data to/from.
 
@@ -476,3 +516,9 @@ void SourceDestBuffer::dump( int indent, std::ostream &os ) const
    E57_UNUSED( os );
 }
 #endif
+
+/// @cond documentNonPublic The following isn't part of the API, and isn't documented.
+SourceDestBuffer::SourceDestBuffer( std::shared_ptr<SourceDestBufferImpl> ni ) : impl_( ni )
+{
+}
+/// @endcond
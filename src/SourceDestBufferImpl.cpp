@@ -25,7 +25,11 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
 
 #include "ImageFileImpl.h"
 #include "SourceDestBufferImpl.h"
@@ -128,6 +132,31 @@ SourceDestBufferImpl::SourceDestBufferImpl( ImageFileImplWeakPtr destImageFile,
    /// stored in it.
 }
 
+SourceDestBufferImpl::SourceDestBufferImpl( ImageFileImplWeakPtr destImageFile,
+                                            const ustring &pathName, StringArena *b,
+                                            size_t capacity ) :
+   destImageFile_( destImageFile ), pathName_( pathName ), memoryRepresentation_( UString ),
+   capacity_( capacity ), stringArena_( b )
+{
+   /// don't checkImageFileOpen, checkState_ will do it
+
+   if ( b == nullptr )
+   {
+      throw E57_EXCEPTION2( ErrorBadBuffer, "sdbuf.pathName=" + pathName );
+   }
+
+   if ( capacity == 0 )
+   {
+      throw E57_EXCEPTION2( ErrorBadAPIArgument, "sdbuf.pathName=" + pathName );
+   }
+
+   checkState_();
+
+   /// One entry per string in a block
+   b->offsets.resize( capacity );
+   b->lengths.resize( capacity );
+}
+
 template <typename T> void SourceDestBufferImpl::_setNextReal( T inValue )
 {
    static_assert( std::is_same<T, double>::value || std::is_same<T, float>::value,
@@ -307,13 +336,47 @@ void SourceDestBufferImpl::checkState_() const
    }
    else
    {
-      if ( ustrings_ == nullptr )
+      if ( ( ustrings_ == nullptr ) && ( stringArena_ == nullptr ) )
       {
          throw E57_EXCEPTION2( ErrorBadBuffer, "pathName=" + pathName_ );
       }
    }
 }
 
+std::shared_ptr<SourceDestBufferImpl> SourceDestBufferImpl::window( size_t begin,
+                                                                   size_t end ) const
+{
+   if ( ( begin > end ) || ( end > capacity_ ) )
+   {
+      throw E57_EXCEPTION2( ErrorInternal, "pathName=" + pathName_ + " begin=" + toString( begin ) +
+                                              " end=" + toString( end ) +
+                                              " capacity=" + toString( capacity_ ) );
+   }
+
+   // Shares the memory (and ustrings or arena) with this buffer, only the indices differ.
+   auto result = std::make_shared<SourceDestBufferImpl>( *this );
+
+   result->nextIndex_ = static_cast<unsigned>( begin );
+   result->capacity_ = end;
+
+   return result;
+}
+
+void SourceDestBufferImpl::setNextIndex( unsigned nextIndex )
+{
+   /// don't checkImageFileOpen
+
+   /// Used after elements have been written directly through base(), so they count as set.
+   if ( nextIndex > capacity_ )
+   {
+      throw E57_EXCEPTION2( ErrorInternal, "pathName=" + pathName_ +
+                                              " nextIndex=" + toString( nextIndex ) +
+                                              " capacity=" + toString( capacity_ ) );
+   }
+
+   nextIndex_ = nextIndex;
+}
+
 int64_t SourceDestBufferImpl::getNextInt64()
 {
    /// don't checkImageFileOpen
@@ -709,6 +772,23 @@ ustring SourceDestBufferImpl::getNextString()
       throw E57_EXCEPTION2( ErrorInternal, "pathName=" + pathName_ );
    }
 
+   if ( stringArena_ != nullptr )
+   {
+      /// Copy it out of the arena, checking the caller filled in a valid range
+      const size_t offset = stringArena_->offsets[nextIndex_];
+      const size_t length = stringArena_->lengths[nextIndex_];
+
+      if ( ( offset > stringArena_->data.size() ) ||
+           ( length > stringArena_->data.size() - offset ) )
+      {
+         throw E57_EXCEPTION2( ErrorBadBuffer, "pathName=" + pathName_ +
+                                                  " offset=" + toString( offset ) +
+                                                  " length=" + toString( length ) );
+      }
+
+      return stringArena_->stringAt( nextIndex_++ );
+   }
+
    /// Get ustring from vector
    return ( ( *ustrings_ )[nextIndex_++] );
 }
@@ -939,6 +1019,485 @@ void SourceDestBufferImpl::setNextInt64( int64_t value, double scale, double off
    nextIndex_++;
 }
 
+void SourceDestBufferImpl::checkBatchRoom_( size_t count ) const
+{
+   /// Verify have room for the whole batch
+   if ( count > capacity_ - nextIndex_ )
+   {
+      throw E57_EXCEPTION2( ErrorInternal, "pathName=" + pathName_ + " count=" + toString( count ) +
+                                              " nextIndex=" + toString( nextIndex_ ) +
+                                              " capacity=" + toString( capacity_ ) );
+   }
+}
+
+void SourceDestBufferImpl::checkConversion_( bool needed ) const
+{
+   if ( needed && !doConversion_ )
+   {
+      throw E57_EXCEPTION2( ErrorConversionRequired, "pathName=" + pathName_ );
+   }
+}
+
+template <typename T>
+void SourceDestBufferImpl::_setNextInt64Batch( const int64_t *values, size_t count )
+{
+   char *p = &base_[nextIndex_ * stride_];
+
+   for ( size_t i = 0; i < count; ++i, p += stride_ )
+   {
+      if ( !convertInt64( values[i], *reinterpret_cast<T *>( p ) ) )
+      {
+         nextIndex_ += static_cast<unsigned>( i );
+         throw E57_EXCEPTION2( ErrorValueNotRepresentable,
+                               "pathName=" + pathName_ + " value=" + toString( values[i] ) );
+      }
+   }
+
+   nextIndex_ += static_cast<unsigned>( count );
+}
+
+template <typename T>
+void SourceDestBufferImpl::_setNextScaledInt64Batch( const int64_t *values, size_t count,
+                                                     double scale, double offset )
+{
+   char *p = &base_[nextIndex_ * stride_];
+
+   for ( size_t i = 0; i < count; ++i, p += stride_ )
+   {
+      if ( !convertScaledInt64( values[i], scale, offset, *reinterpret_cast<T *>( p ) ) )
+      {
+         nextIndex_ += static_cast<unsigned>( i );
+         throw E57_EXCEPTION2( ErrorScaledValueNotRepresentable,
+                               "pathName=" + pathName_ + " value=" + toString( values[i] ) +
+                                  " scale=" + toString( scale ) + " offset=" + toString( offset ) );
+      }
+   }
+
+   nextIndex_ += static_cast<unsigned>( count );
+}
+
+void SourceDestBufferImpl::setNextInt64Batch( const int64_t *values, size_t count )
+{
+   /// don't checkImageFileOpen
+
+   checkBatchRoom_( count );
+
+   switch ( memoryRepresentation_ )
+   {
+      case Int8:
+         _setNextInt64Batch<int8_t>( values, count );
+         break;
+      case UInt8:
+         _setNextInt64Batch<uint8_t>( values, count );
+         break;
+      case Int16:
+         _setNextInt64Batch<int16_t>( values, count );
+         break;
+      case UInt16:
+         _setNextInt64Batch<uint16_t>( values, count );
+         break;
+      case Int32:
+         _setNextInt64Batch<int32_t>( values, count );
+         break;
+      case UInt32:
+         _setNextInt64Batch<uint32_t>( values, count );
+         break;
+      case Int64:
+         _setNextInt64Batch<int64_t>( values, count );
+         break;
+      case Bool:
+         /// Same mapping as setNextInt64()
+         for ( size_t i = 0; i < count; ++i )
+         {
+            *reinterpret_cast<bool *>( &base_[nextIndex_ * stride_] ) =
+               ( values[i] ? false : true );
+            nextIndex_++;
+         }
+         break;
+      case Real32:
+         if ( !doConversion_ )
+         {
+            throw E57_EXCEPTION2( ErrorConversionRequired, "pathName=" + pathName_ );
+         }
+         //??? very large integers may lose some lowest bits here. error?
+         _setNextInt64Batch<float>( values, count );
+         break;
+      case Real64:
+         if ( !doConversion_ )
+         {
+            throw E57_EXCEPTION2( ErrorConversionRequired, "pathName=" + pathName_ );
+         }
+         _setNextInt64Batch<double>( values, count );
+         break;
+      case UString:
+         throw E57_EXCEPTION2( ErrorExpectingNumeric, "pathName=" + pathName_ );
+   }
+}
+
+void SourceDestBufferImpl::setNextInt64Batch( const int64_t *values, size_t count, double scale,
+                                              double offset )
+{
+   /// don't checkImageFileOpen
+
+   /// Incorporating the scale is optional (requested by user when constructing
+   /// the sdbuf). If the user did not request scaling, then we send raw values
+   /// to user's buffer.
+   if ( !doScaling_ )
+   {
+      setNextInt64Batch( values, count );
+      return;
+   }
+
+   checkBatchRoom_( count );
+
+   switch ( memoryRepresentation_ )
+   {
+      case Int8:
+         _setNextScaledInt64Batch<int8_t>( values, count, scale, offset );
+         break;
+      case UInt8:
+         _setNextScaledInt64Batch<uint8_t>( values, count, scale, offset );
+         break;
+      case Int16:
+         _setNextScaledInt64Batch<int16_t>( values, count, scale, offset );
+         break;
+      case UInt16:
+         _setNextScaledInt64Batch<uint16_t>( values, count, scale, offset );
+         break;
+      case Int32:
+         _setNextScaledInt64Batch<int32_t>( values, count, scale, offset );
+         break;
+      case UInt32:
+         _setNextScaledInt64Batch<uint32_t>( values, count, scale, offset );
+         break;
+      case Int64:
+         _setNextScaledInt64Batch<int64_t>( values, count, scale, offset );
+         break;
+      case Bool:
+         /// Same mapping as setNextInt64( value, scale, offset )
+         for ( size_t i = 0; i < count; ++i )
+         {
+            const double scaledValue = floor( values[i] * scale + offset + 0.5 );
+            *reinterpret_cast<bool *>( &base_[nextIndex_ * stride_] ) =
+               ( scaledValue ? false : true );
+            nextIndex_++;
+         }
+         break;
+      case Real32:
+         if ( !doConversion_ )
+         {
+            throw E57_EXCEPTION2( ErrorConversionRequired, "pathName=" + pathName_ );
+         }
+         _setNextScaledInt64Batch<float>( values, count, scale, offset );
+         break;
+      case Real64:
+         if ( !doConversion_ )
+         {
+            throw E57_EXCEPTION2( ErrorConversionRequired, "pathName=" + pathName_ );
+         }
+         _setNextScaledInt64Batch<double>( values, count, scale, offset );
+         break;
+      case UString:
+         throw E57_EXCEPTION2( ErrorExpectingNumeric, "pathName=" + pathName_ );
+   }
+}
+
+template <typename T, typename InT>
+void SourceDestBufferImpl::_setNextRealAs( const InT *values, size_t count )
+{
+   /// Same range checks as _setNextReal(), for integer and single precision buffers
+   constexpr bool cIsFloat = std::is_same<T, float>::value;
+   constexpr bool cCheckRange = !std::is_same<T, InT>::value && !std::is_same<T, double>::value;
+   const auto cMin = static_cast<InT>( cIsFloat ? DOUBLE_MIN : std::numeric_limits<T>::lowest() );
+   const auto cMax = static_cast<InT>( cIsFloat ? DOUBLE_MAX : std::numeric_limits<T>::max() );
+
+   char *p = &base_[nextIndex_ * stride_];
+
+   /// Same type packed without gaps, so the whole run can be copied
+   if ( std::is_same<T, InT>::value && ( stride_ == sizeof( T ) ) )
+   {
+      memcpy( p, values, count * sizeof( T ) );
+      nextIndex_ += static_cast<unsigned>( count );
+      return;
+   }
+
+   for ( size_t i = 0; i < count; ++i, p += stride_ )
+   {
+      const InT value = values[i];
+
+      if ( cCheckRange && ( value < cMin || cMax < value ) )
+      {
+         nextIndex_ += static_cast<unsigned>( i );
+         throw E57_EXCEPTION2( ErrorValueNotRepresentable,
+                               "pathName=" + pathName_ + " value=" + toString( value ) );
+      }
+
+      *reinterpret_cast<T *>( p ) = static_cast<T>( value );
+   }
+
+   nextIndex_ += static_cast<unsigned>( count );
+}
+
+template <typename InT>
+void SourceDestBufferImpl::_setNextRealBatch( const InT *values, size_t count )
+{
+   /// don't checkImageFileOpen
+
+   checkBatchRoom_( count );
+
+   switch ( memoryRepresentation_ )
+   {
+      case Int8:
+         checkConversion_( true );
+         _setNextRealAs<int8_t>( values, count );
+         break;
+      case UInt8:
+         checkConversion_( true );
+         _setNextRealAs<uint8_t>( values, count );
+         break;
+      case Int16:
+         checkConversion_( true );
+         _setNextRealAs<int16_t>( values, count );
+         break;
+      case UInt16:
+         checkConversion_( true );
+         _setNextRealAs<uint16_t>( values, count );
+         break;
+      case Int32:
+         checkConversion_( true );
+         _setNextRealAs<int32_t>( values, count );
+         break;
+      case UInt32:
+         checkConversion_( true );
+         _setNextRealAs<uint32_t>( values, count );
+         break;
+      case Int64:
+         checkConversion_( true );
+         _setNextRealAs<int64_t>( values, count );
+         break;
+      case Bool:
+         checkConversion_( true );
+
+         /// Same mapping as _setNextReal()
+         for ( size_t i = 0; i < count; ++i )
+         {
+            *reinterpret_cast<bool *>( &base_[nextIndex_ * stride_] ) =
+               ( values[i] ? false : true );
+            nextIndex_++;
+         }
+         break;
+      case Real32:
+         _setNextRealAs<float>( values, count );
+         break;
+      case Real64:
+         _setNextRealAs<double>( values, count );
+         break;
+      case UString:
+         throw E57_EXCEPTION2( ErrorExpectingNumeric, "pathName=" + pathName_ );
+   }
+}
+
+void SourceDestBufferImpl::setNextFloatBatch( const float *values, size_t count )
+{
+   _setNextRealBatch( values, count );
+}
+
+void SourceDestBufferImpl::setNextDoubleBatch( const double *values, size_t count )
+{
+   _setNextRealBatch( values, count );
+}
+
+template <typename T, typename OutT>
+void SourceDestBufferImpl::_getNextAs( OutT *values, size_t count )
+{
+   /// Single precision can't hold the largest doubles, like getNextFloat() checks
+   constexpr bool cCheckRange = std::is_same<T, double>::value && std::is_same<OutT, float>::value;
+
+   const char *p = &base_[nextIndex_ * stride_];
+
+   /// Same type packed without gaps, so the whole run can be copied
+   if ( std::is_same<T, OutT>::value && ( stride_ == sizeof( T ) ) )
+   {
+      memcpy( values, p, count * sizeof( T ) );
+      nextIndex_ += static_cast<unsigned>( count );
+      return;
+   }
+
+   for ( size_t i = 0; i < count; ++i, p += stride_ )
+   {
+      const T value = *reinterpret_cast<const T *>( p );
+
+      if ( cCheckRange && ( value < DOUBLE_MIN || DOUBLE_MAX < value ) )
+      {
+         nextIndex_ += static_cast<unsigned>( i );
+         throw E57_EXCEPTION2( ErrorReal64TooLarge,
+                               "pathName=" + pathName_ + " value=" + toString( value ) );
+      }
+
+      values[i] = static_cast<OutT>( value );
+   }
+
+   nextIndex_ += static_cast<unsigned>( count );
+}
+
+template <typename OutT> void SourceDestBufferImpl::_getNextBatch( OutT *values, size_t count )
+{
+   /// don't checkImageFileOpen
+
+   checkBatchRoom_( count );
+
+   /// Reading an integer buffer as floating point (or the other way around) is a conversion
+   constexpr bool cIntegerOut = std::is_integral<OutT>::value;
+
+   switch ( memoryRepresentation_ )
+   {
+      case Int8:
+         checkConversion_( !cIntegerOut );
+         _getNextAs<int8_t>( values, count );
+         break;
+      case UInt8:
+         checkConversion_( !cIntegerOut );
+         _getNextAs<uint8_t>( values, count );
+         break;
+      case Int16:
+         checkConversion_( !cIntegerOut );
+         _getNextAs<int16_t>( values, count );
+         break;
+      case UInt16:
+         checkConversion_( !cIntegerOut );
+         _getNextAs<uint16_t>( values, count );
+         break;
+      case Int32:
+         checkConversion_( !cIntegerOut );
+         _getNextAs<int32_t>( values, count );
+         break;
+      case UInt32:
+         checkConversion_( !cIntegerOut );
+         _getNextAs<uint32_t>( values, count );
+         break;
+      case Int64:
+         checkConversion_( !cIntegerOut );
+         _getNextAs<int64_t>( values, count );
+         break;
+      case Bool:
+         /// Converts to 0/1
+         checkConversion_( true );
+         _getNextAs<bool>( values, count );
+         break;
+      case Real32:
+         checkConversion_( cIntegerOut );
+         _getNextAs<float>( values, count );
+         break;
+      case Real64:
+         checkConversion_( cIntegerOut );
+         _getNextAs<double>( values, count );
+         break;
+      case UString:
+         throw E57_EXCEPTION2( ErrorExpectingNumeric, "pathName=" + pathName_ );
+   }
+}
+
+void SourceDestBufferImpl::getNextInt64Batch( int64_t *values, size_t count )
+{
+   _getNextBatch( values, count );
+}
+
+template <typename T>
+void SourceDestBufferImpl::_getNextScaledInt64Batch( int64_t *values, size_t count, double scale,
+                                                     double offset )
+{
+   const char *p = &base_[nextIndex_ * stride_];
+
+   for ( size_t i = 0; i < count; ++i, p += stride_ )
+   {
+      /// Calc (x-offset)/scale rounded to nearest integer, but keep in floating point until sure
+      /// is in bounds
+      const double doubleRawValue =
+         floor( ( static_cast<double>( *reinterpret_cast<const T *>( p ) ) - offset ) / scale +
+                0.5 );
+
+      if ( doubleRawValue < INT64_MIN || ( doubleRawValue > ( static_cast<double>( INT64_MAX ) ) ) )
+      {
+         nextIndex_ += static_cast<unsigned>( i );
+         throw E57_EXCEPTION2( ErrorScaledValueNotRepresentable,
+                               "pathName=" + pathName_ + " value=" + toString( doubleRawValue ) );
+      }
+
+      values[i] = static_cast<int64_t>( doubleRawValue );
+   }
+
+   nextIndex_ += static_cast<unsigned>( count );
+}
+
+void SourceDestBufferImpl::getNextInt64Batch( int64_t *values, size_t count, double scale,
+                                              double offset )
+{
+   /// don't checkImageFileOpen
+
+   /// If the user did not request scaling, then we get raw values from user's buffer.
+   if ( !doScaling_ )
+   {
+      getNextInt64Batch( values, count );
+      return;
+   }
+
+   /// Double check non-zero scale.  Going to divide by it below.
+   if ( scale == 0 )
+   {
+      throw E57_EXCEPTION2( ErrorInternal, "pathName=" + pathName_ );
+   }
+
+   checkBatchRoom_( count );
+
+   switch ( memoryRepresentation_ )
+   {
+      case Int8:
+         _getNextScaledInt64Batch<int8_t>( values, count, scale, offset );
+         break;
+      case UInt8:
+         _getNextScaledInt64Batch<uint8_t>( values, count, scale, offset );
+         break;
+      case Int16:
+         _getNextScaledInt64Batch<int16_t>( values, count, scale, offset );
+         break;
+      case UInt16:
+         _getNextScaledInt64Batch<uint16_t>( values, count, scale, offset );
+         break;
+      case Int32:
+         _getNextScaledInt64Batch<int32_t>( values, count, scale, offset );
+         break;
+      case UInt32:
+         _getNextScaledInt64Batch<uint32_t>( values, count, scale, offset );
+         break;
+      case Int64:
+         _getNextScaledInt64Batch<int64_t>( values, count, scale, offset );
+         break;
+      case Bool:
+         _getNextScaledInt64Batch<bool>( values, count, scale, offset );
+         break;
+      case Real32:
+         checkConversion_( true );
+         _getNextScaledInt64Batch<float>( values, count, scale, offset );
+         break;
+      case Real64:
+         checkConversion_( true );
+         _getNextScaledInt64Batch<double>( values, count, scale, offset );
+         break;
+      case UString:
+         throw E57_EXCEPTION2( ErrorExpectingNumeric, "pathName=" + pathName_ );
+   }
+}
+
+void SourceDestBufferImpl::getNextFloatBatch( float *values, size_t count )
+{
+   _getNextBatch( values, count );
+}
+
+void SourceDestBufferImpl::getNextDoubleBatch( double *values, size_t count )
+{
+   _getNextBatch( values, count );
+}
+
 void SourceDestBufferImpl::setNextFloat( float value )
 {
    _setNextReal( value );
@@ -969,6 +1528,291 @@ void SourceDestBufferImpl::setNextString( const ustring &value )
    nextIndex_++;
 }
 
+void SourceDestBufferImpl::setNextString( const char *value, size_t length )
+{
+   /// don't checkImageFileOpen
+
+   if ( memoryRepresentation_ != UString )
+   {
+      throw E57_EXCEPTION2( ErrorExpectingUString, "pathName=" + pathName_ );
+   }
+
+   /// Verify have room.
+   if ( nextIndex_ >= capacity_ )
+   {
+      throw E57_EXCEPTION2( ErrorInternal, "pathName=" + pathName_ );
+   }
+
+   if ( stringArena_ != nullptr )
+   {
+      /// The arena only holds the current block, so start over with its first string
+      if ( nextIndex_ == 0 )
+      {
+         stringArena_->data.clear();
+      }
+
+      stringArena_->offsets[nextIndex_] = stringArena_->data.size();
+      stringArena_->lengths[nextIndex_] = length;
+      stringArena_->data.insert( stringArena_->data.end(), value, value + length );
+   }
+   else
+   {
+      /// Reuses the element's existing allocation if it is big enough
+      ( *ustrings_ )[nextIndex_].assign( value, length );
+   }
+
+   nextIndex_++;
+}
+
+namespace
+{
+   /// Clear pass[i - begin] for each element of type T in [begin, end) where
+   /// compare( element, value ) is false, with the element converted to ValueT.
+   template <typename T, typename ValueT, typename CompareT>
+   void filterElements( const char *base, size_t stride, unsigned begin, unsigned end,
+                        CompareT compare, ValueT value, std::vector<uint8_t> &pass )
+   {
+      for ( unsigned i = begin; i < end; ++i )
+      {
+         const T element = *reinterpret_cast<const T *>( &base[i * stride] );
+
+         if ( !compare( static_cast<ValueT>( element ), value ) )
+         {
+            pass[i - begin] = 0;
+         }
+      }
+   }
+
+   /// Pick the comparison once, so the inner loop is a tight loop over one type. Returns false
+   /// if comparison isn't one we know.
+   template <typename T, typename ValueT>
+   bool filterElements( const char *base, size_t stride, unsigned begin, unsigned end,
+                        FilterComparison comparison, ValueT value, std::vector<uint8_t> &pass )
+   {
+      switch ( comparison )
+      {
+         case FilterEqual:
+            filterElements<T>( base, stride, begin, end, std::equal_to<ValueT>(), value, pass );
+            return true;
+         case FilterNotEqual:
+            filterElements<T>( base, stride, begin, end, std::not_equal_to<ValueT>(), value, pass );
+            return true;
+         case FilterLess:
+            filterElements<T>( base, stride, begin, end, std::less<ValueT>(), value, pass );
+            return true;
+         case FilterLessEqual:
+            filterElements<T>( base, stride, begin, end, std::less_equal<ValueT>(), value, pass );
+            return true;
+         case FilterGreater:
+            filterElements<T>( base, stride, begin, end, std::greater<ValueT>(), value, pass );
+            return true;
+         case FilterGreaterEqual:
+            filterElements<T>( base, stride, begin, end, std::greater_equal<ValueT>(), value,
+                               pass );
+            return true;
+         default:
+            return false;
+      }
+   }
+
+   /// Clear pass[0, count) if an element below value (belowValue) or above it (!belowValue)
+   /// fails comparison. Returns false if comparison isn't one we know.
+   bool filterAllElements( FilterComparison comparison, bool belowValue, size_t count,
+                           std::vector<uint8_t> &pass )
+   {
+      bool passes = false;
+
+      switch ( comparison )
+      {
+         case FilterEqual:
+            break;
+         case FilterNotEqual:
+            passes = true;
+            break;
+         case FilterLess:
+         case FilterLessEqual:
+            passes = belowValue;
+            break;
+         case FilterGreater:
+         case FilterGreaterEqual:
+            passes = !belowValue;
+            break;
+         default:
+            return false;
+      }
+
+      if ( !passes )
+      {
+         std::fill( pass.begin(), pass.begin() + count, uint8_t{ 0 } );
+      }
+
+      return true;
+   }
+}
+
+template <typename T>
+void SourceDestBufferImpl::_filterRecords( unsigned begin, unsigned end,
+                                           FilterComparison comparison, double value,
+                                           std::vector<uint8_t> &pass ) const
+{
+   // 2^63, the first whole number beyond int64_t
+   constexpr double cInt64Limit = 9223372036854775808.0;
+
+   bool known = false;
+
+   // Integers are compared with whole numbers as int64_t, since converting them to double rounds
+   // those beyond 2^53. Doubles with a fraction are all below 2^52, where the rounding never
+   // changes how an integer compares to them, so comparing as double is exact for those.
+   if ( std::is_integral<T>::value && ( std::floor( value ) == value ) )
+   {
+      if ( ( -cInt64Limit <= value ) && ( value < cInt64Limit ) )
+      {
+         known = filterElements<T>( base_, stride_, begin, end, comparison,
+                                    static_cast<int64_t>( value ), pass );
+      }
+      else
+      {
+         // Every element is on the same side of the value
+         known = filterAllElements( comparison, value > 0.0, end - begin, pass );
+      }
+   }
+   else
+   {
+      known = filterElements<T>( base_, stride_, begin, end, comparison, value, pass );
+   }
+
+   if ( !known )
+   {
+      throw E57_EXCEPTION2( ErrorBadAPIArgument, "comparison=" + toString( comparison ) +
+                                                    " pathName=" + pathName_ );
+   }
+}
+
+void SourceDestBufferImpl::filterRecords( unsigned begin, unsigned end,
+                                          FilterComparison comparison, double value,
+                                          std::vector<uint8_t> &pass ) const
+{
+   /// don't checkImageFileOpen
+
+   if ( ( begin > end ) || ( end > capacity_ ) || ( pass.size() < end - begin ) )
+   {
+      throw E57_EXCEPTION2( ErrorInternal, "pathName=" + pathName_ );
+   }
+
+   switch ( memoryRepresentation_ )
+   {
+      case Int8:
+         _filterRecords<int8_t>( begin, end, comparison, value, pass );
+         break;
+      case UInt8:
+         _filterRecords<uint8_t>( begin, end, comparison, value, pass );
+         break;
+      case Int16:
+         _filterRecords<int16_t>( begin, end, comparison, value, pass );
+         break;
+      case UInt16:
+         _filterRecords<uint16_t>( begin, end, comparison, value, pass );
+         break;
+      case Int32:
+         _filterRecords<int32_t>( begin, end, comparison, value, pass );
+         break;
+      case UInt32:
+         _filterRecords<uint32_t>( begin, end, comparison, value, pass );
+         break;
+      case Int64:
+         _filterRecords<int64_t>( begin, end, comparison, value, pass );
+         break;
+      case Bool:
+         _filterRecords<bool>( begin, end, comparison, value, pass );
+         break;
+      case Real32:
+         _filterRecords<float>( begin, end, comparison, value, pass );
+         break;
+      case Real64:
+         _filterRecords<double>( begin, end, comparison, value, pass );
+         break;
+      case UString:
+         throw E57_EXCEPTION2( ErrorExpectingNumeric, "pathName=" + pathName_ );
+      default:
+         throw E57_EXCEPTION2( ErrorInternal, "pathName=" + pathName_ );
+   }
+}
+
+void SourceDestBufferImpl::compactRecords( unsigned begin, const std::vector<uint8_t> &pass )
+{
+   /// don't checkImageFileOpen
+
+   if ( ( begin > nextIndex_ ) || ( pass.size() < nextIndex_ - begin ) )
+   {
+      throw E57_EXCEPTION2( ErrorInternal, "pathName=" + pathName_ );
+   }
+
+   /// Only copy the element itself, stride_ may include other user data between elements.
+   size_t elementSize = 0;
+   switch ( memoryRepresentation_ )
+   {
+      case Int8:
+      case UInt8:
+         elementSize = sizeof( int8_t );
+         break;
+      case Int16:
+      case UInt16:
+         elementSize = sizeof( int16_t );
+         break;
+      case Int32:
+      case UInt32:
+         elementSize = sizeof( int32_t );
+         break;
+      case Int64:
+         elementSize = sizeof( int64_t );
+         break;
+      case Bool:
+         elementSize = sizeof( bool );
+         break;
+      case Real32:
+         elementSize = sizeof( float );
+         break;
+      case Real64:
+         elementSize = sizeof( double );
+         break;
+      case UString:
+         break;
+      default:
+         throw E57_EXCEPTION2( ErrorInternal, "pathName=" + pathName_ );
+   }
+
+   unsigned destIndex = begin;
+   for ( unsigned i = begin; i < nextIndex_; ++i )
+   {
+      if ( pass[i - begin] == 0 )
+      {
+         continue;
+      }
+
+      if ( destIndex != i )
+      {
+         if ( stringArena_ != nullptr )
+         {
+            /// The bytes stay where they are in the arena
+            stringArena_->offsets[destIndex] = stringArena_->offsets[i];
+            stringArena_->lengths[destIndex] = stringArena_->lengths[i];
+         }
+         else if ( memoryRepresentation_ == UString )
+         {
+            ( *ustrings_ )[destIndex] = std::move( ( *ustrings_ )[i] );
+         }
+         else
+         {
+            std::memcpy( &base_[destIndex * stride_], &base_[i * stride_], elementSize );
+         }
+      }
+
+      ++destIndex;
+   }
+
+   nextIndex_ = destIndex;
+}
+
 void SourceDestBufferImpl::checkCompatible(
    const std::shared_ptr<SourceDestBufferImpl> &newBuf ) const
 {
@@ -1053,6 +1897,8 @@ void SourceDestBufferImpl::dump( int indent, std::ostream &os )
       << std::endl;
    os << space( indent ) << "ustrings:             " << static_cast<const void *>( ustrings_ )
       << std::endl;
+   os << space( indent ) << "stringArena:          " << static_cast<const void *>( stringArena_ )
+      << std::endl;
    os << space( indent ) << "capacity:             " << capacity_ << std::endl;
    os << space( indent ) << "doConversion:         " << doConversion_ << std::endl;
    os << space( indent ) << "doScaling:            " << doScaling_ << std::endl;
@@ -27,6 +27,9 @@
 
 #pragma once
 
+#include <cmath>
+#include <limits>
+
 #include "Common.h"
 
 namespace e57
@@ -43,6 +46,8 @@ namespace e57
 
       SourceDestBufferImpl( ImageFileImplWeakPtr destImageFile, const ustring &pathName,
                             StringList *b );
+      SourceDestBufferImpl( ImageFileImplWeakPtr destImageFile, const ustring &pathName,
+                            StringArena *b, size_t capacity );
 
       ImageFileImplWeakPtr destImageFile() const
       {
@@ -69,6 +74,11 @@ namespace e57
          return ustrings_;
       }
 
+      StringArena *stringArena() const
+      {
+         return stringArena_;
+      }
+
       bool doConversion() const
       {
          return doConversion_;
@@ -99,6 +109,8 @@ namespace e57
          nextIndex_ = 0;
       }
 
+      void setNextIndex( unsigned nextIndex );
+
       int64_t getNextInt64();
       int64_t getNextInt64( double scale, double offset );
       float getNextFloat();
@@ -109,15 +121,99 @@ namespace e57
       void setNextFloat( float value );
       void setNextDouble( double value );
       void setNextString( const ustring &value );
+      void setNextString( const char *value, size_t length );
+
+      /// Same as calling setNextInt64() for each of the count values, but only checks the buffer
+      /// and its representation once.
+      void setNextInt64Batch( const int64_t *values, size_t count );
+      void setNextInt64Batch( const int64_t *values, size_t count, double scale, double offset );
+      void setNextFloatBatch( const float *values, size_t count );
+      void setNextDoubleBatch( const double *values, size_t count );
+
+      /// Same as calling getNextInt64() etc. for each of the count values.
+      void getNextInt64Batch( int64_t *values, size_t count );
+      void getNextInt64Batch( int64_t *values, size_t count, double scale, double offset );
+      void getNextFloatBatch( float *values, size_t count );
+      void getNextDoubleBatch( double *values, size_t count );
+
+      /// Clear pass[i - begin] for each element i in [begin, end) which fails the comparison.
+      void filterRecords( unsigned begin, unsigned end, FilterComparison comparison, double value,
+                          std::vector<uint8_t> &pass ) const;
+
+      /// Drop the elements in [begin, nextIndex()) whose pass[i - begin] is zero, moving the rest
+      /// down so they are contiguous.
+      void compactRecords( unsigned begin, const std::vector<uint8_t> &pass );
 
       void checkCompatible( const std::shared_ptr<SourceDestBufferImpl> &newBuf ) const;
 
+      /// A copy of this buffer which only covers the elements [begin, end), starting at begin.
+      std::shared_ptr<SourceDestBufferImpl> window( size_t begin, size_t end ) const;
+
+      /// Convert an integer from the file to a T the way setNextInt64() does. Returns false if
+      /// the value can't be represented. Doesn't handle bool, which setNextInt64() maps
+      /// differently.
+      template <typename T> static bool convertInt64( int64_t value, T &result )
+      {
+         /// Integers narrower than int64_t need a range check
+         constexpr bool cCheckRange =
+            std::is_integral<T>::value && ( sizeof( T ) < sizeof( int64_t ) );
+         const auto cMin = static_cast<int64_t>( std::numeric_limits<T>::lowest() );
+         const auto cMax = static_cast<int64_t>( std::numeric_limits<T>::max() );
+
+         if ( cCheckRange && ( value < cMin || cMax < value ) )
+         {
+            return false;
+         }
+
+         result = static_cast<T>( value );
+         return true;
+      }
+
+      /// Convert an integer from the file to value * scale + offset as a T the way
+      /// setNextInt64( value, scale, offset ) does. Floating point keeps full resolution, integers
+      /// are rounded to nearest. Returns false if the scaled value can't be represented.
+      template <typename T>
+      static bool convertScaledInt64( int64_t value, double scale, double offset, T &result )
+      {
+         constexpr bool cIsFloat = std::is_floating_point<T>::value;
+         constexpr bool cCheckRange =
+            std::is_integral<T>::value && ( sizeof( T ) < sizeof( int64_t ) );
+         const auto cMin = static_cast<double>( std::numeric_limits<T>::lowest() );
+         const auto cMax = static_cast<double>( std::numeric_limits<T>::max() );
+
+         const double scaledValue =
+            cIsFloat ? ( value * scale + offset ) : std::floor( value * scale + offset + 0.5 );
+
+         if ( cCheckRange && ( scaledValue < cMin || cMax < scaledValue ) )
+         {
+            return false;
+         }
+
+         result = static_cast<T>( scaledValue );
+         return true;
+      }
+
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
       void dump( int indent = 0, std::ostream &os = std::cout );
 #endif
 
    private:
       template <typename T> void _setNextReal( T inValue );
+      template <typename T> void _setNextInt64Batch( const int64_t *values, size_t count );
+      template <typename T>
+      void _setNextScaledInt64Batch( const int64_t *values, size_t count, double scale,
+                                     double offset );
+      template <typename InT> void _setNextRealBatch( const InT *values, size_t count );
+      template <typename T, typename InT> void _setNextRealAs( const InT *values, size_t count );
+      template <typename OutT> void _getNextBatch( OutT *values, size_t count );
+      template <typename T, typename OutT> void _getNextAs( OutT *values, size_t count );
+      template <typename T>
+      void _getNextScaledInt64Batch( int64_t *values, size_t count, double scale, double offset );
+      void checkBatchRoom_( size_t count ) const;
+      void checkConversion_( bool needed ) const;
+      template <typename T>
+      void _filterRecords( unsigned begin, unsigned end, FilterComparison comparison, double value,
+                           std::vector<uint8_t> &pass ) const;
 
       /// Common routine to check that constructor arguments were ok, throws if not
       void checkState_() const;
@@ -151,5 +247,8 @@ namespace e57
 
       /// Optional array of ustrings (used if memoryRepresentation_ == ::UString)
       StringList *ustrings_ = nullptr;
+
+      /// Optional string arena (used instead of ustrings_ if memoryRepresentation_ == ::UString)
+      StringArena *stringArena_ = nullptr;
    };
 }
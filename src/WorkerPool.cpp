@@ -0,0 +1,133 @@
+// SPDX-License-Identifier: BSL-1.0
+// Copyright 2026 libE57Format contributors
+
+#include "WorkerPool.h"
+
+namespace e57
+{
+   WorkerPool::WorkerPool( unsigned threadCount )
+   {
+      if ( threadCount == 0 )
+      {
+         threadCount = std::thread::hardware_concurrency();
+      }
+
+      // The calling thread does its share, so it needs one less
+      for ( unsigned i = 1; i < threadCount; ++i )
+      {
+         threads_.emplace_back( &WorkerPool::workerLoop, this );
+      }
+   }
+
+   WorkerPool::~WorkerPool()
+   {
+      {
+         std::lock_guard<std::mutex> lock( mutex_ );
+         stopping_ = true;
+      }
+
+      wakeWorkers_.notify_all();
+
+      for ( auto &thread : threads_ )
+      {
+         thread.join();
+      }
+   }
+
+   void WorkerPool::run( size_t taskCount, const std::function<void( size_t )> &task )
+   {
+      // Not worth waking anyone up
+      if ( threads_.empty() || ( taskCount < 2 ) )
+      {
+         for ( size_t i = 0; i < taskCount; ++i )
+         {
+            task( i );
+         }
+         return;
+      }
+
+      {
+         std::lock_guard<std::mutex> lock( mutex_ );
+
+         task_ = &task;
+         taskCount_ = taskCount;
+         nextTask_ = 0;
+         busyWorkers_ = threads_.size();
+         error_ = nullptr;
+         ++generation_;
+      }
+
+      wakeWorkers_.notify_all();
+
+      runTasks();
+
+      std::exception_ptr error;
+      {
+         std::unique_lock<std::mutex> lock( mutex_ );
+         workersDone_.wait( lock, [this] { return busyWorkers_ == 0; } );
+
+         task_ = nullptr;
+         std::swap( error, error_ );
+      }
+
+      if ( error )
+      {
+         std::rethrow_exception( error );
+      }
+   }
+
+   void WorkerPool::workerLoop()
+   {
+      uint64_t generation = 0;
+
+      while ( true )
+      {
+         {
+            std::unique_lock<std::mutex> lock( mutex_ );
+            wakeWorkers_.wait( lock,
+                               [&] { return stopping_ || ( generation_ != generation ); } );
+
+            if ( stopping_ )
+            {
+               return;
+            }
+
+            generation = generation_;
+         }
+
+         runTasks();
+
+         std::lock_guard<std::mutex> lock( mutex_ );
+         if ( --busyWorkers_ == 0 )
+         {
+            workersDone_.notify_one();
+         }
+      }
+   }
+
+   void WorkerPool::runTasks()
+   {
+      while ( true )
+      {
+         const size_t i = nextTask_++;
+         if ( i >= taskCount_ )
+         {
+            return;
+         }
+
+         try
+         {
+            ( *task_ )( i );
+         }
+         catch ( ... )
+         {
+            std::lock_guard<std::mutex> lock( mutex_ );
+            if ( !error_ || ( i < errorTask_ ) )
+            {
+               error_ = std::current_exception();
+               errorTask_ = i;
+            }
+         }
+      }
+   }
+}
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: BSL-1.0
+// Copyright 2026 libE57Format contributors
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace e57
+{
+   /// A fixed set of threads which run batches of independent tasks, e.g. encoding each field
+   /// of a data packet.
+   class WorkerPool
+   {
+   public:
+      /// Tasks are spread over threadCount threads, including the thread calling run(). Passing
+      /// 0 uses one thread per hardware core, and 1 runs everything on the calling thread.
+      explicit WorkerPool( unsigned threadCount );
+      ~WorkerPool();
+
+      WorkerPool( const WorkerPool & ) = delete;
+      WorkerPool &operator=( const WorkerPool & ) = delete;
+
+      /// Number of threads tasks run on, including the calling thread
+      unsigned threadCount() const
+      {
+         return static_cast<unsigned>( threads_.size() ) + 1;
+      }
+
+      /// Call task( i ) for each i in [0, taskCount) and wait for them all to finish. If any
+      /// tasks throw, the exception from the lowest i is rethrown, the same one a serial loop
+      /// would have thrown.
+      void run( size_t taskCount, const std::function<void( size_t )> &task );
+
+   private:
+      void workerLoop();
+      void runTasks();
+
+      std::vector<std::thread> threads_;
+
+      std::mutex mutex_;
+      std::condition_variable wakeWorkers_;
+      std::condition_variable workersDone_;
+
+      /// The current batch, set by run() under mutex_
+      const std::function<void( size_t )> *task_ = nullptr;
+      size_t taskCount_ = 0;
+      uint64_t generation_ = 0;
+      bool stopping_ = false;
+
+      /// Index of the next task to hand out
+      std::atomic<size_t> nextTask_{ 0 };
+
+      /// Number of workers still running tasks from the current batch
+      size_t busyWorkers_ = 0;
+
+      /// First failure in the current batch (by task index)
+      std::exception_ptr error_;
+      size_t errorTask_ = 0;
+   };
+}
@@ -0,0 +1,173 @@
+// SPDX-License-Identifier: BSL-1.0
+// Copyright 2026 libE57Format contributors
+
+#include <algorithm>
+
+#include "WriteBehindQueue.h"
+#include "CheckedFile.h"
+#include "ImageFileImpl.h"
+
+namespace e57
+{
+   WriteBehindQueue::WriteBehindQueue( ImageFileImplSharedPtr imf, size_t maxPending ) :
+      imf_( std::move( imf ) ), maxPending_( std::max( maxPending, static_cast<size_t>( 1 ) ) )
+   {
+      thread_ = std::thread( &WriteBehindQueue::threadLoop, this );
+   }
+
+   WriteBehindQueue::~WriteBehindQueue()
+   {
+      {
+         std::lock_guard<std::mutex> lock( mutex_ );
+         stopping_ = true;
+         pending_.clear();
+      }
+
+      blockQueued_.notify_one();
+
+      thread_.join();
+   }
+
+   void WriteBehindQueue::write( uint64_t logicalOffset, const char *bytes, size_t length )
+   {
+      std::unique_lock<std::mutex> lock( mutex_ );
+
+      blockWritten_.wait( lock, [this] { return error_ || ( pending_.size() < maxPending_ ); } );
+
+      rethrowError();
+
+      Block block;
+      block.logicalOffset = logicalOffset;
+
+      if ( !spare_.empty() )
+      {
+         block.bytes = std::move( spare_.back() );
+         spare_.pop_back();
+      }
+
+      block.bytes.assign( bytes, bytes + length );
+
+      pending_.push_back( std::move( block ) );
+
+      lock.unlock();
+      blockQueued_.notify_one();
+   }
+
+   void WriteBehindQueue::writePages( std::vector<char> &&pages, size_t pageIndex,
+                                      size_t pageCount, uint64_t firstPage )
+   {
+      std::unique_lock<std::mutex> lock( mutex_ );
+
+      blockWritten_.wait( lock, [this] { return error_ || ( pending_.size() < maxPending_ ); } );
+
+      rethrowError();
+
+      Block block;
+      block.bytes = std::move( pages );
+      block.pageCount = pageCount;
+      block.pageIndex = pageIndex;
+      block.firstPage = firstPage;
+
+      pending_.push_back( std::move( block ) );
+
+      lock.unlock();
+      blockQueued_.notify_one();
+   }
+
+   std::vector<char> WriteBehindQueue::takeSparePages()
+   {
+      std::lock_guard<std::mutex> lock( mutex_ );
+
+      std::vector<char> pages;
+
+      if ( !sparePages_.empty() )
+      {
+         pages = std::move( sparePages_.back() );
+         sparePages_.pop_back();
+      }
+
+      return pages;
+   }
+
+   void WriteBehindQueue::finish()
+   {
+      std::unique_lock<std::mutex> lock( mutex_ );
+
+      blockWritten_.wait( lock, [this] { return error_ || ( pending_.empty() && !writing_ ); } );
+
+      rethrowError();
+   }
+
+   void WriteBehindQueue::threadLoop()
+   {
+      while ( true )
+      {
+         Block block;
+         {
+            std::unique_lock<std::mutex> lock( mutex_ );
+            blockQueued_.wait( lock, [this] { return stopping_ || !pending_.empty(); } );
+
+            if ( stopping_ )
+            {
+               return;
+            }
+
+            block = std::move( pending_.front() );
+            pending_.pop_front();
+            writing_ = true;
+         }
+
+         std::exception_ptr error;
+         try
+         {
+            std::lock_guard<std::mutex> fileLock( imf_->fileMutex_ );
+
+            if ( block.pageCount > 0 )
+            {
+               char *pages = &block.bytes[block.pageIndex * CheckedFile::physicalPageSize];
+               imf_->file_->writePhysicalPages( pages, block.firstPage, block.pageCount );
+            }
+            else
+            {
+               imf_->file_->seek( block.logicalOffset );
+               imf_->file_->write( block.bytes.data(), block.bytes.size() );
+            }
+         }
+         catch ( ... )
+         {
+            error = std::current_exception();
+         }
+
+         {
+            std::lock_guard<std::mutex> lock( mutex_ );
+            writing_ = false;
+
+            if ( error )
+            {
+               // Nothing after a failed block is any use
+               error_ = error;
+               pending_.clear();
+            }
+            else if ( block.pageCount > 0 )
+            {
+               sparePages_.push_back( std::move( block.bytes ) );
+            }
+            else
+            {
+               spare_.push_back( std::move( block.bytes ) );
+            }
+         }
+
+         blockWritten_.notify_all();
+      }
+   }
+
+   // Called with mutex_ held
+   void WriteBehindQueue::rethrowError()
+   {
+      if ( error_ )
+      {
+         std::rethrow_exception( error_ );
+      }
+   }
+}
@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: BSL-1.0
+// Copyright 2026 libE57Format contributors
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Common.h"
+
+namespace e57
+{
+   /// Writes blocks of bytes to an ImageFile on a thread of its own, so the caller can carry on
+   /// (e.g. encoding the next data packet) while the paging, checksums, and disk writes happen.
+   class WriteBehindQueue
+   {
+   public:
+      /// At most maxPending blocks are queued, after which write() waits for one to be written.
+      WriteBehindQueue( ImageFileImplSharedPtr imf, size_t maxPending );
+
+      /// Anything not written yet is dropped, call finish() first to keep it.
+      ~WriteBehindQueue();
+
+      WriteBehindQueue( const WriteBehindQueue & ) = delete;
+      WriteBehindQueue &operator=( const WriteBehindQueue & ) = delete;
+
+      /// Queue a copy of length bytes to be written at logicalOffset. Blocks are written in the
+      /// order they are queued. If an earlier block failed, its exception is rethrown here.
+      void write( uint64_t logicalOffset, const char *bytes, size_t length );
+
+      /// Queue pageCount whole physical pages, from pageIndex on in pages, to be written at
+      /// physical page firstPage (see CheckedFile::writePhysicalPages()). Takes pages over
+      /// instead of copying it.
+      void writePages( std::vector<char> &&pages, size_t pageIndex, size_t pageCount,
+                       uint64_t firstPage );
+
+      /// A buffer passed to writePages() earlier which has been written, to save allocating a new
+      /// one. Empty if there isn't one.
+      std::vector<char> takeSparePages();
+
+      /// Wait for everything queued to be written, and rethrow the first failure if there was one.
+      void finish();
+
+   private:
+      struct Block
+      {
+         uint64_t logicalOffset = 0;
+         std::vector<char> bytes;
+
+         /// If not 0, bytes holds physical pages and these are written whole instead
+         size_t pageCount = 0;
+         size_t pageIndex = 0;
+         uint64_t firstPage = 0;
+      };
+
+      void threadLoop();
+      void rethrowError();
+
+      ImageFileImplSharedPtr imf_;
+      size_t maxPending_;
+
+      std::mutex mutex_;
+      std::condition_variable blockQueued_;
+      std::condition_variable blockWritten_;
+
+      std::deque<Block> pending_;
+
+      /// Buffers of written blocks, kept to save allocating new ones
+      std::vector<std::vector<char>> spare_;
+      std::vector<std::vector<char>> sparePages_;
+
+      /// True while the thread is writing a block it has taken off pending_
+      bool writing_ = false;
+      bool stopping_ = false;
+
+      /// First failure, after which nothing more is written
+      std::exception_ptr error_;
+
+      std::thread thread_;
+   };
+}
@@ -26,7 +26,9 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 #include "WriterImpl.h"
 
@@ -71,6 +73,13 @@ namespace
                .append( std::to_string( static_cast<int>( inNodeType ) ) );
       }
    }
+
+   /// Raw value for a ScaledIntegerNode in a prototype. It isn't used, but has to be within the
+   /// bounds, so it is 0 if that is and the nearest bound if not.
+   int64_t _prototypeRawValue( int64_t minimum, int64_t maximum )
+   {
+      return std::min( std::max( static_cast<int64_t>( 0 ), minimum ), maximum );
+   }
 }
 
 namespace e57
@@ -125,8 +134,195 @@ namespace e57
       return transferred;
    }
 
+   /// Add an indexBounds structure to scan, with the pairs which aren't both 0
+   static void _setIndexBounds( ImageFile &imf, StructureNode &scan,
+                                const IndexBounds &indexBounds )
+   {
+      StructureNode ibox( imf );
+
+      if ( ( indexBounds.rowMinimum != 0 ) || ( indexBounds.rowMaximum != 0 ) )
+      {
+         ibox.set( "rowMinimum", IntegerNode( imf, indexBounds.rowMinimum ) );
+         ibox.set( "rowMaximum", IntegerNode( imf, indexBounds.rowMaximum ) );
+      }
+
+      if ( ( indexBounds.columnMinimum != 0 ) || ( indexBounds.columnMaximum != 0 ) )
+      {
+         ibox.set( "columnMinimum", IntegerNode( imf, indexBounds.columnMinimum ) );
+         ibox.set( "columnMaximum", IntegerNode( imf, indexBounds.columnMaximum ) );
+      }
+
+      if ( ( indexBounds.returnMinimum != 0 ) || ( indexBounds.returnMaximum != 0 ) )
+      {
+         ibox.set( "returnMinimum", IntegerNode( imf, indexBounds.returnMinimum ) );
+         ibox.set( "returnMaximum", IntegerNode( imf, indexBounds.returnMaximum ) );
+      }
+
+      scan.set( "indexBounds", ibox );
+   }
+
+   /// Add an intensityLimits structure to scan, using the same type as the intensity field
+   static void _setIntensityLimits( ImageFile &imf, StructureNode &scan,
+                                    const IntensityLimits &intensityLimits,
+                                    NumericalNodeType nodeType, double scale )
+   {
+      StructureNode intbox( imf );
+
+      const double intensityMin = intensityLimits.intensityMinimum;
+      const double intensityMax = intensityLimits.intensityMaximum;
+
+      switch ( nodeType )
+      {
+         case NumericalNodeType::Integer:
+         {
+            intbox.set( "intensityMinimum",
+                        IntegerNode( imf, static_cast<int64_t>( intensityMin ) ) );
+            intbox.set( "intensityMaximum",
+                        IntegerNode( imf, static_cast<int64_t>( intensityMax ) ) );
+
+            break;
+         }
+
+         case NumericalNodeType::ScaledInteger:
+         {
+            const double offset = 0.0;
+
+            const auto rawIntegerMinimum =
+               static_cast<int64_t>( std::floor( ( intensityMin - offset ) / scale + .5 ) );
+            const auto rawIntegerMaximum =
+               static_cast<int64_t>( std::floor( ( intensityMax - offset ) / scale + .5 ) );
+
+            intbox.set( "intensityMinimum",
+                        ScaledIntegerNode( imf, rawIntegerMinimum, rawIntegerMinimum,
+                                           rawIntegerMaximum, scale, offset ) );
+            intbox.set( "intensityMaximum",
+                        ScaledIntegerNode( imf, rawIntegerMaximum, rawIntegerMinimum,
+                                           rawIntegerMaximum, scale, offset ) );
+
+            break;
+         }
+
+         case NumericalNodeType::Float:
+         {
+            intbox.set( "intensityMinimum", FloatNode( imf, intensityMin, PrecisionSingle ) );
+            intbox.set( "intensityMaximum", FloatNode( imf, intensityMax, PrecisionSingle ) );
+
+            break;
+         }
+
+         case NumericalNodeType::Double:
+         {
+            intbox.set( "intensityMinimum", FloatNode( imf, intensityMin, PrecisionDouble ) );
+            intbox.set( "intensityMaximum", FloatNode( imf, intensityMax, PrecisionDouble ) );
+
+            break;
+         }
+      }
+
+      scan.set( "intensityLimits", intbox );
+   }
+
+   /// Add a colorLimits structure to scan
+   static void _setColorLimits( ImageFile &imf, StructureNode &scan,
+                                const ColorLimits &colorLimits )
+   {
+      StructureNode colorbox( imf );
+
+      colorbox.set( "colorRedMaximum",
+                    IntegerNode( imf, static_cast<int64_t>( colorLimits.colorRedMaximum ) ) );
+      colorbox.set( "colorRedMinimum",
+                    IntegerNode( imf, static_cast<int64_t>( colorLimits.colorRedMinimum ) ) );
+      colorbox.set( "colorGreenMaximum",
+                    IntegerNode( imf, static_cast<int64_t>( colorLimits.colorGreenMaximum ) ) );
+      colorbox.set( "colorGreenMinimum",
+                    IntegerNode( imf, static_cast<int64_t>( colorLimits.colorGreenMinimum ) ) );
+      colorbox.set( "colorBlueMaximum",
+                    IntegerNode( imf, static_cast<int64_t>( colorLimits.colorBlueMaximum ) ) );
+      colorbox.set( "colorBlueMinimum",
+                    IntegerNode( imf, static_cast<int64_t>( colorLimits.colorBlueMinimum ) ) );
+
+      scan.set( "colorLimits", colorbox );
+   }
+
+   /// Add a cartesianBounds structure to scan
+   static void _setCartesianBounds( ImageFile &imf, StructureNode &scan,
+                                    const CartesianBounds &cartesianBounds )
+   {
+      StructureNode bbox( imf );
+
+      bbox.set( "xMinimum", FloatNode( imf, cartesianBounds.xMinimum ) );
+      bbox.set( "xMaximum", FloatNode( imf, cartesianBounds.xMaximum ) );
+      bbox.set( "yMinimum", FloatNode( imf, cartesianBounds.yMinimum ) );
+      bbox.set( "yMaximum", FloatNode( imf, cartesianBounds.yMaximum ) );
+      bbox.set( "zMinimum", FloatNode( imf, cartesianBounds.zMinimum ) );
+      bbox.set( "zMaximum", FloatNode( imf, cartesianBounds.zMaximum ) );
+
+      scan.set( "cartesianBounds", bbox );
+   }
+
+   /// Add a sphericalBounds structure to scan
+   static void _setSphericalBounds( ImageFile &imf, StructureNode &scan,
+                                    const SphericalBounds &sphericalBounds )
+   {
+      StructureNode sbox( imf );
+
+      sbox.set( "rangeMinimum", FloatNode( imf, sphericalBounds.rangeMinimum ) );
+      sbox.set( "rangeMaximum", FloatNode( imf, sphericalBounds.rangeMaximum ) );
+      sbox.set( "elevationMinimum", FloatNode( imf, sphericalBounds.elevationMinimum ) );
+      sbox.set( "elevationMaximum", FloatNode( imf, sphericalBounds.elevationMaximum ) );
+      sbox.set( "azimuthStart", FloatNode( imf, sphericalBounds.azimuthStart ) );
+      sbox.set( "azimuthEnd", FloatNode( imf, sphericalBounds.azimuthEnd ) );
+
+      scan.set( "sphericalBounds", sbox );
+   }
+
+   /// Make a codecs vector which stores the slowly changing integer fields of proto with the
+   /// delta codec (see WriterOptions::deltaCodec)
+   static VectorNode _deltaCodecs( ImageFile &imf, const StructureNode &proto )
+   {
+      VectorNode codecs( imf, true );
+      VectorNode inputs( imf, false );
+
+      for ( const char *name : { "rowIndex", "columnIndex", "timeStamp", "sphericalAzimuth",
+                                 "sphericalElevation" } )
+      {
+         if ( !proto.isDefined( name ) )
+         {
+            continue;
+         }
+
+         const NodeType type = proto.get( name ).type();
+         if ( ( type == TypeInteger ) || ( type == TypeScaledInteger ) )
+         {
+            inputs.append( StringNode( imf, name ) );
+         }
+      }
+
+      if ( inputs.childCount() == 0 )
+      {
+         return codecs;
+      }
+
+      // make sure we declare the extension before using the codec with prefix
+      ustring prefix;
+      if ( !imf.extensionsLookupUri( DELTA_CODEC_URI, prefix ) )
+      {
+         prefix = "dlt";
+         imf.extensionsAdd( prefix, DELTA_CODEC_URI );
+      }
+
+      StructureNode codec( imf );
+      codec.set( "inputs", inputs );
+      codec.set( prefix + ":deltaCodec", StructureNode( imf ) );
+
+      codecs.append( codec );
+
+      return codecs;
+   }
+
    WriterImpl::WriterImpl( const ustring &filePath, const WriterOptions &options ) :
-      imf_( filePath, "w" ), root_( imf_.root() ), data3D_( imf_, true ), images2D_( imf_, true )
+      options_( options ), imf_( filePath, "w" ), root_( imf_.root() ), data3D_( imf_, true ),
+      images2D_( imf_, true ), pointsRanges_( std::make_shared<std::map<int64_t, FieldRanges>>() )
    {
       // We are using the E57 v1.0 data format standard field names.
       // The standard field names are used without an extension prefix (in the default namespace).
@@ -193,6 +389,13 @@ namespace e57
          return false;
       }
 
+      for ( const auto &pointsRanges : *pointsRanges_ )
+      {
+         fillBoundsFromData( pointsRanges.first, pointsRanges.second );
+      }
+
+      pointsRanges_->clear();
+
       imf_.close();
       return true;
    }
@@ -473,7 +676,7 @@ namespace e57
       return 0;
    }
 
-   int64_t WriterImpl::NewData3D( Data3D &data3DHeader )
+   int64_t WriterImpl::NewData3D( Data3D &data3DHeader, const ConstantFields &constantFields )
    {
       StructureNode scan( imf_ );
       data3D_.append( scan );
@@ -563,121 +766,21 @@ namespace e57
 
       if ( data3DHeader.indexBounds != IndexBounds{} )
       {
-         StructureNode ibox( imf_ );
-
-         if ( ( data3DHeader.indexBounds.rowMinimum != 0 ) ||
-              ( data3DHeader.indexBounds.rowMaximum != 0 ) )
-         {
-            ibox.set( "rowMinimum", IntegerNode( imf_, data3DHeader.indexBounds.rowMinimum ) );
-            ibox.set( "rowMaximum", IntegerNode( imf_, data3DHeader.indexBounds.rowMaximum ) );
-         }
-
-         if ( ( data3DHeader.indexBounds.columnMinimum != 0 ) ||
-              ( data3DHeader.indexBounds.columnMaximum != 0 ) )
-         {
-            ibox.set( "columnMinimum",
-                      IntegerNode( imf_, data3DHeader.indexBounds.columnMinimum ) );
-            ibox.set( "columnMaximum",
-                      IntegerNode( imf_, data3DHeader.indexBounds.columnMaximum ) );
-         }
-
-         if ( ( data3DHeader.indexBounds.returnMinimum != 0 ) ||
-              ( data3DHeader.indexBounds.returnMaximum != 0 ) )
-         {
-            ibox.set( "returnMinimum",
-                      IntegerNode( imf_, data3DHeader.indexBounds.returnMinimum ) );
-            ibox.set( "returnMaximum",
-                      IntegerNode( imf_, data3DHeader.indexBounds.returnMaximum ) );
-         }
-
-         scan.set( "indexBounds", ibox );
+         _setIndexBounds( imf_, scan, data3DHeader.indexBounds );
       }
 
       if ( ( data3DHeader.intensityLimits.intensityMaximum != 0.0 ) ||
            ( data3DHeader.intensityLimits.intensityMinimum != 0.0 ) )
       {
-         StructureNode intbox( imf_ );
-
-         const double intensityMin = data3DHeader.intensityLimits.intensityMinimum;
-         const double intensityMax = data3DHeader.intensityLimits.intensityMaximum;
-
-         switch ( data3DHeader.pointFields.intensityNodeType )
-         {
-            case NumericalNodeType::Integer:
-            {
-               intbox.set( "intensityMinimum",
-                           IntegerNode( imf_, static_cast<int64_t>( intensityMin ) ) );
-               intbox.set( "intensityMaximum",
-                           IntegerNode( imf_, static_cast<int64_t>( intensityMax ) ) );
-
-               break;
-            }
-
-            case NumericalNodeType::ScaledInteger:
-            {
-               const double scale = data3DHeader.pointFields.intensityScale;
-               const double offset = 0.0;
-
-               const auto rawIntegerMinimum =
-                  static_cast<int64_t>( std::floor( ( intensityMin - offset ) / scale + .5 ) );
-               const auto rawIntegerMaximum =
-                  static_cast<int64_t>( std::floor( ( intensityMax - offset ) / scale + .5 ) );
-
-               intbox.set( "intensityMinimum",
-                           ScaledIntegerNode( imf_, rawIntegerMinimum, rawIntegerMinimum,
-                                              rawIntegerMaximum, scale, offset ) );
-               intbox.set( "intensityMaximum",
-                           ScaledIntegerNode( imf_, rawIntegerMaximum, rawIntegerMinimum,
-                                              rawIntegerMaximum, scale, offset ) );
-
-               break;
-            }
-
-            case NumericalNodeType::Float:
-            {
-               intbox.set( "intensityMinimum", FloatNode( imf_, intensityMin, PrecisionSingle ) );
-               intbox.set( "intensityMaximum", FloatNode( imf_, intensityMax, PrecisionSingle ) );
-
-               break;
-            }
-
-            case NumericalNodeType::Double:
-            {
-               intbox.set( "intensityMinimum", FloatNode( imf_, intensityMin, PrecisionDouble ) );
-               intbox.set( "intensityMaximum", FloatNode( imf_, intensityMax, PrecisionDouble ) );
-
-               break;
-            }
-         }
-
-         scan.set( "intensityLimits", intbox );
+         _setIntensityLimits( imf_, scan, data3DHeader.intensityLimits,
+                              data3DHeader.pointFields.intensityNodeType,
+                              data3DHeader.pointFields.intensityScale );
       }
 
       if ( ( data3DHeader.colorLimits.colorRedMaximum != 0.0 ) ||
            ( data3DHeader.colorLimits.colorRedMinimum != 0.0 ) )
       {
-         StructureNode colorbox( imf_ );
-
-         colorbox.set(
-            "colorRedMaximum",
-            IntegerNode( imf_, static_cast<int64_t>( data3DHeader.colorLimits.colorRedMaximum ) ) );
-         colorbox.set(
-            "colorRedMinimum",
-            IntegerNode( imf_, static_cast<int64_t>( data3DHeader.colorLimits.colorRedMinimum ) ) );
-         colorbox.set( "colorGreenMaximum",
-                       IntegerNode( imf_, static_cast<int64_t>(
-                                             data3DHeader.colorLimits.colorGreenMaximum ) ) );
-         colorbox.set( "colorGreenMinimum",
-                       IntegerNode( imf_, static_cast<int64_t>(
-                                             data3DHeader.colorLimits.colorGreenMinimum ) ) );
-         colorbox.set( "colorBlueMaximum",
-                       IntegerNode( imf_, static_cast<int64_t>(
-                                             data3DHeader.colorLimits.colorBlueMaximum ) ) );
-         colorbox.set( "colorBlueMinimum",
-                       IntegerNode( imf_, static_cast<int64_t>(
-                                             data3DHeader.colorLimits.colorBlueMinimum ) ) );
-
-         scan.set( "colorLimits", colorbox );
+         _setColorLimits( imf_, scan, data3DHeader.colorLimits );
       }
 
       // Add Cartesian bounding box to scan.
@@ -685,33 +788,13 @@ namespace e57
       if ( ( data3DHeader.cartesianBounds.xMinimum != -DOUBLE_MAX ) ||
            ( data3DHeader.cartesianBounds.xMaximum != DOUBLE_MAX ) )
       {
-         StructureNode bbox( imf_ );
-
-         bbox.set( "xMinimum", FloatNode( imf_, data3DHeader.cartesianBounds.xMinimum ) );
-         bbox.set( "xMaximum", FloatNode( imf_, data3DHeader.cartesianBounds.xMaximum ) );
-         bbox.set( "yMinimum", FloatNode( imf_, data3DHeader.cartesianBounds.yMinimum ) );
-         bbox.set( "yMaximum", FloatNode( imf_, data3DHeader.cartesianBounds.yMaximum ) );
-         bbox.set( "zMinimum", FloatNode( imf_, data3DHeader.cartesianBounds.zMinimum ) );
-         bbox.set( "zMaximum", FloatNode( imf_, data3DHeader.cartesianBounds.zMaximum ) );
-
-         scan.set( "cartesianBounds", bbox );
+         _setCartesianBounds( imf_, scan, data3DHeader.cartesianBounds );
       }
 
       if ( ( data3DHeader.sphericalBounds.rangeMinimum != 0.0 ) ||
            ( data3DHeader.sphericalBounds.rangeMaximum != DOUBLE_MAX ) )
       {
-         StructureNode sbox( imf_ );
-
-         sbox.set( "rangeMinimum", FloatNode( imf_, data3DHeader.sphericalBounds.rangeMinimum ) );
-         sbox.set( "rangeMaximum", FloatNode( imf_, data3DHeader.sphericalBounds.rangeMaximum ) );
-         sbox.set( "elevationMinimum",
-                   FloatNode( imf_, data3DHeader.sphericalBounds.elevationMinimum ) );
-         sbox.set( "elevationMaximum",
-                   FloatNode( imf_, data3DHeader.sphericalBounds.elevationMaximum ) );
-         sbox.set( "azimuthStart", FloatNode( imf_, data3DHeader.sphericalBounds.azimuthStart ) );
-         sbox.set( "azimuthEnd", FloatNode( imf_, data3DHeader.sphericalBounds.azimuthEnd ) );
-
-         scan.set( "sphericalBounds", sbox );
+         _setSphericalBounds( imf_, scan, data3DHeader.sphericalBounds );
       }
 
       // Create pose structure for scan.
@@ -856,8 +939,9 @@ namespace e57
                const auto pointRangeMaximum = static_cast<int64_t>(
                   std::floor( ( pointRangeMax - pointRangeOffset ) / pointRangeScale + .5 ) );
 
-               return ScaledIntegerNode( imf_, 0, pointRangeMinimum, pointRangeMaximum,
-                                         pointRangeScale, pointRangeOffset );
+               return ScaledIntegerNode(
+                  imf_, _prototypeRawValue( pointRangeMinimum, pointRangeMaximum ),
+                  pointRangeMinimum, pointRangeMaximum, pointRangeScale, pointRangeOffset );
             }
 
             case NumericalNodeType::Float:
@@ -923,8 +1007,8 @@ namespace e57
                const auto angleMaximum = static_cast<int64_t>(
                   std::floor( ( angleMax - angleOffset ) / angleScale + .5 ) );
 
-               return ScaledIntegerNode( imf_, 0, angleMinimum, angleMaximum, angleScale,
-                                         angleOffset );
+               return ScaledIntegerNode( imf_, _prototypeRawValue( angleMinimum, angleMaximum ),
+                                         angleMinimum, angleMaximum, angleScale, angleOffset );
             }
 
             case NumericalNodeType::Float:
@@ -979,8 +1063,11 @@ namespace e57
                const auto rawIntegerMinimum =
                   static_cast<int64_t>( std::floor( ( intensityMin - offset ) / scale + .5 ) );
 
-               proto.set( "intensity", ScaledIntegerNode( imf_, 0, rawIntegerMinimum,
-                                                          rawIntegerMaximum, scale, offset ) );
+               proto.set( "intensity", ScaledIntegerNode( imf_,
+                                                          _prototypeRawValue( rawIntegerMinimum,
+                                                                              rawIntegerMaximum ),
+                                                          rawIntegerMinimum, rawIntegerMaximum,
+                                                          scale, offset ) );
 
                break;
             }
@@ -1005,48 +1092,75 @@ namespace e57
          }
       }
 
+      // If the limits come from the data later, the fields have to take any value that fits
+      ColorLimits colorLimits = data3DHeader.colorLimits;
+
+      if ( options_.collectStatistics && ( colorLimits == ColorLimits{} ) )
+      {
+         constexpr auto cColorMax = static_cast<double>( std::numeric_limits<uint16_t>::max() );
+
+         colorLimits.colorRedMaximum = cColorMax;
+         colorLimits.colorGreenMaximum = cColorMax;
+         colorLimits.colorBlueMaximum = cColorMax;
+      }
+
+      // A field known to hold one value is declared with that as its bounds, which takes no bits
+      // per point. If the value is outside the declared bounds, writing it reports the error.
+      const auto getIntegerProto = [&]( const char *name, int64_t minimum,
+                                        int64_t maximum ) -> Node {
+         const auto constant = constantFields.find( name );
+
+         if ( ( constant != constantFields.end() ) && ( minimum <= constant->second ) &&
+              ( constant->second <= maximum ) )
+         {
+            return IntegerNode( imf_, constant->second, constant->second, constant->second );
+         }
+
+         return IntegerNode( imf_, 0, minimum, maximum );
+      };
+
       if ( data3DHeader.pointFields.colorRedField )
       {
-         proto.set(
-            "colorRed",
-            IntegerNode( imf_, 0, static_cast<int64_t>( data3DHeader.colorLimits.colorRedMinimum ),
-                         static_cast<int64_t>( data3DHeader.colorLimits.colorRedMaximum ) ) );
+         proto.set( "colorRed",
+                    getIntegerProto( "colorRed",
+                                     static_cast<int64_t>( colorLimits.colorRedMinimum ),
+                                     static_cast<int64_t>( colorLimits.colorRedMaximum ) ) );
       }
       if ( data3DHeader.pointFields.colorGreenField )
       {
          proto.set( "colorGreen",
-                    IntegerNode(
-                       imf_, 0, static_cast<int64_t>( data3DHeader.colorLimits.colorGreenMinimum ),
-                       static_cast<int64_t>( data3DHeader.colorLimits.colorGreenMaximum ) ) );
+                    getIntegerProto( "colorGreen",
+                                     static_cast<int64_t>( colorLimits.colorGreenMinimum ),
+                                     static_cast<int64_t>( colorLimits.colorGreenMaximum ) ) );
       }
       if ( data3DHeader.pointFields.colorBlueField )
       {
-         proto.set(
-            "colorBlue",
-            IntegerNode( imf_, 0, static_cast<int64_t>( data3DHeader.colorLimits.colorBlueMinimum ),
-                         static_cast<int64_t>( data3DHeader.colorLimits.colorBlueMaximum ) ) );
+         proto.set( "colorBlue",
+                    getIntegerProto( "colorBlue",
+                                     static_cast<int64_t>( colorLimits.colorBlueMinimum ),
+                                     static_cast<int64_t>( colorLimits.colorBlueMaximum ) ) );
       }
 
       if ( data3DHeader.pointFields.returnIndexField )
       {
-         proto.set( "returnIndex",
-                    IntegerNode( imf_, 0, UINT8_MIN, data3DHeader.pointFields.returnMaximum ) );
+         proto.set( "returnIndex", getIntegerProto( "returnIndex", UINT8_MIN,
+                                                    data3DHeader.pointFields.returnMaximum ) );
       }
       if ( data3DHeader.pointFields.returnCountField )
       {
-         proto.set( "returnCount",
-                    IntegerNode( imf_, 0, UINT8_MIN, data3DHeader.pointFields.returnMaximum ) );
+         proto.set( "returnCount", getIntegerProto( "returnCount", UINT8_MIN,
+                                                    data3DHeader.pointFields.returnMaximum ) );
       }
 
       if ( data3DHeader.pointFields.rowIndexField )
       {
-         proto.set( "rowIndex",
-                    IntegerNode( imf_, 0, UINT32_MIN, data3DHeader.pointFields.rowIndexMaximum ) );
+         proto.set( "rowIndex", getIntegerProto( "rowIndex", UINT32_MIN,
+                                                 data3DHeader.pointFields.rowIndexMaximum ) );
       }
       if ( data3DHeader.pointFields.columnIndexField )
       {
-         proto.set( "columnIndex", IntegerNode( imf_, 0, UINT32_MIN,
-                                                data3DHeader.pointFields.columnIndexMaximum ) );
+         proto.set( "columnIndex", getIntegerProto( "columnIndex", UINT32_MIN,
+                                                    data3DHeader.pointFields.columnIndexMaximum ) );
       }
 
       if ( data3DHeader.pointFields.timeStampField )
@@ -1073,8 +1187,11 @@ namespace e57
                const auto rawIntegerMaximum =
                   static_cast<int64_t>( std::floor( ( timeMaximum - offset ) / scale + .5 ) );
 
-               proto.set( "timeStamp", ScaledIntegerNode( imf_, 0, rawIntegerMinimum,
-                                                          rawIntegerMaximum, scale, offset ) );
+               proto.set( "timeStamp", ScaledIntegerNode( imf_,
+                                                          _prototypeRawValue( rawIntegerMinimum,
+                                                                              rawIntegerMaximum ),
+                                                          rawIntegerMinimum, rawIntegerMaximum,
+                                                          scale, offset ) );
                break;
             }
 
@@ -1096,23 +1213,23 @@ namespace e57
 
       if ( data3DHeader.pointFields.cartesianInvalidStateField )
       {
-         proto.set( "cartesianInvalidState", IntegerNode( imf_, 0, 0, 2 ) );
+         proto.set( "cartesianInvalidState", getIntegerProto( "cartesianInvalidState", 0, 2 ) );
       }
       if ( data3DHeader.pointFields.sphericalInvalidStateField )
       {
-         proto.set( "sphericalInvalidState", IntegerNode( imf_, 0, 0, 2 ) );
+         proto.set( "sphericalInvalidState", getIntegerProto( "sphericalInvalidState", 0, 2 ) );
       }
       if ( data3DHeader.pointFields.isIntensityInvalidField )
       {
-         proto.set( "isIntensityInvalid", IntegerNode( imf_, 0, 0, 1 ) );
+         proto.set( "isIntensityInvalid", getIntegerProto( "isIntensityInvalid", 0, 1 ) );
       }
       if ( data3DHeader.pointFields.isColorInvalidField )
       {
-         proto.set( "isColorInvalid", IntegerNode( imf_, 0, 0, 1 ) );
+         proto.set( "isColorInvalid", getIntegerProto( "isColorInvalid", 0, 1 ) );
       }
       if ( data3DHeader.pointFields.isTimeStampInvalidField )
       {
-         proto.set( "isTimeStampInvalid", IntegerNode( imf_, 0, 0, 1 ) );
+         proto.set( "isTimeStampInvalid", getIntegerProto( "isTimeStampInvalid", 0, 1 ) );
       }
 
       // E57_EXT_surface_normals
@@ -1141,12 +1258,13 @@ namespace e57
          proto.set( "nor:normalZ", FloatNode( imf_, 0.0, PrecisionSingle, -1.0, 1.0 ) );
       }
 
-      // Make empty codecs vector for use in creating points CompressedVector.
+      // Make codecs vector for use in creating points CompressedVector.
       // If this vector is empty, it is assumed that all fields will use the BitPack codec.
-      const VectorNode codecs( imf_, true );
+      const VectorNode codecs =
+         options_.deltaCodec ? _deltaCodecs( imf_, proto ) : VectorNode( imf_, true );
 
       // Create CompressedVector for storing points.  Path Name: "/data3D/0/points".
-      // We use the prototype and empty codecs tree from above.
+      // We use the prototype and codecs tree from above.
       // The CompressedVector will be filled by code below.
       const CompressedVectorNode points( imf_, proto, codecs );
 
@@ -1295,7 +1413,34 @@ namespace e57
       }
 
       // create the writer, all buffers must be setup before this call
-      CompressedVectorWriter writer = points.writer( sourceBuffers );
+      CompressedVectorWriterOptions writerOptions;
+      writerOptions.collectStatistics = options_.collectStatistics;
+
+      // Keep the ranges when the writer is closed, for filling in the bounds when the file is
+      if ( options_.collectStatistics )
+      {
+         std::shared_ptr<std::map<int64_t, FieldRanges>> pointsRanges = pointsRanges_;
+
+         writerOptions.fieldRangeSink = [pointsRanges, dataIndex]( const ustring &pathName,
+                                                                   double minimum,
+                                                                   double maximum ) {
+            FieldRanges &ranges = ( *pointsRanges )[dataIndex];
+
+            const auto found = ranges.find( pathName );
+
+            if ( found == ranges.end() )
+            {
+               ranges.emplace( pathName, std::make_pair( minimum, maximum ) );
+            }
+            else
+            {
+               found->second.first = std::min( found->second.first, minimum );
+               found->second.second = std::max( found->second.second, maximum );
+            }
+         };
+      }
+
+      CompressedVectorWriter writer = points.writer( sourceBuffers, writerOptions );
 
       return writer;
    }
@@ -1307,6 +1452,99 @@ namespace e57
    template CompressedVectorWriter WriterImpl::SetUpData3DPointsData(
       int64_t dataIndex, size_t pointCount, const Data3DPointsData_t<double> &buffers );
 
+   // Fill in the bounds the Data3D header left out from the values the writer has seen
+   void WriterImpl::fillBoundsFromData( int64_t dataIndex, const FieldRanges &ranges )
+   {
+      StructureNode scan( data3D_.get( dataIndex ) );
+      const CompressedVectorNode points( scan.get( "points" ) );
+      const StructureNode proto( points.prototype() );
+
+      const auto fieldRange = [&]( const char *pathName, double &minimum, double &maximum ) {
+         const auto found = ranges.find( pathName );
+         if ( found == ranges.end() )
+         {
+            return false;
+         }
+
+         minimum = found->second.first;
+         maximum = found->second.second;
+         return true;
+      };
+
+      // Integer version, for the index bounds
+      const auto fieldRangeInt = [&]( const char *pathName, int64_t &minimum, int64_t &maximum ) {
+         double low = 0.0;
+         double high = 0.0;
+         if ( !fieldRange( pathName, low, high ) )
+         {
+            return false;
+         }
+
+         minimum = static_cast<int64_t>( low );
+         maximum = static_cast<int64_t>( high );
+         return true;
+      };
+
+      CartesianBounds cartesianBounds;
+      if ( !scan.isDefined( "cartesianBounds" ) &&
+           fieldRange( "cartesianX", cartesianBounds.xMinimum, cartesianBounds.xMaximum ) &&
+           fieldRange( "cartesianY", cartesianBounds.yMinimum, cartesianBounds.yMaximum ) &&
+           fieldRange( "cartesianZ", cartesianBounds.zMinimum, cartesianBounds.zMaximum ) )
+      {
+         _setCartesianBounds( imf_, scan, cartesianBounds );
+      }
+
+      // The azimuth range is the smallest and largest azimuth, which is only the start and end
+      // of the scan if it doesn't wrap around
+      SphericalBounds sphericalBounds;
+      if ( !scan.isDefined( "sphericalBounds" ) &&
+           fieldRange( "sphericalRange", sphericalBounds.rangeMinimum,
+                       sphericalBounds.rangeMaximum ) &&
+           fieldRange( "sphericalElevation", sphericalBounds.elevationMinimum,
+                       sphericalBounds.elevationMaximum ) &&
+           fieldRange( "sphericalAzimuth", sphericalBounds.azimuthStart,
+                       sphericalBounds.azimuthEnd ) )
+      {
+         _setSphericalBounds( imf_, scan, sphericalBounds );
+      }
+
+      IndexBounds indexBounds;
+      fieldRangeInt( "rowIndex", indexBounds.rowMinimum, indexBounds.rowMaximum );
+      fieldRangeInt( "columnIndex", indexBounds.columnMinimum, indexBounds.columnMaximum );
+      fieldRangeInt( "returnIndex", indexBounds.returnMinimum, indexBounds.returnMaximum );
+
+      if ( !scan.isDefined( "indexBounds" ) && ( indexBounds != IndexBounds{} ) )
+      {
+         _setIndexBounds( imf_, scan, indexBounds );
+      }
+
+      // Integer intensity is bounded by the limits given up front, so only floating point
+      // intensity is filled in
+      IntensityLimits intensityLimits;
+      if ( !scan.isDefined( "intensityLimits" ) && proto.isDefined( "intensity" ) &&
+           ( proto.get( "intensity" ).type() == TypeFloat ) &&
+           fieldRange( "intensity", intensityLimits.intensityMinimum,
+                       intensityLimits.intensityMaximum ) )
+      {
+         const FloatNode intensity( proto.get( "intensity" ) );
+         const auto nodeType = ( intensity.precision() == PrecisionSingle )
+                                  ? NumericalNodeType::Float
+                                  : NumericalNodeType::Double;
+
+         _setIntensityLimits( imf_, scan, intensityLimits, nodeType, 1.0 );
+      }
+
+      ColorLimits colorLimits;
+      if ( !scan.isDefined( "colorLimits" ) &&
+           fieldRange( "colorRed", colorLimits.colorRedMinimum, colorLimits.colorRedMaximum ) &&
+           fieldRange( "colorGreen", colorLimits.colorGreenMinimum,
+                       colorLimits.colorGreenMaximum ) &&
+           fieldRange( "colorBlue", colorLimits.colorBlueMinimum, colorLimits.colorBlueMaximum ) )
+      {
+         _setColorLimits( imf_, scan, colorLimits );
+      }
+   }
+
    // This function writes out the group data
    bool WriterImpl::WriteData3DGroupsData( int64_t dataIndex, size_t groupCount,
                                            int64_t *idElementValue, int64_t *startPointIndex,
@@ -28,6 +28,8 @@
 
 #pragma once
 
+#include <map>
+
 #include "E57SimpleData.h"
 #include "E57SimpleWriter.h"
 
@@ -55,7 +57,12 @@ namespace e57
                                Image2DProjection imageProjection, uint8_t *pBuffer, int64_t start,
                                size_t count );
 
-      int64_t NewData3D( Data3D &data3DHeader );
+      /// Integer point fields which hold the same value for every point, by prototype name
+      using ConstantFields = std::map<ustring, int64_t>;
+
+      /// Fields in constantFields are declared with that value as their minimum and maximum, so
+      /// they are written without storing any bits
+      int64_t NewData3D( Data3D &data3DHeader, const ConstantFields &constantFields = {} );
 
       template <typename COORDTYPE>
       CompressedVectorWriter SetUpData3DPointsData( int64_t dataIndex, size_t pointCount,
@@ -72,12 +79,29 @@ namespace e57
 
       ImageFile GetRawIMF();
 
+      const WriterOptions &Options() const
+      {
+         return options_;
+      }
+
    private:
+      /// Smallest and largest value written to each field of a scan's points, by path name
+      using FieldRanges = std::map<ustring, std::pair<double, double>>;
+
+      void fillBoundsFromData( int64_t dataIndex, const FieldRanges &ranges );
+
+      WriterOptions options_;
+
       ImageFile imf_;
       StructureNode root_;
 
       VectorNode data3D_;
 
       VectorNode images2D_;
+
+      /// Field ranges of each scan's points, by data3D index, to fill in its bounds from when the
+      /// file is closed (see WriterOptions::collectStatistics). The writers of the points add to
+      /// this as they are closed, which may be after this object is gone.
+      std::shared_ptr<std::map<int64_t, FieldRanges>> pointsRanges_;
    }; // end Writer class
 } // end namespace e57
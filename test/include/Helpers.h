@@ -2,6 +2,11 @@
 // libE57Format testing Copyright © 2022 Andy Maloney <asmaloney@gmail.com>
 // SPDX-License-Identifier: BSL-1.0
 
+#include <string>
+#include <vector>
+
+#include "E57Format.h"
+
 // GoogleTest's ASSERT_NO_THROW() doesn't let us show any info about the exceptions.
 // This wrapper macro will output the e57::E57Exception context on failure.
 // The static_assert is simply there to require a semicolon after the macro so it matches the
@@ -26,3 +31,11 @@
 
 #define VALIDATE_BASIC ( E57_VALIDATION_LEVEL > VALIDATION_OFF )
 #define VALIDATE_DEEP ( E57_VALIDATION_LEVEL > VALIDATION_BASIC )
+
+// Write inNumRecords records to inFileName with the Foundation API using inOptions, then read them
+// back and check them. The records have double, float, scaled integer, integer, and string
+// fields, with some long strings, so every kind of encoder is used. They are written
+// inWriteSize records at a time (all at once if 0). Returns the contents of the file.
+std::vector<char> RoundTripRecords( const std::string &inFileName,
+                                    const e57::CompressedVectorWriterOptions &inOptions,
+                                    size_t inNumRecords, size_t inWriteSize = 0 );
@@ -0,0 +1,146 @@
+// libE57Format testing Copyright © 2022 Andy Maloney <asmaloney@gmail.com>
+// SPDX-License-Identifier: BSL-1.0
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+#include "gtest/gtest.h"
+
+#include "Helpers.h"
+
+namespace
+{
+   double xValue( size_t i )
+   {
+      return i * 0.25;
+   }
+
+   double yValue( size_t i )
+   {
+      return ( i % 1000 ) * 0.5;
+   }
+
+   int64_t zRawValue( size_t i )
+   {
+      return static_cast<int64_t>( i % 200001 ) - 100000;
+   }
+
+   int32_t intensityValue( size_t i )
+   {
+      return static_cast<int32_t>( ( i * 7 ) % 4096 );
+   }
+
+   // Some long labels, so data packets take only part of the label encoder's output
+   e57::ustring labelValue( size_t i )
+   {
+      if ( i % 500 == 0 )
+      {
+         return std::string( 3000 + i % 100, static_cast<char>( 'a' + i % 26 ) );
+      }
+
+      return "point " + std::to_string( i % 77 );
+   }
+}
+
+std::vector<char> RoundTripRecords( const std::string &inFileName,
+                                    const e57::CompressedVectorWriterOptions &inOptions,
+                                    size_t inNumRecords, size_t inWriteSize )
+{
+   const size_t writeSize = ( inWriteSize == 0 ) ? inNumRecords : inWriteSize;
+
+   {
+      e57::ImageFile imf( inFileName, "w" );
+
+      // Something before the section, so it doesn't start on a page or a multiple of 4
+      uint8_t blobBytes[3] = { 1, 2, 3 };
+      e57::BlobNode blob( imf, sizeof( blobBytes ) );
+      imf.root().set( "blob", blob );
+      blob.write( blobBytes, 0, sizeof( blobBytes ) );
+
+      e57::StructureNode proto( imf );
+      proto.set( "cartesianX", e57::FloatNode( imf, 0., e57::PrecisionDouble ) );
+      proto.set( "cartesianY", e57::FloatNode( imf, 0., e57::PrecisionSingle ) );
+      proto.set( "cartesianZ", e57::ScaledIntegerNode( imf, 0, -100000, 100000, 0.001, 0. ) );
+      proto.set( "intensity", e57::IntegerNode( imf, 0, 0, 4095 ) );
+      proto.set( "label", e57::StringNode( imf ) );
+
+      e57::CompressedVectorNode points( imf, proto, e57::VectorNode( imf, true ) );
+      imf.root().set( "points", points );
+
+      std::vector<double> x( writeSize );
+      std::vector<double> y( writeSize );
+      std::vector<int64_t> z( writeSize );
+      std::vector<int32_t> intensity( writeSize );
+      std::vector<e57::ustring> labels( writeSize );
+
+      std::vector<e57::SourceDestBuffer> sbufs;
+      sbufs.emplace_back( imf, "cartesianX", x.data(), writeSize, true );
+      sbufs.emplace_back( imf, "cartesianY", y.data(), writeSize, true );
+      sbufs.emplace_back( imf, "cartesianZ", z.data(), writeSize );
+      sbufs.emplace_back( imf, "intensity", intensity.data(), writeSize, true );
+      sbufs.emplace_back( imf, "label", &labels );
+
+      e57::CompressedVectorWriter writer = points.writer( sbufs, inOptions );
+
+      for ( size_t start = 0; start < inNumRecords; start += writeSize )
+      {
+         const size_t count = std::min( writeSize, inNumRecords - start );
+
+         for ( size_t i = 0; i < count; ++i )
+         {
+            x[i] = xValue( start + i );
+            y[i] = yValue( start + i );
+            z[i] = zRawValue( start + i );
+            intensity[i] = intensityValue( start + i );
+            labels[i] = labelValue( start + i );
+         }
+
+         writer.write( count );
+      }
+
+      writer.close();
+
+      imf.close();
+   }
+
+   {
+      e57::ImageFile imf( inFileName, "r" );
+      e57::CompressedVectorNode points( imf.root().get( "points" ) );
+
+      EXPECT_EQ( points.childCount(), static_cast<int64_t>( inNumRecords ) );
+
+      std::vector<double> x( inNumRecords );
+      std::vector<double> y( inNumRecords );
+      std::vector<int64_t> z( inNumRecords );
+      std::vector<int32_t> intensity( inNumRecords );
+      std::vector<e57::ustring> labels( inNumRecords );
+
+      std::vector<e57::SourceDestBuffer> dbufs;
+      dbufs.emplace_back( imf, "cartesianX", x.data(), inNumRecords, true );
+      dbufs.emplace_back( imf, "cartesianY", y.data(), inNumRecords, true );
+      dbufs.emplace_back( imf, "cartesianZ", z.data(), inNumRecords );
+      dbufs.emplace_back( imf, "intensity", intensity.data(), inNumRecords, true );
+      dbufs.emplace_back( imf, "label", &labels );
+
+      e57::CompressedVectorReader reader = points.reader( dbufs );
+      EXPECT_EQ( reader.read(), inNumRecords );
+      reader.close();
+
+      for ( size_t i = 0; i < inNumRecords; ++i )
+      {
+         if ( ( x[i] != xValue( i ) ) || ( y[i] != yValue( i ) ) || ( z[i] != zRawValue( i ) ) ||
+              ( intensity[i] != intensityValue( i ) ) || ( labels[i] != labelValue( i ) ) )
+         {
+            ADD_FAILURE() << inFileName << ": record " << i << " doesn't match";
+            break;
+         }
+      }
+
+      imf.close();
+   }
+
+   std::ifstream file( inFileName, std::ifstream::binary );
+   return std::vector<char>( std::istreambuf_iterator<char>( file ),
+                             std::istreambuf_iterator<char>() );
+}
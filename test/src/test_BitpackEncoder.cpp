@@ -0,0 +1,224 @@
+// libE57Format testing Copyright © 2022 Andy Maloney <asmaloney@gmail.com>
+// SPDX-License-Identifier: BSL-1.0
+
+#include <limits>
+
+#include "gtest/gtest.h"
+
+#include "Encoder.h"
+
+namespace
+{
+   // Gives the tests access to the packing internals of BitpackIntegerEncoder
+   template <typename RegisterT>
+   class TestIntegerEncoder : public e57::BitpackIntegerEncoder<RegisterT>
+   {
+   public:
+      TestIntegerEncoder( e57::SourceDestBuffer &sbuf, unsigned outputMaxSize, int64_t minimum,
+                          int64_t maximum ) :
+         e57::BitpackIntegerEncoder<RegisterT>( false, 0, sbuf, outputMaxSize, minimum, maximum,
+                                                1.0, 0.0 )
+      {
+      }
+
+      using e57::BitpackIntegerEncoder<RegisterT>::packBatch;
+      using e57::BitpackIntegerEncoder<RegisterT>::register_;
+      using e57::BitpackIntegerEncoder<RegisterT>::registerBitsUsed_;
+   };
+
+   // Values (already offset by the minimum) and the bytes they pack to, worked out by hand.
+   // Bits go in least significant first, and only whole registers are output. The rest is left
+   // in the register.
+   struct KnownPacking
+   {
+      unsigned bitsPerRecord;
+      int64_t minimum;
+      int64_t maximum;
+      std::vector<uint64_t> values;
+      std::vector<uint8_t> bytes;
+      uint64_t registerValue;
+      unsigned registerBitsUsed;
+   };
+
+   const KnownPacking cPacking1Bit = {
+      1,
+      0,
+      1,
+      { 1, 0, 1, 1, 0, 0, 1, 0, 1, 1, 1, 1, 0, 0, 0, 0, 1, 1, 0 },
+      { 0x4D, 0x0F },
+      0x3,
+      3,
+   };
+
+   const KnownPacking cPacking7Bit = {
+      7,
+      0,
+      127,
+      { 0x7F, 0x01, 0x55, 0x2A, 0x00, 0x40, 0x3C, 0x0F, 0x71, 0x12, 0x66 },
+      { 0xFF, 0x40, 0x55, 0x05, 0x00, 0xF2, 0x1E, 0x71, 0x89 },
+      0x19,
+      5,
+   };
+
+   const KnownPacking cPacking13Bit = {
+      13,
+      0,
+      8191,
+      { 0x1FFF, 0x0001, 0x1234, 0x0ABC, 0x1000, 0x0777, 0x1555 },
+      { 0xFF, 0x3F, 0x00, 0xD0, 0x48, 0x5E, 0x05, 0x00, 0xEF, 0x4E },
+      0x555,
+      11,
+   };
+
+   const KnownPacking cPacking33Bit = {
+      33,
+      0,
+      ( int64_t{ 1 } << 33 ) - 1,
+      { 0x1FFFFFFFF, 0x000000001, 0x123456789, 0x0ABCDEF01, 0x100000000 },
+      { 0xFF, 0xFF, 0xFF, 0xFF, 0x03, 0x00, 0x00, 0x00, 0x24, 0x9E, 0x15, 0x8D, 0x0C, 0x78, 0x6F,
+        0x5E },
+      0x1000000005,
+      37,
+   };
+
+   const KnownPacking cPacking64Bit = {
+      64,
+      std::numeric_limits<int64_t>::min(),
+      std::numeric_limits<int64_t>::max(),
+      { 0x0123456789ABCDEF, 0xFFFFFFFFFFFFFFFF, 0, 0x8000000000000001 },
+      { 0xEF, 0xCD, 0xAB, 0x89, 0x67, 0x45, 0x23, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x80 },
+      0,
+      0,
+   };
+
+   // Pack the values with packBatch, in two calls split at splitAt, into a buffer which has
+   // exactly enough room. Check the bytes, that nothing after them was touched, and what is
+   // left in the register.
+   template <typename RegisterT>
+   void CheckPackBatch( const KnownPacking &inPacking, size_t inSplitAt )
+   {
+      constexpr uint8_t cGuard = 0xA5;
+      constexpr size_t cGuardSize = 16;
+
+      e57::ImageFile imf( "./BitpackEncoder.e57", "w" );
+
+      int64_t unused = 0;
+      e57::SourceDestBuffer sbuf( imf, "x", &unused, 1 );
+
+      TestIntegerEncoder<RegisterT> encoder( sbuf, 1024, inPacking.minimum, inPacking.maximum );
+
+      const size_t byteCount = inPacking.bytes.size();
+      std::vector<uint8_t> out( byteCount + cGuardSize, cGuard );
+      auto *outp = reinterpret_cast<char *>( out.data() );
+
+      size_t packed = encoder.packBatch( inPacking.values.data(), inSplitAt, outp );
+      packed += encoder.packBatch( &inPacking.values[inSplitAt],
+                                   inPacking.values.size() - inSplitAt, &outp[packed] );
+
+      ASSERT_EQ( packed, byteCount );
+
+      for ( size_t i = 0; i < byteCount; ++i )
+      {
+         EXPECT_EQ( out[i], inPacking.bytes[i] ) << "byte " << i;
+      }
+
+      for ( size_t i = byteCount; i < out.size(); ++i )
+      {
+         EXPECT_EQ( out[i], cGuard ) << "wrote past the end at byte " << i;
+      }
+
+      EXPECT_EQ( static_cast<uint64_t>( encoder.register_ ), inPacking.registerValue );
+      EXPECT_EQ( encoder.registerBitsUsed_, inPacking.registerBitsUsed );
+
+      imf.cancel();
+   }
+
+   // Encode the values, followed by some more, through processRecords with an output buffer
+   // which only has room for the known bytes. It should stop once the output is full and give
+   // back exactly the known bytes.
+   template <typename RegisterT> void CheckNearlyFullOutput( const KnownPacking &inPacking )
+   {
+      constexpr size_t cExtraRecords = 10;
+
+      e57::ImageFile imf( "./BitpackEncoder.e57", "w" );
+
+      // The source holds raw values, i.e. not offset by the minimum
+      std::vector<int64_t> source;
+      for ( uint64_t value : inPacking.values )
+      {
+         source.push_back(
+            static_cast<int64_t>( value + static_cast<uint64_t>( inPacking.minimum ) ) );
+      }
+      source.insert( source.end(), cExtraRecords, inPacking.maximum );
+
+      e57::SourceDestBuffer sbuf( imf, "x", source.data(), static_cast<unsigned>( source.size() ) );
+
+      const auto byteCount = static_cast<unsigned>( inPacking.bytes.size() );
+      TestIntegerEncoder<RegisterT> encoder( sbuf, byteCount, inPacking.minimum,
+                                             inPacking.maximum );
+
+      ASSERT_EQ( encoder.bitsPerRecord(), inPacking.bitsPerRecord );
+
+      // As many records as fit in the output, plus the register, without overflowing it
+      constexpr unsigned cRegisterBits = sizeof( RegisterT ) * 8;
+      const size_t expectedRecords = std::min<size_t>(
+         ( byteCount * 8 + cRegisterBits - 1 ) / inPacking.bitsPerRecord, source.size() );
+
+      EXPECT_EQ( encoder.processRecords( source.size() ), expectedRecords );
+      ASSERT_EQ( encoder.outputAvailable(), byteCount );
+
+      // No more room until the output has been read
+      EXPECT_EQ( encoder.processRecords( source.size() ), expectedRecords );
+
+      std::vector<uint8_t> out( byteCount );
+      encoder.outputRead( reinterpret_cast<char *>( out.data() ), byteCount );
+
+      for ( size_t i = 0; i < byteCount; ++i )
+      {
+         EXPECT_EQ( out[i], inPacking.bytes[i] ) << "byte " << i;
+      }
+
+      imf.cancel();
+   }
+}
+
+TEST( BitpackEncoder, PackBatchKnownBytes1Bit )
+{
+   CheckPackBatch<uint8_t>( cPacking1Bit, cPacking1Bit.values.size() );
+   CheckPackBatch<uint8_t>( cPacking1Bit, 3 );
+}
+
+TEST( BitpackEncoder, PackBatchKnownBytes7Bit )
+{
+   CheckPackBatch<uint8_t>( cPacking7Bit, cPacking7Bit.values.size() );
+   CheckPackBatch<uint8_t>( cPacking7Bit, 5 );
+}
+
+TEST( BitpackEncoder, PackBatchKnownBytes13Bit )
+{
+   CheckPackBatch<uint16_t>( cPacking13Bit, cPacking13Bit.values.size() );
+   CheckPackBatch<uint16_t>( cPacking13Bit, 2 );
+}
+
+TEST( BitpackEncoder, PackBatchKnownBytes33Bit )
+{
+   CheckPackBatch<uint64_t>( cPacking33Bit, cPacking33Bit.values.size() );
+   CheckPackBatch<uint64_t>( cPacking33Bit, 1 );
+}
+
+TEST( BitpackEncoder, PackBatchKnownBytes64Bit )
+{
+   CheckPackBatch<uint64_t>( cPacking64Bit, cPacking64Bit.values.size() );
+   CheckPackBatch<uint64_t>( cPacking64Bit, 3 );
+}
+
+TEST( BitpackEncoder, NearlyFullOutput )
+{
+   CheckNearlyFullOutput<uint8_t>( cPacking1Bit );
+   CheckNearlyFullOutput<uint8_t>( cPacking7Bit );
+   CheckNearlyFullOutput<uint16_t>( cPacking13Bit );
+   CheckNearlyFullOutput<uint64_t>( cPacking33Bit );
+   CheckNearlyFullOutput<uint64_t>( cPacking64Bit );
+}
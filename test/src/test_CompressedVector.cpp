@@ -0,0 +1,1323 @@
+// libE57Format testing Copyright © 2022 Andy Maloney <asmaloney@gmail.com>
+// SPDX-License-Identifier: BSL-1.0
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <limits>
+
+#include "gtest/gtest.h"
+
+#include "E57Format.h"
+
+#include "Helpers.h"
+
+namespace
+{
+   // Spread the bits of i over a 64-bit value (splitmix64), for field values without a pattern
+   uint64_t MixBits( uint64_t i )
+   {
+      uint64_t z = i + 0x9e3779b97f4a7c15ULL;
+      z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9ULL;
+      z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebULL;
+      return z ^ ( z >> 31 );
+   }
+
+   // Read all the records, expecting it to fail with inErrorCode
+   void ExpectReadError( e57::CompressedVectorReader &inReader, e57::ErrorCode inErrorCode )
+   {
+      try
+      {
+         while ( inReader.read() > 0 )
+         {
+         }
+
+         FAIL() << "Expected " << e57::Utilities::errorCodeToString( inErrorCode );
+      }
+      catch ( e57::E57Exception &err )
+      {
+         EXPECT_EQ( err.errorCode(), inErrorCode ) << err.context();
+      }
+   }
+
+   // A codecs vector which stores inFields with the codec inCodec from the extension inURI
+   e57::VectorNode FieldCodecs( e57::ImageFile &imf, const char *inURI, const e57::ustring &inCodec,
+                                const std::vector<e57::ustring> &inFields )
+   {
+      e57::ustring prefix;
+      if ( !imf.extensionsLookupUri( inURI, prefix ) )
+      {
+         prefix = "ext" + std::to_string( imf.extensionsCount() );
+         imf.extensionsAdd( prefix, inURI );
+      }
+
+      e57::VectorNode inputs( imf, false );
+      for ( const auto &field : inFields )
+      {
+         inputs.append( e57::StringNode( imf, field ) );
+      }
+
+      e57::StructureNode codec( imf );
+      codec.set( "inputs", inputs );
+      codec.set( prefix + ":" + inCodec, e57::StructureNode( imf ) );
+
+      e57::VectorNode codecs( imf, true );
+      codecs.append( codec );
+
+      return codecs;
+   }
+
+   // Each page of an E57 file is 1020 bytes of data followed by a 4-byte checksum
+   constexpr uint64_t cPhysicalPageSize = 1024;
+   constexpr uint64_t cLogicalPageSize = 1020;
+
+   uint64_t LogicalToPhysical( uint64_t inLogicalOffset )
+   {
+      return inLogicalOffset / cLogicalPageSize * cPhysicalPageSize +
+             inLogicalOffset % cLogicalPageSize;
+   }
+
+   uint64_t PhysicalToLogical( uint64_t inPhysicalOffset )
+   {
+      return inPhysicalOffset / cPhysicalPageSize * cLogicalPageSize +
+             inPhysicalOffset % cPhysicalPageSize;
+   }
+
+   // The bytes of an E57 file without the page checksums, so they are indexed by logical offset
+   std::vector<char> LogicalBytes( const std::vector<char> &inFileBytes )
+   {
+      std::vector<char> logical;
+      for ( size_t page = 0; page < inFileBytes.size(); page += cPhysicalPageSize )
+      {
+         const size_t length = std::min<size_t>( cLogicalPageSize, inFileBytes.size() - page );
+         logical.insert( logical.end(), &inFileBytes[page], &inFileBytes[page] + length );
+      }
+
+      return logical;
+   }
+
+   // Read a (little-endian) value at inLogicalOffset
+   template <typename T>
+   T ReadValue( const std::vector<char> &inLogicalBytes, uint64_t inLogicalOffset )
+   {
+      T value = 0;
+      if ( inLogicalOffset + sizeof( T ) > inLogicalBytes.size() )
+      {
+         ADD_FAILURE() << "reading past the end of the file at " << inLogicalOffset;
+         return value;
+      }
+
+      std::memcpy( &value, &inLogicalBytes[inLogicalOffset], sizeof( T ) );
+      return value;
+   }
+
+   // A packet in a CompressedVector binary section
+   struct SectionPacket
+   {
+      uint8_t packetType;
+      uint64_t logicalOffset;
+      uint64_t logicalLength;
+   };
+
+   // The header of the binary section of the "points" CompressedVector in inLogicalBytes, and
+   // the packets which follow it, walked from the first data packet to the end of the section
+   struct PointsSection
+   {
+      uint64_t dataPhysicalOffset = 0;
+      uint64_t indexPhysicalOffset = 0;
+      std::vector<SectionPacket> packets;
+   };
+
+   PointsSection ReadPointsSection( const std::vector<char> &inLogicalBytes )
+   {
+      constexpr uint8_t cDataPacket = 1;
+
+      PointsSection section;
+
+      // The section's physical offset is only recorded in the XML
+      const std::string cElementStart = "<points type=\"CompressedVector\" fileOffset=\"";
+      const std::string text( inLogicalBytes.begin(), inLogicalBytes.end() );
+      const size_t elementPos = text.find( cElementStart );
+      if ( elementPos == std::string::npos )
+      {
+         ADD_FAILURE() << "no points CompressedVector in the XML";
+         return section;
+      }
+
+      const uint64_t sectionStart =
+         PhysicalToLogical( std::stoull( text.substr( elementPos + cElementStart.size(), 20 ) ) );
+
+      // sectionId, reserved, sectionLogicalLength, dataPhysicalOffset, indexPhysicalOffset
+      EXPECT_EQ( ReadValue<uint8_t>( inLogicalBytes, sectionStart ), 1 );
+      const uint64_t sectionEnd =
+         sectionStart + ReadValue<uint64_t>( inLogicalBytes, sectionStart + 8 );
+      section.dataPhysicalOffset = ReadValue<uint64_t>( inLogicalBytes, sectionStart + 16 );
+      section.indexPhysicalOffset = ReadValue<uint64_t>( inLogicalBytes, sectionStart + 24 );
+
+      // Every packet starts with its type and, at byte 2, its length less one
+      uint64_t offset = PhysicalToLogical( section.dataPhysicalOffset );
+      while ( offset < sectionEnd )
+      {
+         SectionPacket packet{};
+         packet.packetType = ReadValue<uint8_t>( inLogicalBytes, offset );
+         packet.logicalOffset = offset;
+         packet.logicalLength = ReadValue<uint16_t>( inLogicalBytes, offset + 2 ) + 1u;
+
+         section.packets.push_back( packet );
+         offset += packet.logicalLength;
+      }
+
+      EXPECT_EQ( offset, sectionEnd ) << "packets overrun the section";
+
+      if ( !section.packets.empty() )
+      {
+         EXPECT_EQ( section.packets.front().packetType, cDataPacket );
+      }
+
+      return section;
+   }
+}
+
+TEST( CompressedVector, ParallelEncode )
+{
+   constexpr size_t cNumRecords = 100000;
+
+   e57::CompressedVectorWriterOptions options;
+   const auto serial = RoundTripRecords( "./ParallelEncode1.e57", options, cNumRecords );
+
+   options.encodeThreads = 4;
+   const auto parallel = RoundTripRecords( "./ParallelEncode4.e57", options, cNumRecords );
+
+   // Writing the packets on another thread doesn't change them either
+   options.asyncWrite = true;
+   const auto async = RoundTripRecords( "./ParallelEncodeAsync.e57", options, cNumRecords );
+
+   ASSERT_FALSE( serial.empty() );
+   EXPECT_TRUE( serial == parallel );
+   EXPECT_TRUE( serial == async );
+}
+
+TEST( CompressedVector, ChunkedEncode )
+{
+   // Write in two calls, so the runs in the second one don't start on a multiple of 64 records
+   constexpr size_t cWriteSize = 30001;
+
+   e57::CompressedVectorWriterOptions options;
+   options.encodeThreads = 4;
+   options.chunkRecords = 5000;
+
+   const auto file = RoundTripRecords( "./ChunkedEncode.e57", options, 2 * cWriteSize, cWriteSize );
+   const auto bytes = LogicalBytes( file );
+   const PointsSection section = ReadPointsSection( bytes );
+
+   // Runs are 5056 records (rounded up to a multiple of 64) and start on a multiple of 64, so
+   // each write() holds 5 whole runs, the second's starting at record 30016. The first run is
+   // the start of the data, which the index has an entry for anyway.
+   const std::vector<uint64_t> cRunStarts = { 0,     5056,  10112, 15168, 20224,
+                                              30016, 35072, 40128, 45184, 50240 };
+
+   // packetType, packetFlags, packetLogicalLengthMinus1, entryCount, indexLevel, reserved
+   const uint64_t indexStart = PhysicalToLogical( section.indexPhysicalOffset );
+   ASSERT_EQ( ReadValue<uint8_t>( bytes, indexStart ), 0 );
+   ASSERT_EQ( ReadValue<uint16_t>( bytes, indexStart + 4 ), cRunStarts.size() );
+
+   for ( size_t i = 0; i < cRunStarts.size(); ++i )
+   {
+      // chunkRecordNumber, chunkPhysicalOffset
+      const uint64_t entryStart = indexStart + 16 + i * 16;
+      const auto chunkRecordNumber = ReadValue<uint64_t>( bytes, entryStart );
+      const auto chunkPhysicalOffset = ReadValue<uint64_t>( bytes, entryStart + 8 );
+
+      EXPECT_EQ( chunkRecordNumber, cRunStarts[i] ) << "entry " << i;
+
+      const auto packet = std::find_if(
+         section.packets.begin(), section.packets.end(), [&]( const SectionPacket &inPacket ) {
+            return LogicalToPhysical( inPacket.logicalOffset ) == chunkPhysicalOffset;
+         } );
+
+      ASSERT_NE( packet, section.packets.end() ) << "entry " << i << " isn't at a packet";
+      EXPECT_EQ( packet->packetType, 1 ) << "entry " << i << " isn't at a data packet";
+   }
+
+   EXPECT_EQ( ReadValue<uint64_t>( bytes, indexStart + 16 + 8 ), section.dataPhysicalOffset );
+}
+
+TEST( CompressedVector, EncoderBufferSize )
+{
+   // One smaller than a data packet, one large enough for the encoders' output to wrap around
+   for ( const size_t encoderBufferSize : { size_t( 1024 ), size_t( 256 * 1024 ) } )
+   {
+      e57::CompressedVectorWriterOptions options;
+      options.encoderBufferSize = encoderBufferSize;
+
+      RoundTripRecords( "./EncoderBufferSize.e57", options, 20000 );
+   }
+}
+
+TEST( CompressedVector, EncoderBufferSizeTooSmall )
+{
+   e57::ImageFile imf( "./EncoderBufferSizeTooSmall.e57", "w" );
+
+   e57::StructureNode proto( imf );
+   proto.set( "cartesianX", e57::FloatNode( imf, 0., e57::PrecisionDouble ) );
+
+   e57::CompressedVectorNode points( imf, proto, e57::VectorNode( imf, true ) );
+   imf.root().set( "points", points );
+
+   std::vector<double> x( 10 );
+   std::vector<e57::SourceDestBuffer> sbufs;
+   sbufs.emplace_back( imf, "cartesianX", x.data(), x.size(), true );
+
+   e57::CompressedVectorWriterOptions options;
+   options.encoderBufferSize = 100;
+
+   E57_ASSERT_THROW( points.writer( sbufs, options ) );
+
+   imf.close();
+}
+
+TEST( CompressedVector, TargetPacketSize )
+{
+   struct Layout
+   {
+      size_t targetPacketSize;
+      bool alignPacketsToPages;
+      size_t chunkRecords;
+   };
+
+   const Layout cLayouts[] = {
+      { 1000, false, 0 },      { 8 * 1020, true, 0 },   { 5000, true, 0 },
+      { 64 * 1024, false, 0 }, { 64 * 1024, true, 0 }, { 4096, true, 12000 },
+   };
+
+   for ( const Layout &layout : cLayouts )
+   {
+      e57::CompressedVectorWriterOptions options;
+      options.targetPacketSize = layout.targetPacketSize;
+      options.alignPacketsToPages = layout.alignPacketsToPages;
+      options.chunkRecords = layout.chunkRecords;
+
+      const auto bytes =
+         LogicalBytes( RoundTripRecords( "./TargetPacketSize.e57", options, 20000 ) );
+      const PointsSection section = ReadPointsSection( bytes );
+
+      // Aligned packets are filled to whole pages
+      uint64_t maxPacketSize = layout.targetPacketSize;
+      if ( layout.alignPacketsToPages )
+      {
+         maxPacketSize = std::min<uint64_t>(
+                            ( maxPacketSize + cLogicalPageSize - 1 ) / cLogicalPageSize, 64 ) *
+                         cLogicalPageSize;
+      }
+
+      // Data packets, with empty packets in the gaps before aligned ones, then the index packet
+      ASSERT_GE( section.packets.size(), 2u );
+
+      for ( size_t i = 0; i + 1 < section.packets.size(); ++i )
+      {
+         const SectionPacket &packet = section.packets[i];
+         const uint64_t physicalOffset = LogicalToPhysical( packet.logicalOffset );
+
+         if ( packet.packetType == 1 )
+         {
+            EXPECT_LE( packet.logicalLength, maxPacketSize )
+               << "targetPacketSize=" << layout.targetPacketSize << " packet " << i;
+
+            if ( layout.alignPacketsToPages )
+            {
+               EXPECT_EQ( physicalOffset % cPhysicalPageSize, 0u )
+                  << "targetPacketSize=" << layout.targetPacketSize << " packet " << i;
+            }
+         }
+         else
+         {
+            EXPECT_TRUE( layout.alignPacketsToPages && ( packet.packetType == 2 ) )
+               << "targetPacketSize=" << layout.targetPacketSize << " packet " << i
+               << " has type " << int( packet.packetType );
+         }
+      }
+
+      EXPECT_EQ( section.packets.back().packetType, 0 );
+      EXPECT_EQ( LogicalToPhysical( section.packets.back().logicalOffset ),
+                 section.indexPhysicalOffset );
+   }
+}
+
+TEST( CompressedVector, TargetPacketSizeOutOfRange )
+{
+   e57::ImageFile imf( "./TargetPacketSizeOutOfRange.e57", "w" );
+
+   e57::StructureNode proto( imf );
+   proto.set( "cartesianX", e57::FloatNode( imf, 0., e57::PrecisionDouble ) );
+   proto.set( "cartesianY", e57::FloatNode( imf, 0., e57::PrecisionDouble ) );
+
+   e57::CompressedVectorNode points( imf, proto, e57::VectorNode( imf, true ) );
+   imf.root().set( "points", points );
+
+   std::vector<double> x( 10 );
+   std::vector<double> y( 10 );
+   std::vector<e57::SourceDestBuffer> sbufs;
+   sbufs.emplace_back( imf, "cartesianX", x.data(), x.size(), true );
+   sbufs.emplace_back( imf, "cartesianY", y.data(), y.size(), true );
+
+   e57::CompressedVectorWriterOptions options;
+
+   // The header and a byte of each field take 12 bytes
+   options.targetPacketSize = 12;
+   E57_ASSERT_THROW( points.writer( sbufs, options ) );
+
+   options.targetPacketSize = 64 * 1024 + 4;
+   E57_ASSERT_THROW( points.writer( sbufs, options ) );
+
+   imf.close();
+}
+
+TEST( CompressedVector, FieldRange )
+{
+   constexpr size_t cNumRecords = 20000;
+
+   e57::ImageFile imf( "./FieldRange.e57", "w" );
+
+   e57::StructureNode proto( imf );
+   proto.set( "cartesianX", e57::FloatNode( imf, 0., e57::PrecisionSingle ) );
+   proto.set( "cartesianY", e57::ScaledIntegerNode( imf, 0, -100000, 100000, -0.01, 5. ) );
+   proto.set( "label", e57::StringNode( imf ) );
+
+   e57::CompressedVectorNode points( imf, proto, e57::VectorNode( imf, true ) );
+   imf.root().set( "points", points );
+
+   std::vector<float> x( cNumRecords );
+   std::vector<double> y( cNumRecords );
+   std::vector<e57::ustring> labels( cNumRecords, "label" );
+
+   for ( size_t i = 0; i < cNumRecords; ++i )
+   {
+      x[i] = static_cast<float>( i ) - 1000.0f;
+      y[i] = ( i % 1000 ) * 0.5 - 100.0;
+   }
+
+   // NaNs are left out
+   x[500] = std::numeric_limits<float>::quiet_NaN();
+
+   std::vector<e57::SourceDestBuffer> sbufs;
+   sbufs.emplace_back( imf, "cartesianX", x.data(), cNumRecords, true );
+   sbufs.emplace_back( imf, "cartesianY", y.data(), cNumRecords, true, true );
+   sbufs.emplace_back( imf, "label", &labels );
+
+   // Part of the records go through separately encoded runs
+   e57::CompressedVectorWriterOptions options;
+   options.collectStatistics = true;
+   options.chunkRecords = 5000;
+
+   e57::CompressedVectorWriter writer = points.writer( sbufs, options );
+
+   double minimum = 0.0;
+   double maximum = 0.0;
+   EXPECT_FALSE( writer.fieldRange( "cartesianX", minimum, maximum ) );
+
+   writer.write( cNumRecords );
+   writer.close();
+
+   EXPECT_TRUE( writer.fieldRange( "cartesianX", minimum, maximum ) );
+   EXPECT_EQ( minimum, -1000.0 );
+   EXPECT_EQ( maximum, cNumRecords - 1001.0 );
+
+   EXPECT_TRUE( writer.fieldRange( "cartesianY", minimum, maximum ) );
+   EXPECT_NEAR( minimum, -100.0, 1e-9 );
+   EXPECT_NEAR( maximum, 399.5, 1e-9 );
+
+   EXPECT_FALSE( writer.fieldRange( "label", minimum, maximum ) );
+   E57_ASSERT_THROW( writer.fieldRange( "cartesianZ", minimum, maximum ) );
+
+   imf.close();
+}
+
+TEST( CompressedVector, DeltaCodecUnknownCodec )
+{
+   e57::ImageFile imf( "./DeltaCodecUnknownCodec.e57", "w" );
+
+   constexpr char cUnknownURI[] = "https://example.com/unknown-codec";
+
+   // A codec we don't have, and the delta codec's name in a namespace which isn't its own
+   const std::vector<std::pair<const char *, e57::ustring>> cCodecs = {
+      { cUnknownURI, "fancyCodec" },
+      { cUnknownURI, "deltaCodec" },
+   };
+
+   for ( const auto &codecName : cCodecs )
+   {
+      e57::StructureNode proto( imf );
+      proto.set( "index", e57::IntegerNode( imf, 0, 0, 1000 ) );
+
+      e57::CompressedVectorNode points(
+         imf, proto, FieldCodecs( imf, codecName.first, codecName.second, { "index" } ) );
+      imf.root().set( "points" + codecName.second, points );
+
+      std::vector<int32_t> index( 10 );
+      std::vector<e57::SourceDestBuffer> sbufs;
+      sbufs.emplace_back( imf, "index", index.data(), index.size(), true );
+
+      try
+      {
+         points.writer( sbufs );
+
+         FAIL() << "Expected ErrorBadCodecs for " << codecName.second;
+      }
+      catch ( e57::E57Exception &err )
+      {
+         EXPECT_EQ( err.errorCode(), e57::ErrorBadCodecs ) << err.context();
+      }
+   }
+
+   imf.cancel();
+}
+
+TEST( CompressedVector, DeltaCodec64Bit )
+{
+   constexpr size_t cNumRecords = 10000;
+   constexpr int64_t cMin = std::numeric_limits<int64_t>::min();
+   constexpr int64_t cMax = std::numeric_limits<int64_t>::max();
+
+   // Jumps between the extremes, whose differences wrap around and take all 64 bits
+   auto jumpValue = []( size_t i ) -> int64_t {
+      switch ( i % 3 )
+      {
+         case 0:
+            return cMin + static_cast<int64_t>( i );
+         case 1:
+            return cMax - static_cast<int64_t>( i );
+         default:
+            return static_cast<int64_t>( i * 0x9E3779B97F4A7C15ULL );
+      }
+   };
+
+   // Small steps near the top of the range, so the first value of each block takes 8 bytes
+   auto rampValue = []( size_t i ) { return cMax - 2 * static_cast<int64_t>( cNumRecords - i ); };
+
+   // Small steps down from the top of a ScaledInteger's 63-bit range
+   const int64_t cScaledMax = int64_t{ 1 } << 62;
+   auto scaledValue = [&]( size_t i ) { return cScaledMax - 3 * static_cast<int64_t>( i ); };
+
+   {
+      e57::ImageFile imf( "./DeltaCodec64Bit.e57", "w" );
+
+      e57::StructureNode proto( imf );
+      proto.set( "jump", e57::IntegerNode( imf, 0, cMin, cMax ) );
+      proto.set( "ramp", e57::IntegerNode( imf, 0, cMin, cMax ) );
+      proto.set( "scaled",
+                 e57::ScaledIntegerNode( imf, int64_t{ 0 }, -cScaledMax, cScaledMax, 0.5, 0.0 ) );
+
+      e57::CompressedVectorNode points(
+         imf, proto,
+         FieldCodecs( imf, e57::DELTA_CODEC_URI, "deltaCodec", { "jump", "ramp", "scaled" } ) );
+      imf.root().set( "points", points );
+
+      std::vector<int64_t> jump( cNumRecords );
+      std::vector<int64_t> ramp( cNumRecords );
+      std::vector<int64_t> scaled( cNumRecords );
+
+      for ( size_t i = 0; i < cNumRecords; ++i )
+      {
+         jump[i] = jumpValue( i );
+         ramp[i] = rampValue( i );
+         scaled[i] = scaledValue( i );
+      }
+
+      std::vector<e57::SourceDestBuffer> sbufs;
+      sbufs.emplace_back( imf, "jump", jump.data(), cNumRecords );
+      sbufs.emplace_back( imf, "ramp", ramp.data(), cNumRecords );
+      sbufs.emplace_back( imf, "scaled", scaled.data(), cNumRecords );
+
+      e57::CompressedVectorWriter writer = points.writer( sbufs );
+      writer.write( cNumRecords );
+      writer.close();
+
+      imf.close();
+   }
+
+   e57::ImageFile imf( "./DeltaCodec64Bit.e57", "r" );
+   e57::CompressedVectorNode points( imf.root().get( "points" ) );
+
+   // Read back in pieces, so blocks are split between reads
+   constexpr size_t cBufferSize = 777;
+
+   std::vector<int64_t> jump( cBufferSize );
+   std::vector<int64_t> ramp( cBufferSize );
+   std::vector<int64_t> scaled( cBufferSize );
+
+   std::vector<e57::SourceDestBuffer> dbufs;
+   dbufs.emplace_back( imf, "jump", jump.data(), cBufferSize );
+   dbufs.emplace_back( imf, "ramp", ramp.data(), cBufferSize );
+   dbufs.emplace_back( imf, "scaled", scaled.data(), cBufferSize );
+
+   e57::CompressedVectorReader reader = points.reader( dbufs );
+
+   size_t recordIndex = 0;
+   while ( const unsigned readCount = reader.read() )
+   {
+      for ( unsigned i = 0; i < readCount; ++i, ++recordIndex )
+      {
+         ASSERT_EQ( jump[i], jumpValue( recordIndex ) ) << "record " << recordIndex;
+         ASSERT_EQ( ramp[i], rampValue( recordIndex ) ) << "record " << recordIndex;
+         ASSERT_EQ( scaled[i], scaledValue( recordIndex ) ) << "record " << recordIndex;
+      }
+   }
+   reader.close();
+   imf.close();
+
+   EXPECT_EQ( recordIndex, cNumRecords );
+}
+
+TEST( CompressedVector, DeltaCodecChunkRecords )
+{
+   constexpr int64_t cNumRows = 250;
+   constexpr int64_t cNumColumns = 80;
+   constexpr int64_t cNumPoints = cNumRows * cNumColumns;
+   constexpr int64_t cMinTime = 0;
+
+   {
+      e57::ImageFile imf( "./DeltaCodecChunkRecords.e57", "w" );
+
+      e57::StructureNode proto( imf );
+      proto.set( "rowIndex", e57::IntegerNode( imf, 0, 0, cNumRows - 1 ) );
+      proto.set( "columnIndex", e57::IntegerNode( imf, 0, 0, cNumColumns - 1 ) );
+      proto.set( "timeStamp",
+                 e57::ScaledIntegerNode( imf, cMinTime, cMinTime, cNumPoints * 10, 1.0e-4, 5.0 ) );
+      proto.set( "cartesianX", e57::FloatNode( imf, 0.0, e57::PrecisionDouble ) );
+
+      e57::CompressedVectorNode points(
+         imf, proto,
+         FieldCodecs( imf, e57::DELTA_CODEC_URI, "deltaCodec",
+                      { "rowIndex", "columnIndex", "timeStamp" } ) );
+      imf.root().set( "points", points );
+
+      std::vector<int32_t> rowIndex( cNumPoints );
+      std::vector<int32_t> columnIndex( cNumPoints );
+      std::vector<int64_t> timeStamp( cNumPoints );
+      std::vector<double> cartesianX( cNumPoints );
+
+      // Column by column, the way a scanner sweeps
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         rowIndex[i] = static_cast<int32_t>( i % cNumRows );
+         columnIndex[i] = static_cast<int32_t>( i / cNumRows );
+         timeStamp[i] = i * 10 + ( i % 7 );
+         cartesianX[i] = static_cast<double>( i ) * 0.25;
+      }
+
+      std::vector<e57::SourceDestBuffer> sbufs;
+      sbufs.emplace_back( imf, "rowIndex", rowIndex.data(), cNumPoints, true );
+      sbufs.emplace_back( imf, "columnIndex", columnIndex.data(), cNumPoints, true );
+      sbufs.emplace_back( imf, "timeStamp", timeStamp.data(), cNumPoints );
+      sbufs.emplace_back( imf, "cartesianX", cartesianX.data(), cNumPoints );
+
+      // Runs which end part way through a column, encoded concurrently
+      e57::CompressedVectorWriterOptions options;
+      options.chunkRecords = 1000;
+      options.encodeThreads = 3;
+
+      e57::CompressedVectorWriter writer = points.writer( sbufs, options );
+      writer.write( cNumPoints );
+      writer.close();
+
+      imf.close();
+   }
+
+   e57::ImageFile imf( "./DeltaCodecChunkRecords.e57", "r" );
+   e57::CompressedVectorNode points( imf.root().get( "points" ) );
+
+   constexpr int64_t cBufferSize = 999;
+
+   std::vector<int32_t> rowIndex( cBufferSize );
+   std::vector<int32_t> columnIndex( cBufferSize );
+   std::vector<int64_t> timeStamp( cBufferSize );
+   std::vector<double> cartesianX( cBufferSize );
+
+   std::vector<e57::SourceDestBuffer> dbufs;
+   dbufs.emplace_back( imf, "rowIndex", rowIndex.data(), cBufferSize, true );
+   dbufs.emplace_back( imf, "columnIndex", columnIndex.data(), cBufferSize, true );
+   dbufs.emplace_back( imf, "timeStamp", timeStamp.data(), cBufferSize );
+   dbufs.emplace_back( imf, "cartesianX", cartesianX.data(), cBufferSize );
+
+   e57::CompressedVectorReader reader = points.reader( dbufs );
+
+   int64_t pointIndex = 0;
+   while ( const unsigned readCount = reader.read() )
+   {
+      for ( unsigned i = 0; i < readCount; ++i, ++pointIndex )
+      {
+         ASSERT_EQ( rowIndex[i], pointIndex % cNumRows );
+         ASSERT_EQ( columnIndex[i], pointIndex / cNumRows );
+         ASSERT_EQ( timeStamp[i], pointIndex * 10 + ( pointIndex % 7 ) );
+         ASSERT_EQ( cartesianX[i], static_cast<double>( pointIndex ) * 0.25 );
+      }
+   }
+   reader.close();
+
+   EXPECT_EQ( pointIndex, cNumPoints );
+
+   // Where delta-coded records start in a packet isn't known without decoding earlier packets
+   e57::CompressedVectorReaderOptions options;
+   options.packetStride = 3;
+
+   std::vector<e57::SourceDestBuffer> plainDbufs;
+   plainDbufs.emplace_back( imf, "cartesianX", cartesianX.data(), cBufferSize );
+   E57_ASSERT_NO_THROW( points.reader( plainDbufs, options ).close() );
+
+   try
+   {
+      points.reader( dbufs, options );
+
+      FAIL() << "Expected ErrorNotImplemented";
+   }
+   catch ( e57::E57Exception &err )
+   {
+      EXPECT_EQ( err.errorCode(), e57::ErrorNotImplemented ) << err.context();
+   }
+
+   imf.close();
+}
+
+TEST( CompressedVector, StringArena )
+{
+   constexpr size_t cNumRecords = 500;
+
+   // Some long enough to span data packets
+   auto label = []( size_t i ) {
+      return ( i % 50 == 0 ) ? std::string( 3000 + i, 'x' ) : "label " + std::to_string( i );
+   };
+
+   // Write some strings using the Foundation API
+   {
+      e57::ImageFile imf( "./StringArena.e57", "w" );
+
+      e57::StructureNode proto( imf );
+      proto.set( "label", e57::StringNode( imf ) );
+      proto.set( "index", e57::IntegerNode( imf, 0, 0, cNumRecords ) );
+
+      e57::CompressedVectorNode points( imf, proto, e57::VectorNode( imf, true ) );
+      imf.root().set( "points", points );
+
+      std::vector<e57::ustring> labels( cNumRecords );
+      std::vector<int32_t> indices( cNumRecords );
+
+      for ( size_t i = 0; i < cNumRecords; ++i )
+      {
+         labels[i] = label( i );
+         indices[i] = static_cast<int32_t>( i );
+      }
+
+      std::vector<e57::SourceDestBuffer> sbufs;
+      sbufs.emplace_back( imf, "label", &labels );
+      sbufs.emplace_back( imf, "index", indices.data(), cNumRecords, true );
+
+      e57::CompressedVectorWriter writer = points.writer( sbufs );
+      writer.write( cNumRecords );
+      writer.close();
+
+      imf.close();
+   }
+
+   // Read them back into an arena, a block at a time
+   e57::ImageFile imf( "./StringArena.e57", "r" );
+
+   e57::CompressedVectorNode points( imf.root().get( "points" ) );
+
+   constexpr size_t cBlockSize = 64;
+
+   e57::StringArena arena;
+   std::vector<int32_t> indices( cBlockSize );
+
+   std::vector<e57::SourceDestBuffer> dbufs;
+   dbufs.emplace_back( imf, "label", &arena, cBlockSize );
+   dbufs.emplace_back( imf, "index", indices.data(), cBlockSize, true );
+
+   ASSERT_EQ( arena.offsets.size(), cBlockSize );
+   ASSERT_EQ( arena.lengths.size(), cBlockSize );
+
+   e57::CompressedVectorReader reader = points.reader( dbufs );
+
+   size_t total = 0;
+   unsigned count = 0;
+
+   while ( ( count = reader.read() ) > 0 )
+   {
+      for ( unsigned i = 0; i < count; ++i )
+      {
+         const size_t index = static_cast<size_t>( indices[i] );
+
+         ASSERT_EQ( index, total + i );
+         EXPECT_EQ( arena.stringAt( i ), label( index ) );
+      }
+
+      total += count;
+   }
+
+   reader.close();
+   imf.close();
+
+   EXPECT_EQ( total, cNumRecords );
+}
+
+TEST( CompressedVector, FilterLargeIntegers )
+{
+   constexpr size_t cNumRecords = 1000;
+
+   // Neighbouring values this large are the same when converted to double
+   constexpr int64_t cBase = int64_t{ 1 } << 60;
+
+   {
+      e57::ImageFile imf( "./FilterLargeIntegers.e57", "w" );
+
+      e57::StructureNode proto( imf );
+      proto.set( "id", e57::IntegerNode( imf, cBase, cBase, cBase + cNumRecords - 1 ) );
+
+      e57::CompressedVectorNode points( imf, proto, e57::VectorNode( imf, true ) );
+      imf.root().set( "points", points );
+
+      std::vector<int64_t> ids( cNumRecords );
+      for ( size_t i = 0; i < cNumRecords; ++i )
+      {
+         ids[i] = cBase + static_cast<int64_t>( i );
+      }
+
+      std::vector<e57::SourceDestBuffer> sbufs;
+      sbufs.emplace_back( imf, "id", ids.data(), cNumRecords );
+
+      e57::CompressedVectorWriter writer = points.writer( sbufs );
+      writer.write( cNumRecords );
+      writer.close();
+
+      imf.close();
+   }
+
+   e57::ImageFile imf( "./FilterLargeIntegers.e57", "r" );
+   e57::CompressedVectorNode points( imf.root().get( "points" ) );
+
+   // Read the ids which pass the filter, checking each one with expected()
+   const auto readFiltered = [&]( e57::FilterComparison inComparison, double inValue,
+                                  const std::function<bool( int64_t )> &expected ) {
+      std::vector<int64_t> ids( cNumRecords );
+
+      std::vector<e57::SourceDestBuffer> dbufs;
+      dbufs.emplace_back( imf, "id", ids.data(), cNumRecords );
+
+      e57::CompressedVectorReaderOptions options;
+      options.filters.push_back( { "id", inComparison, inValue } );
+
+      e57::CompressedVectorReader reader = points.reader( dbufs, options );
+      const unsigned count = reader.read();
+      reader.close();
+
+      size_t expectedCount = 0;
+      for ( size_t i = 0; i < cNumRecords; ++i )
+      {
+         const int64_t id = cBase + static_cast<int64_t>( i );
+         if ( expected( id ) )
+         {
+            EXPECT_EQ( ids[expectedCount], id );
+            ++expectedCount;
+         }
+      }
+
+      return ( count == expectedCount );
+   };
+
+   // 2^60 + 512 is exactly representable as a double
+   constexpr int64_t cValue = cBase + 512;
+   const auto cDoubleValue = static_cast<double>( cValue );
+
+   EXPECT_TRUE( readFiltered( e57::FilterEqual, cDoubleValue,
+                              [=]( int64_t id ) { return id == cValue; } ) );
+   EXPECT_TRUE( readFiltered( e57::FilterNotEqual, cDoubleValue,
+                              [=]( int64_t id ) { return id != cValue; } ) );
+   EXPECT_TRUE( readFiltered( e57::FilterLess, cDoubleValue,
+                              [=]( int64_t id ) { return id < cValue; } ) );
+   EXPECT_TRUE( readFiltered( e57::FilterGreater, cDoubleValue,
+                              [=]( int64_t id ) { return id > cValue; } ) );
+   EXPECT_TRUE( readFiltered( e57::FilterGreaterEqual, cDoubleValue,
+                              [=]( int64_t id ) { return id >= cValue; } ) );
+
+   // Beyond int64_t
+   EXPECT_TRUE( readFiltered( e57::FilterLess, 1.0e19, []( int64_t ) { return true; } ) );
+   EXPECT_TRUE( readFiltered( e57::FilterEqual, 9223372036854775808.0,
+                              []( int64_t ) { return false; } ) );
+   EXPECT_TRUE( readFiltered( e57::FilterGreater, -1.0e19, []( int64_t ) { return true; } ) );
+
+   imf.close();
+}
+
+TEST( CompressedVector, DecodeIntegerDestinations )
+{
+   constexpr size_t cNumRecords = 5000;
+
+   auto aValue = []( size_t i ) { return static_cast<int32_t>( ( i * 37 ) % 2001 ) - 1000; };
+   auto bValue = []( size_t i ) { return static_cast<int32_t>( i % 201 ); };
+
+   {
+      e57::ImageFile imf( "./DecodeIntegerDestinations.e57", "w" );
+
+      // 11 bits in a 16-bit register, and 8 bits in an 8-bit register
+      e57::StructureNode proto( imf );
+      proto.set( "a", e57::IntegerNode( imf, 0, -1000, 1000 ) );
+      proto.set( "b", e57::IntegerNode( imf, 0, 0, 200 ) );
+
+      e57::CompressedVectorNode points( imf, proto, e57::VectorNode( imf, true ) );
+      imf.root().set( "points", points );
+
+      std::vector<int32_t> a( cNumRecords );
+      std::vector<int32_t> b( cNumRecords );
+
+      for ( size_t i = 0; i < cNumRecords; ++i )
+      {
+         a[i] = aValue( i );
+         b[i] = bValue( i );
+      }
+
+      std::vector<e57::SourceDestBuffer> sbufs;
+      sbufs.emplace_back( imf, "a", a.data(), cNumRecords, true );
+      sbufs.emplace_back( imf, "b", b.data(), cNumRecords, true );
+
+      e57::CompressedVectorWriter writer = points.writer( sbufs );
+      writer.write( cNumRecords );
+      writer.close();
+
+      imf.close();
+   }
+
+   e57::ImageFile imf( "./DecodeIntegerDestinations.e57", "r" );
+   e57::CompressedVectorNode points( imf.root().get( "points" ) );
+
+   // Narrower contiguous buffers which hold every value
+   {
+      std::vector<int16_t> a( cNumRecords );
+      std::vector<uint8_t> b( cNumRecords );
+
+      std::vector<e57::SourceDestBuffer> dbufs;
+      dbufs.emplace_back( imf, "a", a.data(), cNumRecords, true );
+      dbufs.emplace_back( imf, "b", b.data(), cNumRecords, true );
+
+      e57::CompressedVectorReader reader = points.reader( dbufs );
+      ASSERT_EQ( reader.read(), cNumRecords );
+      reader.close();
+
+      for ( size_t i = 0; i < cNumRecords; ++i )
+      {
+         ASSERT_EQ( a[i], aValue( i ) );
+         ASSERT_EQ( b[i], bValue( i ) );
+      }
+   }
+
+   // Strided buffers, interleaved in an array of structures
+   {
+      struct Record
+      {
+         int32_t a;
+         uint8_t b;
+         double other;
+      };
+
+      std::vector<Record> records( cNumRecords, Record{ 0, 0, -1.0 } );
+
+      std::vector<e57::SourceDestBuffer> dbufs;
+      dbufs.emplace_back( imf, "a", &records[0].a, cNumRecords, true, false, sizeof( Record ) );
+      dbufs.emplace_back( imf, "b", &records[0].b, cNumRecords, true, false, sizeof( Record ) );
+
+      e57::CompressedVectorReader reader = points.reader( dbufs );
+      ASSERT_EQ( reader.read(), cNumRecords );
+      reader.close();
+
+      for ( size_t i = 0; i < cNumRecords; ++i )
+      {
+         ASSERT_EQ( records[i].a, aValue( i ) );
+         ASSERT_EQ( records[i].b, bValue( i ) );
+         ASSERT_EQ( records[i].other, -1.0 );
+      }
+   }
+
+   // Buffers too narrow for some of the values
+   {
+      std::vector<int8_t> a( cNumRecords );
+      std::vector<uint8_t> b( cNumRecords );
+
+      std::vector<e57::SourceDestBuffer> dbufs;
+      dbufs.emplace_back( imf, "a", a.data(), cNumRecords, true );
+      dbufs.emplace_back( imf, "b", b.data(), cNumRecords, true );
+
+      e57::CompressedVectorReader reader = points.reader( dbufs );
+      ExpectReadError( reader, e57::ErrorValueNotRepresentable );
+      reader.close();
+   }
+
+   {
+      // Every other byte, so the strided path is checked too. The vector covers every record
+      // the buffer could be given, even if the range check didn't stop the read.
+      constexpr size_t cStride = 2;
+
+      std::vector<int16_t> a( cNumRecords );
+      std::vector<int8_t> b( cStride * cNumRecords );
+
+      std::vector<e57::SourceDestBuffer> dbufs;
+      dbufs.emplace_back( imf, "a", a.data(), cNumRecords, true );
+      dbufs.emplace_back( imf, "b", b.data(), cNumRecords, true, false, cStride );
+
+      e57::CompressedVectorReader reader = points.reader( dbufs );
+      ExpectReadError( reader, e57::ErrorValueNotRepresentable );
+      reader.close();
+   }
+
+   imf.close();
+}
+
+TEST( CompressedVector, DecodeScaledIntegerDestinations )
+{
+   constexpr size_t cNumRecords = 5000;
+
+   // 20 bits in a 32-bit register, and 10 bits in a 16-bit one whose scaled values are integers
+   constexpr double cXScale = 0.001;
+   constexpr double cXOffset = 10.0;
+   constexpr double cYScale = 2.0;
+   constexpr double cYOffset = -5.0;
+
+   auto xRaw = []( size_t i ) { return static_cast<int64_t>( ( i * 7919 ) % 1000001 ) - 500000; };
+   auto yRaw = []( size_t i ) { return static_cast<int64_t>( ( i * 13 ) % 1001 ); };
+
+   {
+      e57::ImageFile imf( "./DecodeScaledIntegerDestinations.e57", "w" );
+
+      e57::StructureNode proto( imf );
+      proto.set( "x", e57::ScaledIntegerNode( imf, 0, -500000, 500000, cXScale, cXOffset ) );
+      proto.set( "y", e57::ScaledIntegerNode( imf, 0, 0, 1000, cYScale, cYOffset ) );
+
+      e57::CompressedVectorNode points( imf, proto, e57::VectorNode( imf, true ) );
+      imf.root().set( "points", points );
+
+      std::vector<int64_t> x( cNumRecords );
+      std::vector<int64_t> y( cNumRecords );
+
+      for ( size_t i = 0; i < cNumRecords; ++i )
+      {
+         x[i] = xRaw( i );
+         y[i] = yRaw( i );
+      }
+
+      // Raw values, without scaling
+      std::vector<e57::SourceDestBuffer> sbufs;
+      sbufs.emplace_back( imf, "x", x.data(), cNumRecords );
+      sbufs.emplace_back( imf, "y", y.data(), cNumRecords );
+
+      e57::CompressedVectorWriter writer = points.writer( sbufs );
+      writer.write( cNumRecords );
+      writer.close();
+
+      imf.close();
+   }
+
+   e57::ImageFile imf( "./DecodeScaledIntegerDestinations.e57", "r" );
+   e57::CompressedVectorNode points( imf.root().get( "points" ) );
+
+   // Scaled into contiguous double and strided float buffers
+   {
+      struct Record
+      {
+         float y;
+         int32_t other;
+      };
+
+      std::vector<double> x( cNumRecords );
+      std::vector<Record> records( cNumRecords, Record{ 0.0f, -1 } );
+
+      std::vector<e57::SourceDestBuffer> dbufs;
+      dbufs.emplace_back( imf, "x", x.data(), cNumRecords, true, true );
+      dbufs.emplace_back( imf, "y", &records[0].y, cNumRecords, true, true, sizeof( Record ) );
+
+      e57::CompressedVectorReader reader = points.reader( dbufs );
+      ASSERT_EQ( reader.read(), cNumRecords );
+      reader.close();
+
+      for ( size_t i = 0; i < cNumRecords; ++i )
+      {
+         ASSERT_EQ( x[i], xRaw( i ) * cXScale + cXOffset );
+         ASSERT_EQ( records[i].y, static_cast<float>( yRaw( i ) * cYScale + cYOffset ) );
+         ASSERT_EQ( records[i].other, -1 );
+      }
+   }
+
+   // Raw values, and scaled into an integer buffer
+   {
+      std::vector<int64_t> x( cNumRecords );
+      std::vector<int16_t> y( cNumRecords );
+
+      std::vector<e57::SourceDestBuffer> dbufs;
+      dbufs.emplace_back( imf, "x", x.data(), cNumRecords, true, false );
+      dbufs.emplace_back( imf, "y", y.data(), cNumRecords, true, true );
+
+      e57::CompressedVectorReader reader = points.reader( dbufs );
+      ASSERT_EQ( reader.read(), cNumRecords );
+      reader.close();
+
+      for ( size_t i = 0; i < cNumRecords; ++i )
+      {
+         ASSERT_EQ( x[i], xRaw( i ) );
+         ASSERT_EQ( y[i], yRaw( i ) * cYScale + cYOffset );
+      }
+   }
+
+   // Scaled into an integer buffer too narrow for some of the values
+   {
+      std::vector<double> x( cNumRecords );
+      std::vector<int8_t> y( cNumRecords );
+
+      std::vector<e57::SourceDestBuffer> dbufs;
+      dbufs.emplace_back( imf, "x", x.data(), cNumRecords, true, true );
+      dbufs.emplace_back( imf, "y", y.data(), cNumRecords, true, true );
+
+      e57::CompressedVectorReader reader = points.reader( dbufs );
+      ExpectReadError( reader, e57::ErrorScaledValueNotRepresentable );
+      reader.close();
+   }
+
+   imf.close();
+}
+
+TEST( CompressedVector, DecodeConstantFields )
+{
+   constexpr size_t cNumRecords = 3000;
+
+   {
+      e57::ImageFile imf( "./DecodeConstantFields.e57", "w" );
+
+      // Fields whose minimum and maximum are the same take no bits
+      e57::StructureNode proto( imf );
+      proto.set( "constant", e57::IntegerNode( imf, 300, 300, 300 ) );
+      proto.set( "scaledConstant", e57::ScaledIntegerNode( imf, 7, 7, 7, 0.5, 1.0 ) );
+      proto.set( "index", e57::IntegerNode( imf, 0, 0, cNumRecords ) );
+
+      e57::CompressedVectorNode points( imf, proto, e57::VectorNode( imf, true ) );
+      imf.root().set( "points", points );
+
+      std::vector<int32_t> constant( cNumRecords, 300 );
+      std::vector<int64_t> scaledConstant( cNumRecords, 7 );
+      std::vector<int32_t> index( cNumRecords );
+
+      for ( size_t i = 0; i < cNumRecords; ++i )
+      {
+         index[i] = static_cast<int32_t>( i );
+      }
+
+      std::vector<e57::SourceDestBuffer> sbufs;
+      sbufs.emplace_back( imf, "constant", constant.data(), cNumRecords, true );
+      sbufs.emplace_back( imf, "scaledConstant", scaledConstant.data(), cNumRecords );
+      sbufs.emplace_back( imf, "index", index.data(), cNumRecords, true );
+
+      e57::CompressedVectorWriter writer = points.writer( sbufs );
+      writer.write( cNumRecords );
+      writer.close();
+
+      imf.close();
+   }
+
+   e57::ImageFile imf( "./DecodeConstantFields.e57", "r" );
+   e57::CompressedVectorNode points( imf.root().get( "points" ) );
+
+   // Contiguous, scaled, and read in blocks which don't divide the record count
+   {
+      constexpr size_t cBlockSize = 1001;
+
+      std::vector<int16_t> constant( cBlockSize );
+      std::vector<double> scaledConstant( cBlockSize );
+      std::vector<int32_t> index( cBlockSize );
+
+      std::vector<e57::SourceDestBuffer> dbufs;
+      dbufs.emplace_back( imf, "constant", constant.data(), cBlockSize, true );
+      dbufs.emplace_back( imf, "scaledConstant", scaledConstant.data(), cBlockSize, true, true );
+      dbufs.emplace_back( imf, "index", index.data(), cBlockSize, true );
+
+      e57::CompressedVectorReader reader = points.reader( dbufs );
+
+      size_t total = 0;
+      unsigned count = 0;
+
+      while ( ( count = reader.read() ) > 0 )
+      {
+         for ( unsigned i = 0; i < count; ++i )
+         {
+            ASSERT_EQ( constant[i], 300 );
+            ASSERT_EQ( scaledConstant[i], 4.5 );
+            ASSERT_EQ( index[i], static_cast<int32_t>( total + i ) );
+         }
+
+         total += count;
+      }
+
+      reader.close();
+
+      EXPECT_EQ( total, cNumRecords );
+   }
+
+   // Strided, and raw
+   {
+      struct Record
+      {
+         int64_t constant;
+         int64_t scaledConstant;
+         int32_t index;
+      };
+
+      std::vector<Record> records( cNumRecords, Record{ 0, 0, -1 } );
+
+      std::vector<e57::SourceDestBuffer> dbufs;
+      dbufs.emplace_back( imf, "constant", &records[0].constant, cNumRecords, true, false,
+                          sizeof( Record ) );
+      dbufs.emplace_back( imf, "scaledConstant", &records[0].scaledConstant, cNumRecords, true,
+                          false, sizeof( Record ) );
+      dbufs.emplace_back( imf, "index", &records[0].index, cNumRecords, true, false,
+                          sizeof( Record ) );
+
+      e57::CompressedVectorReader reader = points.reader( dbufs );
+      ASSERT_EQ( reader.read(), cNumRecords );
+      reader.close();
+
+      for ( size_t i = 0; i < cNumRecords; ++i )
+      {
+         ASSERT_EQ( records[i].constant, 300 );
+         ASSERT_EQ( records[i].scaledConstant, 7 );
+         ASSERT_EQ( records[i].index, static_cast<int32_t>( i ) );
+      }
+   }
+
+   // A buffer too narrow for the value
+   {
+      std::vector<uint8_t> constant( cNumRecords );
+      std::vector<double> scaledConstant( cNumRecords );
+      std::vector<int32_t> index( cNumRecords );
+
+      std::vector<e57::SourceDestBuffer> dbufs;
+      dbufs.emplace_back( imf, "constant", constant.data(), cNumRecords, true );
+      dbufs.emplace_back( imf, "scaledConstant", scaledConstant.data(), cNumRecords, true, true );
+      dbufs.emplace_back( imf, "index", index.data(), cNumRecords, true );
+
+      e57::CompressedVectorReader reader = points.reader( dbufs );
+      ExpectReadError( reader, e57::ErrorValueNotRepresentable );
+      reader.close();
+   }
+
+   imf.close();
+}
+
+TEST( CompressedVector, DecodeRecordsAcrossPackets )
+{
+   constexpr size_t cNumRecords = 20000;
+
+   // One field for each register size. 47 bits is unpacked through a 64-bit window, 64 bits
+   // can't be, and none of the widths divide a packet evenly.
+   struct Field
+   {
+      const char *name;
+      int64_t minimum;
+      int64_t maximum;
+   };
+
+   const std::vector<Field> cFields = {
+      { "bits5", 0, 31 },
+      { "bits13", -4096, 4095 },
+      { "bits29", 1000, 1000 + ( int64_t{ 1 } << 29 ) - 1 },
+      { "bits47", -( int64_t{ 1 } << 46 ), ( int64_t{ 1 } << 46 ) - 1 },
+      { "bits64", std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max() },
+   };
+
+   auto value = [&]( size_t field, size_t i ) {
+      const Field &f = cFields[field];
+      const uint64_t bits = MixBits( i * cFields.size() + field );
+
+      if ( f.maximum - f.minimum == -1 ) // full range
+      {
+         return static_cast<int64_t>( bits );
+      }
+
+      const auto range = static_cast<uint64_t>( f.maximum - f.minimum ) + 1;
+      return f.minimum + static_cast<int64_t>( bits % range );
+   };
+
+   {
+      e57::ImageFile imf( "./DecodeRecordsAcrossPackets.e57", "w" );
+
+      e57::StructureNode proto( imf );
+      for ( const Field &f : cFields )
+      {
+         proto.set( f.name, e57::IntegerNode( imf, f.minimum, f.minimum, f.maximum ) );
+      }
+
+      e57::CompressedVectorNode points( imf, proto, e57::VectorNode( imf, true ) );
+      imf.root().set( "points", points );
+
+      std::vector<std::vector<int64_t>> values( cFields.size(),
+                                                std::vector<int64_t>( cNumRecords ) );
+      std::vector<e57::SourceDestBuffer> sbufs;
+
+      for ( size_t field = 0; field < cFields.size(); ++field )
+      {
+         for ( size_t i = 0; i < cNumRecords; ++i )
+         {
+            values[field][i] = value( field, i );
+         }
+
+         sbufs.emplace_back( imf, cFields[field].name, values[field].data(), cNumRecords );
+      }
+
+      // Lots of small packets, so there are lots of records split between two of them
+      e57::CompressedVectorWriterOptions options;
+      options.targetPacketSize = 1000;
+
+      e57::CompressedVectorWriter writer = points.writer( sbufs, options );
+      writer.write( cNumRecords );
+      writer.close();
+
+      imf.close();
+   }
+
+   e57::ImageFile imf( "./DecodeRecordsAcrossPackets.e57", "r" );
+   e57::CompressedVectorNode points( imf.root().get( "points" ) );
+
+   // Read in blocks which end part way through packets, into the narrowest type for each field
+   constexpr size_t cBlockSize = 777;
+
+   std::vector<uint8_t> bits5( cBlockSize );
+   std::vector<int16_t> bits13( cBlockSize );
+   std::vector<int32_t> bits29( cBlockSize );
+   std::vector<int64_t> bits47( cBlockSize );
+   std::vector<int64_t> bits64( cBlockSize );
+
+   std::vector<e57::SourceDestBuffer> dbufs;
+   dbufs.emplace_back( imf, "bits5", bits5.data(), cBlockSize, true );
+   dbufs.emplace_back( imf, "bits13", bits13.data(), cBlockSize, true );
+   dbufs.emplace_back( imf, "bits29", bits29.data(), cBlockSize, true );
+   dbufs.emplace_back( imf, "bits47", bits47.data(), cBlockSize, true );
+   dbufs.emplace_back( imf, "bits64", bits64.data(), cBlockSize, true );
+
+   e57::CompressedVectorReader reader = points.reader( dbufs );
+
+   size_t total = 0;
+   unsigned count = 0;
+
+   while ( ( count = reader.read() ) > 0 )
+   {
+      for ( unsigned i = 0; i < count; ++i )
+      {
+         const size_t record = total + i;
+
+         ASSERT_EQ( bits5[i], value( 0, record ) ) << "record " << record;
+         ASSERT_EQ( bits13[i], value( 1, record ) ) << "record " << record;
+         ASSERT_EQ( bits29[i], value( 2, record ) ) << "record " << record;
+         ASSERT_EQ( bits47[i], value( 3, record ) ) << "record " << record;
+         ASSERT_EQ( bits64[i], value( 4, record ) ) << "record " << record;
+      }
+
+      total += count;
+   }
+
+   reader.close();
+   imf.close();
+
+   EXPECT_EQ( total, cNumRecords );
+}
@@ -1,9 +1,12 @@
 // libE57Format testing Copyright © 2022 Andy Maloney <asmaloney@gmail.com>
 // SPDX-License-Identifier: BSL-1.0
 
+#include <cmath>
+
 #include "gtest/gtest.h"
 
 #include "E57SimpleReader.h"
+#include "E57SimpleWriter.h"
 
 #include "Helpers.h"
 #include "TestData.h"
@@ -19,6 +22,7 @@ namespace
       EXPECT_EQ( fileHeader.versionMajor, 1 );
       EXPECT_EQ( fileHeader.versionMinor, 0 );
    }
+
 }
 
 TEST( SimpleReader, PathError )
@@ -330,6 +334,423 @@ TEST( SimpleReaderData, BunnyInt32 )
    delete reader;
 }
 
+TEST( SimpleReaderData, BunnyInt32Decimated )
+{
+   e57::Reader *reader = nullptr;
+
+   E57_ASSERT_NO_THROW( reader =
+                           new e57::Reader( TestData::Path() + "/reference/bunnyInt32.e57", {} ) );
+
+   e57::Data3D data3DHeader;
+   ASSERT_TRUE( reader->ReadData3D( 0, data3DHeader ) );
+
+   const uint64_t cNumPoints = data3DHeader.pointCount;
+   constexpr uint64_t cDecimation = 10;
+
+   // Read every point
+   e57::Data3DPointsFloat pointsData( data3DHeader );
+
+   auto vectorReader = reader->SetUpData3DPointsData( 0, cNumPoints, pointsData );
+
+   const uint64_t cNumRead = vectorReader.read();
+
+   vectorReader.close();
+
+   ASSERT_EQ( cNumRead, cNumPoints );
+
+   // Read every 10th point
+   e57::Data3DPointsFloat decimatedData( data3DHeader );
+
+   e57::CompressedVectorReaderOptions readOptions;
+   readOptions.decimation = cDecimation;
+
+   auto decimatedReader =
+      reader->SetUpData3DPointsData( 0, cNumPoints, decimatedData, readOptions );
+
+   const uint64_t cNumDecimatedRead = decimatedReader.read();
+
+   EXPECT_EQ( decimatedReader.read(), 0U );
+
+   decimatedReader.close();
+
+   ASSERT_EQ( cNumDecimatedRead, ( cNumPoints + cDecimation - 1 ) / cDecimation );
+
+   for ( uint64_t i = 0; i < cNumDecimatedRead; ++i )
+   {
+      EXPECT_EQ( decimatedData.cartesianX[i], pointsData.cartesianX[i * cDecimation] );
+      EXPECT_EQ( decimatedData.cartesianY[i], pointsData.cartesianY[i * cDecimation] );
+      EXPECT_EQ( decimatedData.cartesianZ[i], pointsData.cartesianZ[i * cDecimation] );
+   }
+
+   delete reader;
+}
+
+TEST( SimpleReaderData, BunnyInt32PacketPreview )
+{
+   e57::Reader *reader = nullptr;
+
+   E57_ASSERT_NO_THROW( reader =
+                           new e57::Reader( TestData::Path() + "/reference/bunnyInt32.e57", {} ) );
+
+   e57::Data3D data3DHeader;
+   ASSERT_TRUE( reader->ReadData3D( 0, data3DHeader ) );
+
+   const uint64_t cNumPoints = data3DHeader.pointCount;
+
+   // Read every point
+   e57::Data3DPointsFloat pointsData( data3DHeader );
+
+   auto vectorReader = reader->SetUpData3DPointsData( 0, cNumPoints, pointsData );
+
+   const uint64_t cNumRead = vectorReader.read();
+
+   vectorReader.close();
+
+   ASSERT_EQ( cNumRead, cNumPoints );
+
+   // Read every other packet
+   e57::Data3DPointsFloat previewData( data3DHeader );
+
+   e57::CompressedVectorReaderOptions readOptions;
+   readOptions.packetStride = 2;
+
+   auto previewReader = reader->SetUpData3DPointsData( 0, cNumPoints, previewData, readOptions );
+
+   uint64_t cNumPreviewRead = 0;
+   E57_ASSERT_NO_THROW( cNumPreviewRead = previewReader.read() );
+
+   previewReader.close();
+
+   EXPECT_GT( cNumPreviewRead, 0U );
+   EXPECT_LT( cNumPreviewRead, cNumPoints );
+
+   // The preview must be an ordered subset of the points
+   uint64_t j = 0;
+
+   for ( uint64_t i = 0; i < cNumPreviewRead; ++i )
+   {
+      while ( ( j < cNumPoints ) && ( ( previewData.cartesianX[i] != pointsData.cartesianX[j] ) ||
+                                      ( previewData.cartesianY[i] != pointsData.cartesianY[j] ) ||
+                                      ( previewData.cartesianZ[i] != pointsData.cartesianZ[j] ) ) )
+      {
+         ++j;
+      }
+
+      ASSERT_LT( j, cNumPoints ) << "Preview point " << i << " not found";
+
+      ++j;
+   }
+
+   delete reader;
+}
+
+TEST( SimpleReaderData, BunnyInt32Filtered )
+{
+   e57::Reader *reader = nullptr;
+
+   E57_ASSERT_NO_THROW( reader =
+                           new e57::Reader( TestData::Path() + "/reference/bunnyInt32.e57", {} ) );
+
+   e57::Data3D data3DHeader;
+   ASSERT_TRUE( reader->ReadData3D( 0, data3DHeader ) );
+
+   const uint64_t cNumPoints = data3DHeader.pointCount;
+
+   // Read every point
+   e57::Data3DPointsFloat pointsData( data3DHeader );
+
+   auto vectorReader = reader->SetUpData3DPointsData( 0, cNumPoints, pointsData );
+
+   const uint64_t cNumRead = vectorReader.read();
+
+   vectorReader.close();
+
+   ASSERT_EQ( cNumRead, cNumPoints );
+
+   // Read only the points in a slab, using a small buffer so it takes several reads
+   const float cMinX = 0.0f;
+   const float cMaxX = 0.05f;
+   const uint64_t cBufferSize = 1000;
+
+   auto inSlab = [=]( float x ) { return ( x >= cMinX ) && ( x < cMaxX ); };
+
+   e57::Data3DPointsFloat filteredData( data3DHeader );
+
+   e57::CompressedVectorReaderOptions readOptions;
+   readOptions.filters.push_back( { "cartesianX", e57::FilterGreaterEqual, cMinX } );
+   readOptions.filters.push_back( { "cartesianX", e57::FilterLess, cMaxX } );
+
+   auto filteredReader = reader->SetUpData3DPointsData( 0, cBufferSize, filteredData, readOptions );
+
+   uint64_t j = 0;
+   uint64_t cNumFilteredRead = 0;
+   unsigned count = 0;
+
+   while ( ( count = filteredReader.read() ) > 0 )
+   {
+      ASSERT_LE( count, cBufferSize );
+
+      for ( unsigned i = 0; i < count; ++i )
+      {
+         while ( ( j < cNumPoints ) && !inSlab( pointsData.cartesianX[j] ) )
+         {
+            ++j;
+         }
+
+         ASSERT_LT( j, cNumPoints );
+         EXPECT_EQ( filteredData.cartesianX[i], pointsData.cartesianX[j] );
+         EXPECT_EQ( filteredData.cartesianY[i], pointsData.cartesianY[j] );
+         EXPECT_EQ( filteredData.cartesianZ[i], pointsData.cartesianZ[j] );
+
+         ++j;
+      }
+
+      cNumFilteredRead += count;
+   }
+
+   filteredReader.close();
+
+   // Make sure we didn't miss any passing points at the end
+   while ( ( j < cNumPoints ) && !inSlab( pointsData.cartesianX[j] ) )
+   {
+      ++j;
+   }
+
+   EXPECT_EQ( j, cNumPoints );
+   EXPECT_GT( cNumFilteredRead, 0U );
+   EXPECT_LT( cNumFilteredRead, cNumPoints );
+
+   delete reader;
+}
+
+TEST( SimpleReaderData, BunnyInt32ApplyPose )
+{
+   e57::Reader *reader = nullptr;
+
+   E57_ASSERT_NO_THROW( reader =
+                           new e57::Reader( TestData::Path() + "/reference/bunnyInt32.e57", {} ) );
+
+   e57::Data3D data3DHeader;
+   ASSERT_TRUE( reader->ReadData3D( 0, data3DHeader ) );
+
+   const uint64_t cNumPoints = data3DHeader.pointCount;
+
+   // Read the points in the scan's own coordinate system
+   e57::Data3DPointsDouble pointsData( data3DHeader );
+
+   auto vectorReader = reader->SetUpData3DPointsData( 0, cNumPoints, pointsData );
+
+   const uint64_t cNumRead = vectorReader.read();
+
+   vectorReader.close();
+
+   ASSERT_EQ( cNumRead, cNumPoints );
+
+   delete reader;
+
+   // Read them again with a pose applied by the reader
+   e57::CompressedVectorReaderOptions readOptions;
+   readOptions.transformCartesian = true;
+
+   // 90 degrees about the z axis, then translate
+   readOptions.cartesianRotation[0] = std::sqrt( 0.5 );
+   readOptions.cartesianRotation[3] = std::sqrt( 0.5 );
+   readOptions.cartesianTranslation[0] = 10.0;
+   readOptions.cartesianTranslation[1] = 20.0;
+   readOptions.cartesianTranslation[2] = 30.0;
+
+   E57_ASSERT_NO_THROW( reader =
+                           new e57::Reader( TestData::Path() + "/reference/bunnyInt32.e57", {} ) );
+
+   e57::Data3DPointsDouble worldData( data3DHeader );
+
+   auto worldReader = reader->SetUpData3DPointsData( 0, cNumPoints, worldData, readOptions );
+
+   ASSERT_EQ( worldReader.read(), cNumPoints );
+
+   worldReader.close();
+
+   for ( uint64_t i = 0; i < cNumPoints; ++i )
+   {
+      EXPECT_NEAR( worldData.cartesianX[i], 10.0 - pointsData.cartesianY[i], 1e-9 );
+      EXPECT_NEAR( worldData.cartesianY[i], 20.0 + pointsData.cartesianX[i], 1e-9 );
+      EXPECT_NEAR( worldData.cartesianZ[i], 30.0 + pointsData.cartesianZ[i], 1e-9 );
+   }
+
+   delete reader;
+
+   // With ReaderOptions::applyPose, the file's own pose is applied
+   e57::ReaderOptions options;
+   options.applyPose = true;
+
+   E57_ASSERT_NO_THROW(
+      reader = new e57::Reader( TestData::Path() + "/reference/bunnyInt32.e57", options ) );
+
+   e57::Data3DPointsDouble posedData( data3DHeader );
+
+   auto posedReader = reader->SetUpData3DPointsData( 0, cNumPoints, posedData );
+
+   ASSERT_EQ( posedReader.read(), cNumPoints );
+
+   posedReader.close();
+
+   // Rotate by the quaternion directly: v' = v + 2w(q x v) + 2q x (q x v), then translate
+   const e57::Quaternion &q = data3DHeader.pose.rotation;
+   const e57::Translation &t = data3DHeader.pose.translation;
+
+   for ( uint64_t i = 0; i < cNumPoints; ++i )
+   {
+      const double vx = pointsData.cartesianX[i];
+      const double vy = pointsData.cartesianY[i];
+      const double vz = pointsData.cartesianZ[i];
+
+      const double cx = q.y * vz - q.z * vy;
+      const double cy = q.z * vx - q.x * vz;
+      const double cz = q.x * vy - q.y * vx;
+
+      const double ccx = q.y * cz - q.z * cy;
+      const double ccy = q.z * cx - q.x * cz;
+      const double ccz = q.x * cy - q.y * cx;
+
+      EXPECT_NEAR( posedData.cartesianX[i], vx + 2.0 * ( q.w * cx + ccx ) + t.x, 1e-6 );
+      EXPECT_NEAR( posedData.cartesianY[i], vy + 2.0 * ( q.w * cy + ccy ) + t.y, 1e-6 );
+      EXPECT_NEAR( posedData.cartesianZ[i], vz + 2.0 * ( q.w * cz + ccz ) + t.z, 1e-6 );
+   }
+
+   delete reader;
+}
+
+TEST( SimpleReader, SphericalToCartesian )
+{
+   constexpr int64_t cNumPoints = 2000;
+
+   // Write some spherical points
+   {
+      e57::WriterOptions options;
+      options.guid = "Spherical To Cartesian File GUID";
+
+      e57::Writer *writer = nullptr;
+
+      E57_ASSERT_NO_THROW( writer = new e57::Writer( "./SphericalToCartesian.e57", options ) );
+
+      e57::Data3D header;
+      header.guid = "Spherical To Cartesian Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.sphericalRangeField = true;
+      header.pointFields.sphericalAzimuthField = true;
+      header.pointFields.sphericalElevationField = true;
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.sphericalRange[i] = 1.0 + ( i % 100 ) * 0.5;
+         pointsData.sphericalAzimuth[i] = ( i % 628 ) * 0.01 - 3.14;
+         pointsData.sphericalElevation[i] = ( i % 300 ) * 0.01 - 1.5;
+      }
+
+      E57_ASSERT_NO_THROW( writer->WriteData3DData( header, pointsData ) );
+
+      delete writer;
+   }
+
+   e57::Reader *reader = nullptr;
+
+   E57_ASSERT_NO_THROW( reader = new e57::Reader( "./SphericalToCartesian.e57", {} ) );
+
+   e57::Data3D data3DHeader;
+   ASSERT_TRUE( reader->ReadData3D( 0, data3DHeader ) );
+
+   ASSERT_FALSE( data3DHeader.pointFields.cartesianXField );
+   ASSERT_EQ( data3DHeader.pointCount, cNumPoints );
+
+   // Allocate cartesian buffers to convert into
+   e57::Data3DPointsDouble pointsData( data3DHeader, true );
+
+   ASSERT_TRUE( pointsData.convertSphericalToCartesian );
+   ASSERT_NE( pointsData.cartesianX, nullptr );
+   ASSERT_NE( pointsData.cartesianY, nullptr );
+   ASSERT_NE( pointsData.cartesianZ, nullptr );
+
+   auto vectorReader = reader->SetUpData3DPointsData( 0, cNumPoints, pointsData );
+
+   ASSERT_EQ( vectorReader.read(), static_cast<unsigned>( cNumPoints ) );
+
+   vectorReader.close();
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      const double range = pointsData.sphericalRange[i];
+      const double azimuth = pointsData.sphericalAzimuth[i];
+      const double elevation = pointsData.sphericalElevation[i];
+
+      EXPECT_NEAR( pointsData.cartesianX[i], range * std::cos( elevation ) * std::cos( azimuth ),
+                   1e-9 );
+      EXPECT_NEAR( pointsData.cartesianY[i], range * std::cos( elevation ) * std::sin( azimuth ),
+                   1e-9 );
+      EXPECT_NEAR( pointsData.cartesianZ[i], range * std::sin( elevation ), 1e-9 );
+   }
+
+   // Without cartesian buffers there is nothing to convert into
+   e57::Data3DPointsDouble noCartesianData( data3DHeader );
+   noCartesianData.convertSphericalToCartesian = true;
+
+   E57_ASSERT_THROW( reader->SetUpData3DPointsData( 0, cNumPoints, noCartesianData ) );
+
+   delete reader;
+}
+
+TEST( SimpleReader, SphericalToCartesianWithCartesianData )
+{
+   constexpr int64_t cNumPoints = 10;
+
+   // Write some cartesian points
+   {
+      e57::WriterOptions options;
+      options.guid = "Spherical To Cartesian With Cartesian File GUID";
+
+      e57::Writer *writer = nullptr;
+
+      E57_ASSERT_NO_THROW(
+         writer = new e57::Writer( "./SphericalToCartesianWithCartesian.e57", options ) );
+
+      e57::Data3D header;
+      header.guid = "Spherical To Cartesian With Cartesian Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<double>( i );
+         pointsData.cartesianY[i] = static_cast<double>( i );
+         pointsData.cartesianZ[i] = static_cast<double>( i );
+      }
+
+      E57_ASSERT_NO_THROW( writer->WriteData3DData( header, pointsData ) );
+
+      delete writer;
+   }
+
+   e57::Reader *reader = nullptr;
+
+   E57_ASSERT_NO_THROW(
+      reader = new e57::Reader( "./SphericalToCartesianWithCartesian.e57", {} ) );
+
+   e57::Data3D data3DHeader;
+   ASSERT_TRUE( reader->ReadData3D( 0, data3DHeader ) );
+
+   // The data already has cartesian coordinates, so converting is an error
+   e57::Data3DPointsDouble pointsData( data3DHeader, true );
+
+   E57_ASSERT_THROW( reader->SetUpData3DPointsData( 0, cNumPoints, pointsData ) );
+
+   delete reader;
+}
+
 TEST( SimpleReaderData, ColourRepresentation )
 {
    e57::Reader *reader = nullptr;
@@ -3,9 +3,11 @@
 
 #include <array>
 #include <fstream>
+#include <limits>
 
 #include "gtest/gtest.h"
 
+#include "E57SimpleReader.h"
 #include "E57SimpleWriter.h"
 
 #include "Helpers.h"
@@ -665,6 +667,505 @@ TEST( SimpleWriter, MinMaxIssuesSphericalDouble )
    EXPECT_NE( header.intensityLimits.intensityMaximum, 0.0 );
 }
 
+TEST( SimpleWriter, QuantizedPrecision )
+{
+   constexpr int64_t cNumPoints = 10000;
+   constexpr double cPrecision = 0.001;
+
+   auto xValue = []( int64_t i ) { return 100.0 + i * 0.0123456; };
+   auto timeValue = []( int64_t i ) { return 1.4e9 + i * 1e-3; };
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Quantized Precision File GUID";
+      options.pointRangePrecision = cPrecision;
+      options.timePrecision = 1e-6;
+
+      e57::Writer writer( "./QuantizedPrecision.e57", options );
+
+      e57::Data3D header;
+      header.guid = "Quantized Precision Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+      header.pointFields.timeStampField = true;
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = xValue( i );
+         pointsData.cartesianY[i] = -5.0 + ( i % 77 ) * 0.1;
+         pointsData.cartesianZ[i] = 3.3;
+         pointsData.timeStamp[i] = timeValue( i );
+      }
+
+      const int64_t scanIndex = writer.WriteData3DData( header, pointsData );
+
+      EXPECT_EQ( header.pointFields.pointRangeNodeType, e57::NumericalNodeType::ScaledInteger );
+      EXPECT_EQ( header.pointFields.timeNodeType, e57::NumericalNodeType::ScaledInteger );
+
+      const e57::StructureNode scan( writer.GetRawData3D().get( scanIndex ) );
+      const e57::CompressedVectorNode points( scan.get( "points" ) );
+      const e57::StructureNode proto( points.prototype() );
+
+      const e57::ScaledIntegerNode x( proto.get( "cartesianX" ) );
+      EXPECT_EQ( x.scale(), cPrecision );
+      EXPECT_EQ( x.minimum(), -5000 );
+      EXPECT_EQ( x.maximum(), 223444 );
+   }
+
+   e57::ImageFile imf( "./QuantizedPrecision.e57", "r" );
+   const e57::VectorNode data3D( imf.root().get( "data3D" ) );
+   const e57::StructureNode scan( data3D.get( 0 ) );
+   e57::CompressedVectorNode points( scan.get( "points" ) );
+
+   std::vector<double> x( cNumPoints );
+   std::vector<double> time( cNumPoints );
+
+   std::vector<e57::SourceDestBuffer> dbufs;
+   dbufs.emplace_back( imf, "cartesianX", x.data(), cNumPoints, true, true );
+   dbufs.emplace_back( imf, "timeStamp", time.data(), cNumPoints, true, true );
+
+   e57::CompressedVectorReader reader = points.reader( dbufs );
+   EXPECT_EQ( reader.read(), cNumPoints );
+   reader.close();
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      ASSERT_NEAR( x[i], xValue( i ), cPrecision / 2 );
+      ASSERT_NEAR( time[i], timeValue( i ), 1e-6 );
+   }
+
+   imf.close();
+}
+
+TEST( SimpleWriter, QuantizedIntensityLimits )
+{
+   constexpr int64_t cNumPoints = 1000;
+   constexpr double cPrecision = 0.01;
+
+   auto intensityValue = []( int64_t i ) { return 10.0 + ( i % 400 ) * 0.1; };
+
+   e57::WriterOptions options;
+   options.guid = "Quantized Intensity Limits File GUID";
+   options.intensityPrecision = cPrecision;
+
+   e57::Writer writer( "./QuantizedIntensityLimits.e57", options );
+
+   const auto writeScan = [&]( const e57::IntensityLimits &inLimits ) {
+      e57::Data3D header;
+      header.guid = "Quantized Intensity Limits Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+      header.pointFields.intensityField = true;
+      header.intensityLimits = inLimits;
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<double>( i );
+         pointsData.cartesianY[i] = 0.0;
+         pointsData.cartesianZ[i] = 0.0;
+         pointsData.intensity[i] = intensityValue( i );
+      }
+
+      writer.WriteData3DData( header, pointsData );
+
+      return header;
+   };
+
+   // The data (10 to 49.9) is within the limits, which are kept
+   {
+      const e57::Data3D header = writeScan( { 0.0, 100.0 } );
+
+      EXPECT_EQ( header.pointFields.intensityNodeType, e57::NumericalNodeType::ScaledInteger );
+      EXPECT_EQ( header.intensityLimits.intensityMinimum, 0.0 );
+      EXPECT_EQ( header.intensityLimits.intensityMaximum, 100.0 );
+
+      const e57::StructureNode scan( writer.GetRawData3D().get( 0 ) );
+      const e57::CompressedVectorNode points( scan.get( "points" ) );
+      const e57::ScaledIntegerNode intensity(
+         e57::StructureNode( points.prototype() ).get( "intensity" ) );
+
+      EXPECT_EQ( intensity.scale(), cPrecision );
+      EXPECT_EQ( intensity.minimum(), 0 );
+      EXPECT_EQ( intensity.maximum(), 10000 );
+   }
+
+   // The data is outside the limits, so it isn't quantised and the limits are still kept
+   {
+      const e57::Data3D header = writeScan( { 0.0, 20.0 } );
+
+      EXPECT_EQ( header.pointFields.intensityNodeType, e57::NumericalNodeType::Float );
+      EXPECT_EQ( header.intensityLimits.intensityMinimum, 0.0 );
+      EXPECT_EQ( header.intensityLimits.intensityMaximum, 20.0 );
+   }
+
+   // No limits, so they come from the data
+   {
+      const e57::Data3D header = writeScan( {} );
+
+      EXPECT_EQ( header.pointFields.intensityNodeType, e57::NumericalNodeType::ScaledInteger );
+      EXPECT_EQ( header.intensityLimits.intensityMinimum, 10.0 );
+      EXPECT_NEAR( header.intensityLimits.intensityMaximum, 49.9, 1.0e-9 );
+   }
+
+   writer.Close();
+
+   e57::Reader reader( "./QuantizedIntensityLimits.e57", {} );
+
+   for ( int64_t scanIndex = 0; scanIndex < 3; ++scanIndex )
+   {
+      e57::Data3D header;
+      ASSERT_TRUE( reader.ReadData3D( scanIndex, header ) );
+
+      e57::Data3DPointsDouble pointsData( header );
+      auto vectorReader = reader.SetUpData3DPointsData( scanIndex, cNumPoints, pointsData );
+      ASSERT_EQ( vectorReader.read(), cNumPoints );
+      vectorReader.close();
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         ASSERT_NEAR( pointsData.intensity[i], intensityValue( i ), cPrecision / 2 );
+      }
+   }
+}
+
+TEST( SimpleWriter, CollectStatistics )
+{
+   constexpr int64_t cNumPointsPerWrite = 5000;
+   constexpr int64_t cNumWrites = 3;
+
+   e57::IndexBounds indexBounds;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Collect Statistics File GUID";
+      options.collectStatistics = true;
+
+      e57::Writer writer( "./CollectStatistics.e57", options );
+
+      e57::Data3D header;
+      header.guid = "Collect Statistics Header GUID";
+      header.pointCount = cNumPointsPerWrite * cNumWrites;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+      header.pointFields.intensityField = true;
+      header.pointFields.colorRedField = true;
+      header.pointFields.colorGreenField = true;
+      header.pointFields.colorBlueField = true;
+      header.pointFields.rowIndexField = true;
+      header.pointFields.rowIndexMaximum = 1000;
+
+      // Set up front, so it is kept
+      indexBounds.rowMaximum = 1000;
+      header.indexBounds = indexBounds;
+
+      const int64_t scanIndex = writer.NewData3D( header );
+
+      // Only one write's worth of points in memory at a time
+      header.pointCount = cNumPointsPerWrite;
+      e57::Data3DPointsFloat pointsData( header );
+
+      e57::CompressedVectorWriter vectorWriter =
+         writer.SetUpData3DPointsData( scanIndex, cNumPointsPerWrite, pointsData );
+
+      for ( int64_t write = 0; write < cNumWrites; ++write )
+      {
+         for ( int64_t i = 0; i < cNumPointsPerWrite; ++i )
+         {
+            const int64_t point = write * cNumPointsPerWrite + i;
+
+            pointsData.cartesianX[i] = point * 0.25f;
+            pointsData.cartesianY[i] = -point * 0.5f;
+            pointsData.cartesianZ[i] = 1.5f;
+            pointsData.intensity[i] = 0.25f + ( point % 3 ) * 0.25f;
+            pointsData.colorRed[i] = static_cast<uint16_t>( 10 + point % 200 );
+            pointsData.colorGreen[i] = 300;
+            pointsData.colorBlue[i] = static_cast<uint16_t>( point % 7 );
+            pointsData.rowIndex[i] = static_cast<int32_t>( point % 999 );
+         }
+
+         vectorWriter.write( cNumPointsPerWrite );
+      }
+
+      vectorWriter.close();
+   }
+
+   constexpr double cLastPoint = cNumPointsPerWrite * cNumWrites - 1;
+
+   e57::Reader reader( "./CollectStatistics.e57", {} );
+
+   e57::Data3D header;
+   ASSERT_TRUE( reader.ReadData3D( 0, header ) );
+
+   EXPECT_EQ( header.cartesianBounds.xMinimum, 0.0 );
+   EXPECT_EQ( header.cartesianBounds.xMaximum, cLastPoint * 0.25 );
+   EXPECT_EQ( header.cartesianBounds.yMinimum, -cLastPoint * 0.5 );
+   EXPECT_EQ( header.cartesianBounds.yMaximum, 0.0 );
+   EXPECT_EQ( header.cartesianBounds.zMinimum, 1.5 );
+   EXPECT_EQ( header.cartesianBounds.zMaximum, 1.5 );
+
+   EXPECT_EQ( header.intensityLimits.intensityMinimum, 0.25 );
+   EXPECT_EQ( header.intensityLimits.intensityMaximum, 0.75 );
+
+   EXPECT_EQ( header.colorLimits.colorRedMinimum, 10.0 );
+   EXPECT_EQ( header.colorLimits.colorRedMaximum, 209.0 );
+   EXPECT_EQ( header.colorLimits.colorGreenMinimum, 300.0 );
+   EXPECT_EQ( header.colorLimits.colorGreenMaximum, 300.0 );
+   EXPECT_EQ( header.colorLimits.colorBlueMinimum, 0.0 );
+   EXPECT_EQ( header.colorLimits.colorBlueMaximum, 6.0 );
+
+   EXPECT_EQ( header.indexBounds, indexBounds );
+}
+
+TEST( SimpleWriter, CollectStatisticsWriterOutOfScope )
+{
+   constexpr int64_t cNumPoints = 1000;
+   constexpr int cNumScans = 2;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Collect Statistics Writer Out Of Scope File GUID";
+      options.collectStatistics = true;
+
+      e57::Writer writer( "./CollectStatisticsWriterOutOfScope.e57", options );
+
+      // Each scan's writer closes as it goes out of scope, so the next one can be created
+      for ( int scan = 0; scan < cNumScans; ++scan )
+      {
+         e57::Data3D header;
+         header.guid = "Collect Statistics Writer Out Of Scope Header GUID";
+         header.pointCount = cNumPoints;
+         header.pointFields.cartesianXField = true;
+         header.pointFields.cartesianYField = true;
+         header.pointFields.cartesianZField = true;
+
+         const int64_t scanIndex = writer.NewData3D( header );
+
+         e57::Data3DPointsDouble pointsData( header );
+
+         for ( int64_t i = 0; i < cNumPoints; ++i )
+         {
+            pointsData.cartesianX[i] = scan + i * 0.5;
+            pointsData.cartesianY[i] = -i * 0.25;
+            pointsData.cartesianZ[i] = 2.0 * scan;
+         }
+
+         e57::CompressedVectorWriter vectorWriter =
+            writer.SetUpData3DPointsData( scanIndex, cNumPoints, pointsData );
+
+         E57_ASSERT_NO_THROW( vectorWriter.write( cNumPoints ) );
+      }
+   }
+
+   e57::Reader reader( "./CollectStatisticsWriterOutOfScope.e57", {} );
+
+   ASSERT_EQ( reader.GetData3DCount(), cNumScans );
+
+   for ( int scan = 0; scan < cNumScans; ++scan )
+   {
+      e57::Data3D header;
+      ASSERT_TRUE( reader.ReadData3D( scan, header ) );
+
+      ASSERT_EQ( header.pointCount, static_cast<int64_t>( cNumPoints ) );
+
+      EXPECT_EQ( header.cartesianBounds.xMinimum, scan );
+      EXPECT_EQ( header.cartesianBounds.xMaximum, scan + ( cNumPoints - 1 ) * 0.5 );
+      EXPECT_EQ( header.cartesianBounds.yMinimum, -( cNumPoints - 1 ) * 0.25 );
+      EXPECT_EQ( header.cartesianBounds.yMaximum, 0.0 );
+      EXPECT_EQ( header.cartesianBounds.zMinimum, 2.0 * scan );
+      EXPECT_EQ( header.cartesianBounds.zMaximum, 2.0 * scan );
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      auto vectorReader = reader.SetUpData3DPointsData( scan, cNumPoints, pointsData );
+
+      ASSERT_EQ( vectorReader.read(), static_cast<unsigned>( cNumPoints ) );
+
+      vectorReader.close();
+
+      EXPECT_EQ( pointsData.cartesianX[cNumPoints - 1], scan + ( cNumPoints - 1 ) * 0.5 );
+   }
+}
+
+TEST( SimpleWriter, DetectConstantFields )
+{
+   constexpr int64_t cNumPoints = 10000;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Detect Constant Fields File GUID";
+      options.detectConstantFields = true;
+
+      e57::Writer writer( "./DetectConstantFields.e57", options );
+
+      e57::Data3D header;
+      header.guid = "Detect Constant Fields Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+      header.pointFields.colorRedField = true;
+      header.pointFields.colorGreenField = true;
+      header.pointFields.colorBlueField = true;
+      header.pointFields.returnCountField = true;
+      header.pointFields.returnMaximum = 255;
+
+      header.colorLimits.colorRedMaximum = 255;
+      header.colorLimits.colorGreenMaximum = 255;
+      header.colorLimits.colorBlueMaximum = 255;
+
+      e57::Data3DPointsFloat pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<float>( i );
+         pointsData.cartesianY[i] = 1.0f;
+         pointsData.cartesianZ[i] = 2.0f;
+         pointsData.colorRed[i] = 200;
+         pointsData.colorGreen[i] = static_cast<uint16_t>( i % 256 );
+         pointsData.colorBlue[i] = 0;
+         pointsData.returnCount[i] = 1;
+      }
+
+      const int64_t scanIndex = writer.WriteData3DData( header, pointsData );
+
+      const e57::StructureNode scan( writer.GetRawData3D().get( scanIndex ) );
+      const e57::CompressedVectorNode points( scan.get( "points" ) );
+      const e57::StructureNode proto( points.prototype() );
+
+      const e57::IntegerNode colorRed( proto.get( "colorRed" ) );
+      EXPECT_EQ( colorRed.minimum(), 200 );
+      EXPECT_EQ( colorRed.maximum(), 200 );
+
+      const e57::IntegerNode colorGreen( proto.get( "colorGreen" ) );
+      EXPECT_EQ( colorGreen.minimum(), 0 );
+      EXPECT_EQ( colorGreen.maximum(), 255 );
+
+      const e57::IntegerNode returnCount( proto.get( "returnCount" ) );
+      EXPECT_EQ( returnCount.minimum(), 1 );
+      EXPECT_EQ( returnCount.maximum(), 1 );
+   }
+
+   e57::Reader reader( "./DetectConstantFields.e57", {} );
+
+   e57::Data3D header;
+   ASSERT_TRUE( reader.ReadData3D( 0, header ) );
+
+   // The limits given in the header are kept
+   EXPECT_EQ( header.colorLimits.colorRedMaximum, 255.0 );
+
+   e57::Data3DPointsFloat pointsData( header );
+
+   auto vectorReader = reader.SetUpData3DPointsData( 0, cNumPoints, pointsData );
+   EXPECT_EQ( vectorReader.read(), cNumPoints );
+   vectorReader.close();
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      ASSERT_EQ( pointsData.colorRed[i], 200 );
+      ASSERT_EQ( pointsData.colorGreen[i], i % 256 );
+      ASSERT_EQ( pointsData.colorBlue[i], 0 );
+      ASSERT_EQ( pointsData.returnCount[i], 1 );
+   }
+}
+
+TEST( SimpleWriter, DeltaCodec )
+{
+   constexpr int64_t cNumRows = 200;
+   constexpr int64_t cNumColumns = 50;
+   constexpr int64_t cNumPoints = cNumRows * cNumColumns;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Delta Codec File GUID";
+      options.timePrecision = 1.0e-6;
+      options.deltaCodec = true;
+
+      e57::Writer writer( "./DeltaCodec.e57", options );
+
+      e57::Data3D header;
+      header.guid = "Delta Codec Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+      header.pointFields.rowIndexField = true;
+      header.pointFields.rowIndexMaximum = cNumRows - 1;
+      header.pointFields.columnIndexField = true;
+      header.pointFields.columnIndexMaximum = cNumColumns - 1;
+      header.pointFields.timeStampField = true;
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      // Column by column, the way a scanner sweeps
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<double>( i % cNumRows );
+         pointsData.cartesianY[i] = static_cast<double>( i / cNumRows );
+         pointsData.cartesianZ[i] = 1.0;
+         pointsData.rowIndex[i] = static_cast<int32_t>( i % cNumRows );
+         pointsData.columnIndex[i] = static_cast<int32_t>( i / cNumRows );
+         pointsData.timeStamp[i] = 10.0 + static_cast<double>( i ) * 1.0e-4;
+      }
+
+      const int64_t scanIndex = writer.WriteData3DData( header, pointsData );
+
+      e57::ImageFile imf( writer.GetRawIMF() );
+      e57::ustring prefix;
+      ASSERT_TRUE( imf.extensionsLookupUri( e57::DELTA_CODEC_URI, prefix ) );
+
+      const e57::StructureNode scan( writer.GetRawData3D().get( scanIndex ) );
+      const e57::CompressedVectorNode points( scan.get( "points" ) );
+      const e57::VectorNode codecs( points.codecs() );
+      ASSERT_EQ( codecs.childCount(), 1 );
+
+      const e57::StructureNode codec( codecs.get( 0 ) );
+      EXPECT_TRUE( codec.isDefined( prefix + ":deltaCodec" ) );
+
+      // Cartesian coordinates are floats, so they are left to bitPackCodec
+      const e57::VectorNode inputs( codec.get( "inputs" ) );
+      ASSERT_EQ( inputs.childCount(), 3 );
+      EXPECT_EQ( e57::StringNode( inputs.get( 0 ) ).value(), "rowIndex" );
+      EXPECT_EQ( e57::StringNode( inputs.get( 1 ) ).value(), "columnIndex" );
+      EXPECT_EQ( e57::StringNode( inputs.get( 2 ) ).value(), "timeStamp" );
+   }
+
+   e57::Reader reader( "./DeltaCodec.e57", {} );
+
+   e57::Data3D header;
+   ASSERT_TRUE( reader.ReadData3D( 0, header ) );
+
+   // Read back in pieces, so blocks are split between reads
+   constexpr int64_t cBufferSize = 999;
+   e57::Data3DPointsDouble pointsData( header );
+
+   auto vectorReader = reader.SetUpData3DPointsData( 0, cBufferSize, pointsData );
+
+   int64_t pointIndex = 0;
+   while ( const unsigned readCount = vectorReader.read() )
+   {
+      for ( unsigned i = 0; i < readCount; ++i, ++pointIndex )
+      {
+         ASSERT_EQ( pointsData.rowIndex[i], pointIndex % cNumRows );
+         ASSERT_EQ( pointsData.columnIndex[i], pointIndex / cNumRows );
+         ASSERT_NEAR( pointsData.timeStamp[i], 10.0 + static_cast<double>( pointIndex ) * 1.0e-4,
+                      1.0e-6 );
+         ASSERT_EQ( pointsData.cartesianX[i], static_cast<double>( pointIndex % cNumRows ) );
+      }
+   }
+   vectorReader.close();
+
+   EXPECT_EQ( pointIndex, cNumPoints );
+}
+
 TEST( SimpleWriterData, VisualRefImage )
 {
    e57::WriterOptions options;